@@ -0,0 +1,42 @@
+#include <chrono>
+#include <iostream>
+
+#include <kirho/arena.hpp>
+
+struct point_t
+{
+    double x;
+    double y;
+};
+
+constexpr auto count = 10000000;
+
+// How long making a small object takes, with the arena reset every thousand
+// of them, the way a loop that handles one request at a time would use it.
+auto main() -> int
+{
+    auto arena = kirho::arena_t{1 << 16};
+
+    auto sum = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < count; i++)
+    {
+        if (i % 1000 == 0)
+        {
+            arena.reset();
+        }
+        sum += arena.make<point_t>(1.0, 2.0)->y;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (sum != 2.0 * count)
+    {
+        std::cerr << "some of the points came out wrong\n";
+        return 1;
+    }
+
+    std::cout << "arena: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     count
+              << "ns per allocation\n";
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <kirho/arithmetic.hpp>
+
+// Sums up a big array of amounts with checked_sum, against checking one
+// addition at a time.
+auto main() -> int
+{
+    auto random = std::mt19937_64{42};
+    auto amounts = std::vector<std::int64_t>(16 << 20);
+    for (auto& amount : amounts)
+    {
+        amount = static_cast<std::int64_t>(random() % 100000) - 50000;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const auto total = kirho::checked_sum<std::int64_t>(amounts).unwrap();
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start
+    )
+                       .count();
+    std::cout << "summed " << amounts.size() << " numbers at "
+              << static_cast<double>(amounts.size()) / seconds / 1e6
+              << " M/s\n";
+
+    start = std::chrono::steady_clock::now();
+    auto one_at_a_time = std::int64_t{0};
+    for (const auto amount : amounts)
+    {
+        one_at_a_time = kirho::checked_add(one_at_a_time, amount).unwrap();
+    }
+    seconds = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start
+    )
+                  .count();
+    std::cout << "one at a time at "
+              << static_cast<double>(amounts.size()) / seconds / 1e6
+              << " M/s\n";
+
+    if (total != one_at_a_time)
+    {
+        std::cerr << "the two ways of summing disagree\n";
+        return 1;
+    }
+}
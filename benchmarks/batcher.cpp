@@ -0,0 +1,62 @@
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <kirho/batcher.hpp>
+
+using namespace std::chrono_literals;
+using batcher_t = kirho::batcher_t<int, int, std::string>;
+using result_t = batcher_t::result;
+
+constexpr auto iterations = 200000;
+
+auto square(std::span<const int> items) -> std::vector<result_t>
+{
+    auto results = std::vector<result_t>{};
+    results.reserve(items.size());
+    for (const auto item : items)
+    {
+        results.push_back(result_t::success(item * item));
+    }
+
+    return results;
+}
+
+// Submits a lot of items from one thread and waits for all of them, with
+// batches that fill up before their delay runs out.
+auto main() -> int
+{
+    auto options = kirho::batcher_options_t{};
+    options.max_size = 256;
+    options.max_delay = 5ms;
+    auto batcher = batcher_t{square, options};
+
+    auto futures = std::vector<std::future<result_t>>{};
+    futures.reserve(iterations);
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; i++)
+    {
+        futures.push_back(batcher.submit(i % 1000));
+    }
+    auto sum = 0l;
+    for (auto& future : futures)
+    {
+        sum += future.get().unwrap();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (sum != 332833500l * (iterations / 1000))
+    {
+        std::cerr << "some of the items came back wrong\n";
+        return 1;
+    }
+
+    std::cout << "submitting and waiting took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns per item, in " << batcher.batch_count()
+              << " batches\n";
+}
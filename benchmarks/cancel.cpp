@@ -0,0 +1,33 @@
+#include <chrono>
+#include <iostream>
+
+#include <kirho/cancel.hpp>
+
+constexpr auto iterations = 100000000;
+
+// How much checking a token that hasn't been stopped costs, which is what
+// long-running loops do over and over.
+auto main() -> int
+{
+    auto source = kirho::stop_source_t{};
+    const auto token = source.token();
+
+    auto checks = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; i++)
+    {
+        checks += token.stop_requested() ? 0 : 1;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (checks != iterations)
+    {
+        std::cerr << "the token stopped without being asked to\n";
+        return 1;
+    }
+
+    std::cout << "checking a token took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns\n";
+}
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <kirho/circuit_breaker.hpp>
+
+using namespace std::chrono_literals;
+using result_t = kirho::result_t<int, std::string>;
+
+constexpr auto iterations = 1000000;
+
+// The overhead of a call with the circuit closed, and of failing fast with it
+// open.
+auto main() -> int
+{
+    auto options = kirho::circuit_breaker_options_t{};
+    options.minimum_calls = 10;
+    options.failure_ratio = 0.5;
+    options.window = 1s;
+    options.open_duration = 1h;
+
+    auto closed = kirho::circuit_breaker_t{options};
+    auto sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; i++)
+    {
+        sum += closed.call([i]() { return result_t::success(i & 1); })
+                   .unwrap()
+                   .unwrap();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (sum != iterations / 2)
+    {
+        std::cerr << "some of the calls came back wrong\n";
+        return 1;
+    }
+
+    std::cout << "call took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns with the circuit closed\n";
+
+    const auto failing = []() { return result_t::error("down"); };
+    auto open = kirho::circuit_breaker_t{options};
+    for (auto i = 0; i < 10; i++)
+    {
+        open.call(failing).unwrap();
+    }
+
+    auto rejected = 0;
+    auto error = kirho::circuit_open_t{};
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; i++)
+    {
+        rejected += open.call(failing).is_error(error) ? 1 : 0;
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    if (rejected != iterations)
+    {
+        std::cerr << "the circuit let " << iterations - rejected
+                  << " calls through while it was open\n";
+        return 1;
+    }
+
+    std::cout << "call took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns with the circuit open\n";
+}
@@ -0,0 +1,43 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include <kirho/csv.hpp>
+
+// Reads a big file made of the same typical row over and over.
+auto main() -> int
+{
+    const auto line = std::string{
+        "1234567,\"Smith, John\",john@example.com,42.50,2024-01-15\n"
+    };
+    auto big = std::string{};
+    while (big.size() < (32 << 20))
+    {
+        big += line;
+    }
+
+    auto reader = kirho::csv_reader_t{big};
+    auto fields = std::size_t{0};
+    const auto start = std::chrono::steady_clock::now();
+    for (;;)
+    {
+        const auto row = reader.read_row().unwrap();
+        if (row.empty())
+        {
+            break;
+        }
+        fields += row.size();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+
+    if (fields != big.size() / line.size() * 5)
+    {
+        std::cerr << "read the wrong number of fields: " << fields << '\n';
+        return 1;
+    }
+
+    std::cout << "read " << fields << " fields at "
+              << static_cast<double>(big.size()) / seconds / 1e6 << " MB/s\n";
+}
@@ -0,0 +1,48 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <kirho/encoding.hpp>
+
+// Encodes a big block of random data and decodes it back, in both encodings.
+auto main() -> int
+{
+    auto data = std::vector<std::byte>(64 << 20);
+    auto random = std::mt19937{7};
+    for (auto& byte : data)
+    {
+        byte = static_cast<std::byte>(random());
+    }
+    const auto original = data;
+
+    auto text = std::string(kirho::base64::encoded_size(data.size()), '\0');
+    auto start = std::chrono::steady_clock::now();
+    kirho::base64::encode(data, text);
+    kirho::base64::decode(text, data).unwrap();
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start
+    )
+                       .count();
+    std::cout << "base64 round trip at "
+              << static_cast<double>(data.size()) / seconds / 1e6 << " MB/s\n";
+
+    text.resize(kirho::hex::encoded_size(data.size()));
+    start = std::chrono::steady_clock::now();
+    kirho::hex::encode(data, text);
+    kirho::hex::decode(text, data).unwrap();
+    seconds = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start
+    )
+                  .count();
+    std::cout << "hex round trip at "
+              << static_cast<double>(data.size()) / seconds / 1e6 << " MB/s\n";
+
+    if (data != original)
+    {
+        std::cerr << "the data didn't survive the round trips\n";
+        return 1;
+    }
+}
@@ -0,0 +1,97 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include <sys/socket.h>
+
+#include <kirho/event_loop.hpp>
+
+using kirho::detached_task_t;
+using kirho::event_loop_t;
+namespace sys = kirho::sys;
+
+constexpr auto round_trips = 100000;
+constexpr auto message_size = std::size_t{64};
+
+auto echo_server(event_loop_t& loop, sys::fd_t socket) -> detached_task_t
+{
+    auto buffer = std::array<std::byte, 256>{};
+    while (true)
+    {
+        const auto count = (co_await loop.async_read(socket, buffer))
+                               .except("echo server failed to read");
+        if (count == 0)
+        {
+            break;
+        }
+
+        auto written = std::size_t{0};
+        while (written < count)
+        {
+            written += (co_await loop.async_write(
+                            socket,
+                            std::span{buffer}.subspan(written, count - written)
+                        ))
+                           .except("echo server failed to write");
+        }
+    }
+}
+
+// Sends a message and waits for it to come back, over and over, and closes
+// the socket when it's done, which stops the server.
+auto echo_client(event_loop_t& loop, sys::fd_t socket, int& completed)
+    -> detached_task_t
+{
+    auto message = std::array<std::byte, message_size>{};
+    std::memset(message.data(), 'k', message.size());
+
+    for (auto i = 0; i < round_trips; i++)
+    {
+        (co_await loop.async_write(socket, message)).unwrap();
+
+        auto reply = std::array<std::byte, message_size>{};
+        auto received = std::size_t{0};
+        while (received < reply.size())
+        {
+            received += (co_await loop.async_read(
+                             socket, std::span{reply}.subspan(received)
+                         ))
+                            .unwrap();
+        }
+
+        completed += reply == message ? 1 : 0;
+    }
+}
+
+auto main() -> int
+{
+    auto loop = event_loop_t::create().except("failed to create the loop");
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) != 0)
+    {
+        std::cerr << "failed to create the sockets\n";
+        return 1;
+    }
+
+    auto completed = 0;
+    const auto start = std::chrono::steady_clock::now();
+    echo_server(loop, sys::fd_t{fds[0]});
+    echo_client(loop, sys::fd_t{fds[1]}, completed);
+    loop.run().except("the event loop failed");
+    const auto seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start
+    )
+                             .count();
+
+    if (completed != round_trips)
+    {
+        std::cerr << "only " << completed << " echoes came back intact\n";
+        return 1;
+    }
+
+    std::cout << round_trips << " echo round trips in " << seconds << "s ("
+              << round_trips / seconds << " per second)\n";
+}
@@ -0,0 +1,40 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include <kirho/generator.hpp>
+
+using count_t = kirho::result_t<std::uint64_t, int>;
+
+constexpr auto count = std::uint64_t{10000000};
+
+auto count_to(std::uint64_t limit) -> kirho::generator_t<count_t>
+{
+    for (auto i = std::uint64_t{0}; i < limit; i++)
+    {
+        co_yield count_t::success(i);
+    }
+}
+
+// How long handing out an item takes, which is mostly resuming the coroutine.
+auto main() -> int
+{
+    auto sum = std::uint64_t{0};
+    const auto start = std::chrono::steady_clock::now();
+    for (auto& item : count_to(count))
+    {
+        sum += item.unwrap();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (sum != count * (count - 1) / 2)
+    {
+        std::cerr << "some of the items came out wrong\n";
+        return 1;
+    }
+
+    std::cout << "generator: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     static_cast<double>(count)
+              << "ns per item\n";
+}
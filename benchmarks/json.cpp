@@ -0,0 +1,158 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <kirho/json.hpp>
+
+using kirho::json_document_t;
+
+// A small tree-building parser of the usual kind, which allocates for every
+// value, to compare against.
+struct dom_t
+{
+    std::variant<
+        std::nullptr_t,
+        bool,
+        double,
+        std::string,
+        std::vector<dom_t>,
+        std::map<std::string, dom_t>>
+        value;
+};
+
+auto parse_dom(std::string_view text, std::size_t& position) -> dom_t
+{
+    const auto skip = [&]() {
+        while (kirho::detail::is_json_whitespace(text[position]))
+        {
+            position++;
+        }
+    };
+    const auto string = [&]() {
+        auto value = std::string{};
+        for (position++; text[position] != '"'; position++)
+        {
+            value += text[position];
+        }
+        position++;
+        return value;
+    };
+
+    skip();
+    auto node = dom_t{};
+    if (text[position] == '{')
+    {
+        auto object = std::map<std::string, dom_t>{};
+        for (position++, skip(); text[position] != '}'; skip())
+        {
+            position += text[position] == ',';
+            skip();
+            auto key = string();
+            skip();
+            position++;
+            object.emplace(std::move(key), parse_dom(text, position));
+        }
+        position++;
+        node.value = std::move(object);
+    }
+    else if (text[position] == '[')
+    {
+        auto array = std::vector<dom_t>{};
+        for (position++, skip(); text[position] != ']'; skip())
+        {
+            position += text[position] == ',';
+            array.push_back(parse_dom(text, position));
+        }
+        position++;
+        node.value = std::move(array);
+    }
+    else if (text[position] == '"')
+    {
+        node.value = string();
+    }
+    else if (text.substr(position, 4) == "true" ||
+             text.substr(position, 4) == "null")
+    {
+        node.value = text[position] == 't';
+        position += 4;
+    }
+    else if (text.substr(position, 5) == "false")
+    {
+        node.value = false;
+        position += 5;
+    }
+    else
+    {
+        auto end = position;
+        while (!kirho::detail::is_json_operator(text[end]) &&
+               !kirho::detail::is_json_whitespace(text[end]))
+        {
+            end++;
+        }
+        node.value =
+            kirho::parse<double>(text.substr(position, end - position))
+                .unwrap();
+        position = end;
+    }
+
+    return node;
+}
+
+// Sums a field out of a big telemetry array, against building a tree out of
+// all of it first.
+auto main() -> int
+{
+    auto big = std::string{"["};
+    for (auto i = 0; big.size() < (16 << 20); i++)
+    {
+        big += (i == 0 ? "" : ",");
+        big += R"({"host": "web-)" + std::to_string(i % 100) +
+               R"(", "cpu": )" + std::to_string(i % 97) +
+               R"(, "tags": ["prod", "eu"], "ok": true})";
+    }
+    big += "]";
+
+    auto start = std::chrono::steady_clock::now();
+    const auto telemetry = json_document_t::parse(big).unwrap();
+    auto total = std::int64_t{0};
+    for (const auto entry : telemetry.root().get_array().unwrap())
+    {
+        total += entry.find_field("cpu").unwrap().get_int64().unwrap();
+    }
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start
+    )
+                       .count();
+    std::cout << "on demand at "
+              << static_cast<double>(big.size()) / seconds / 1e6 << " MB/s\n";
+
+    start = std::chrono::steady_clock::now();
+    auto position = std::size_t{0};
+    const auto tree = parse_dom(big, position);
+    auto dom_total = std::int64_t{0};
+    for (const auto& entry : std::get<std::vector<dom_t>>(tree.value))
+    {
+        const auto& fields =
+            std::get<std::map<std::string, dom_t>>(entry.value);
+        dom_total +=
+            static_cast<std::int64_t>(std::get<double>(fields.at("cpu").value));
+    }
+    seconds = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start
+    )
+                  .count();
+    std::cout << "tree at " << static_cast<double>(big.size()) / seconds / 1e6
+              << " MB/s\n";
+
+    if (total != dom_total)
+    {
+        std::cerr << "the two parsers came up with different totals\n";
+        return 1;
+    }
+}
@@ -0,0 +1,36 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include <kirho/lazy_result.hpp>
+
+using lazy_t = kirho::lazy_result_t<std::string, int>;
+using result_t = kirho::result_t<std::string, int>;
+
+constexpr auto iterations = 10000000;
+
+// How long getting a value that's already there takes.
+auto main() -> int
+{
+    auto lazy = lazy_t{[]() { return result_t::success("configured"); }};
+
+    auto length = std::size_t{0};
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; i++)
+    {
+        length += lazy.get().unwrap().get().size();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (length != std::size_t{10} * iterations)
+    {
+        std::cerr << "the value changed while it was being read\n";
+        return 1;
+    }
+
+    std::cout << "get took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns\n";
+}
@@ -0,0 +1,57 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kirho/memoize.hpp>
+
+using result_t = kirho::result_t<int, std::string>;
+
+constexpr auto thread_count = 4;
+constexpr auto lookups = 1000000;
+
+// How long a hit takes, with every thread hitting the same small set of keys.
+auto main() -> int
+{
+    auto square =
+        kirho::memoize([](int x) { return result_t::success(x * x); });
+    for (auto i = 0; i < 1024; i++)
+    {
+        square(i).unwrap();
+    }
+
+    auto sums = std::vector<long>(thread_count);
+    auto threads = std::vector<std::thread>{};
+    const auto start = std::chrono::steady_clock::now();
+    for (auto t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&square, &sums, t]() {
+            auto sum = 0l;
+            for (auto i = 0; i < lookups; i++)
+            {
+                sum += square((i + t) % 1024).unwrap();
+            }
+            sums[t] = sum;
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    for (const auto sum : sums)
+    {
+        if (sum == 0)
+        {
+            std::cerr << "a thread didn't get any of the values\n";
+            return 1;
+        }
+    }
+
+    std::cout << "hits took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     (lookups * thread_count)
+              << " ns per lookup\n";
+}
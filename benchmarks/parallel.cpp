@@ -0,0 +1,40 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <kirho/parallel.hpp>
+
+using sum_t = kirho::result_t<std::uint64_t, std::string>;
+
+// Adds up a million numbers on four threads, which is mostly the cost of
+// splitting the range up and putting the chunks back together.
+auto main() -> int
+{
+    auto pool = kirho::thread_pool_t{4};
+
+    auto numbers = std::vector<std::uint64_t>(1000000);
+    std::iota(numbers.begin(), numbers.end(), std::uint64_t{1});
+    const auto add = [](std::uint64_t sum, std::uint64_t value) {
+        return sum_t::success(sum + value);
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto sum =
+        kirho::parallel_try_reduce(pool, numbers, std::uint64_t{0}, add)
+            .except("the numbers didn't add up");
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (sum != numbers.size() * (numbers.size() + 1) / 2)
+    {
+        std::cerr << "the sum came out as " << sum << '\n';
+        return 1;
+    }
+
+    std::cout << "parallel_try_reduce: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     static_cast<double>(numbers.size())
+              << "ns per element\n";
+}
@@ -0,0 +1,53 @@
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kirho/parse.hpp>
+
+// Compares the fast path of parse against from_chars on its own, which is
+// what it's built on top of.
+auto main() -> int
+{
+    auto inputs = std::vector<std::string>{};
+    for (auto i = std::uint64_t{0}; i < 1000000; i++)
+    {
+        inputs.push_back(std::to_string((i * 0x9E3779B97F4A7C15) >> 10));
+    }
+
+    const auto measure = [&](auto parse_one) {
+        auto sum = std::uint64_t{0};
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& input : inputs)
+        {
+            sum += parse_one(input);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto nanoseconds =
+            std::chrono::duration<double, std::nano>(elapsed).count();
+
+        return std::pair{sum, nanoseconds / static_cast<double>(inputs.size())};
+    };
+
+    const auto [kirho_sum, kirho_time] = measure([](const std::string& input) {
+        return kirho::parse<std::uint64_t>(input).unwrap();
+    });
+    const auto [std_sum, std_time] = measure([](const std::string& input) {
+        auto value = std::uint64_t{0};
+        std::from_chars(input.data(), input.data() + input.size(), value);
+        return value;
+    });
+
+    if (kirho_sum != std_sum)
+    {
+        std::cerr << "kirho::parse and std::from_chars disagree\n";
+        return 1;
+    }
+
+    std::cout << "kirho::parse: " << kirho_time
+              << "ns per number, std::from_chars: " << std_time
+              << "ns per number\n";
+}
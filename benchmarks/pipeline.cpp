@@ -0,0 +1,65 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <kirho/pipeline.hpp>
+
+using parsed_t = kirho::result_t<std::int64_t, std::string>;
+
+constexpr auto count = 1000000;
+
+// Pushes text through a parsing stage and a doubling stage into a sum, and
+// prints how fast each of the stages went.
+auto main() -> int
+{
+    auto total = std::atomic<std::int64_t>{0};
+    auto failures = std::atomic<int>{0};
+    auto metrics = std::vector<kirho::stage_metrics_t>{};
+    const auto start = std::chrono::steady_clock::now();
+    {
+        auto pipeline =
+            kirho::make_pipeline<std::string, std::string>(
+                [&](std::string) { failures++; }, 256
+            )
+                .then(
+                    "parse",
+                    [](const std::string& text) {
+                        return parsed_t::success(std::stoll(text));
+                    },
+                    {.threads = 2, .capacity = 256}
+                )
+                .then(
+                    "double",
+                    [](std::int64_t value) {
+                        return parsed_t::success(value * 2);
+                    },
+                    {.threads = 2, .capacity = 64}
+                )
+                .sink("sum", [&](std::int64_t value) { total += value; });
+
+        for (auto i = 0; i < count; i++)
+        {
+            pipeline->push(std::to_string(i));
+        }
+        pipeline->wait();
+        metrics = pipeline->metrics();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (failures != 0 || total != std::int64_t{count} * (count - 1))
+    {
+        std::cerr << "some of the items didn't make it through\n";
+        return 1;
+    }
+
+    std::cout << count << " items through the pipeline in "
+              << std::chrono::duration<double>(elapsed).count() << "s\n";
+    for (const auto& stage : metrics)
+    {
+        std::cout << "  " << stage.name << ": " << stage.throughput
+                  << " items per second\n";
+    }
+}
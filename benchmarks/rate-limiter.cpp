@@ -0,0 +1,31 @@
+#include <chrono>
+#include <iostream>
+
+#include <kirho/rate_limiter.hpp>
+
+constexpr auto iterations = 10000000;
+
+// How long taking a token takes, when there are always enough of them.
+auto main() -> int
+{
+    auto limiter = kirho::rate_limiter_t{1e9, 1000000000};
+
+    auto taken = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < iterations; i++)
+    {
+        taken += limiter.try_acquire().to_optional() ? 1 : 0;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (taken != iterations)
+    {
+        std::cerr << "only " << taken << " of the tokens were handed out\n";
+        return 1;
+    }
+
+    std::cout << "try_acquire took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns\n";
+}
@@ -0,0 +1,40 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <kirho/retry.hpp>
+
+using namespace std::chrono_literals;
+using result_t = kirho::result_t<int, std::string>;
+using policy_t = kirho::retry_policy_t<std::string>;
+
+constexpr auto iterations = 1000000;
+
+// The overhead of retry when the first attempt works, which is the usual case.
+auto main() -> int
+{
+    auto policy = policy_t{};
+    policy.base_delay = 1ms;
+    policy.max_delay = 4ms;
+
+    auto sum = 0;
+    const auto start = policy_t::clock_t::now();
+    for (auto i = 0; i < iterations; i++)
+    {
+        sum += kirho::retry(policy, [i]() {
+                   return result_t::success(i & 1);
+               }).unwrap();
+    }
+    const auto elapsed = policy_t::clock_t::now() - start;
+
+    if (sum != iterations / 2)
+    {
+        std::cerr << "some of the attempts came back wrong\n";
+        return 1;
+    }
+
+    std::cout << "retry took "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns when the first attempt works\n";
+}
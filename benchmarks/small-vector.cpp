@@ -0,0 +1,34 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+#include <kirho/small_vector.hpp>
+
+constexpr auto count = 1000000;
+
+// How long making a short vector, filling it and throwing it away takes, when
+// it never has to go to the heap.
+auto main() -> int
+{
+    auto total = std::size_t{0};
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < count; i++)
+    {
+        auto small = kirho::small_vector_t<int, 4>{};
+        small.push_back(i);
+        small.push_back(i + 1);
+        total += small.size();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (total != 2 * count)
+    {
+        std::cerr << "some of the vectors came out the wrong size\n";
+        return 1;
+    }
+
+    std::cout << "small_vector: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     count
+              << "ns per short vector\n";
+}
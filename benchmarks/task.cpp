@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include <kirho/task.hpp>
+
+using number_t = kirho::task_t<int, std::string>;
+using result_t = kirho::result_t<int, std::string>;
+
+constexpr auto rounds = 20000;
+
+auto send(int fd, const char& byte) -> void
+{
+    if (::write(fd, &byte, 1) != 1)
+    {
+        std::cerr << "failed to write to the pipe\n";
+        std::exit(1);
+    }
+}
+
+auto receive(int fd, char& byte) -> void
+{
+    if (::read(fd, &byte, 1) != 1)
+    {
+        std::cerr << "failed to read from the pipe\n";
+        std::exit(1);
+    }
+}
+
+// Sends a byte back and forth between two pipes, hopping over to the pool in
+// between, the way a reader and a writer that hand work to each other would.
+auto ping_pong(kirho::thread_pool_t& pool, const int (&fds)[4]) -> number_t
+{
+    auto byte = char{0};
+    for (auto i = 0; i < rounds; i++)
+    {
+        send(fds[1], byte);
+        co_await kirho::schedule(pool);
+        receive(fds[0], byte);
+        send(fds[3], byte);
+        co_await kirho::schedule(pool);
+        receive(fds[2], byte);
+    }
+
+    co_return result_t::success(rounds);
+}
+
+// The same thing, with every step posting the next one as a callback.
+struct callback_ping_pong_t
+{
+    auto ping() -> void
+    {
+        if (round == rounds)
+        {
+            done.set_value();
+            return;
+        }
+
+        round++;
+        send(fds[1], byte);
+        pool.post([this]() { pong(); });
+    }
+
+    auto pong() -> void
+    {
+        receive(fds[0], byte);
+        send(fds[3], byte);
+        pool.post([this]() {
+            receive(fds[2], byte);
+            ping();
+        });
+    }
+
+    kirho::thread_pool_t& pool;
+    const int (&fds)[4];
+    int round = 0;
+    char byte = 0;
+    std::promise<void> done{};
+};
+
+// Compares the round trip between the two pipes when the steps are tasks that
+// hop between threads, against when they are callbacks posted to the pool.
+auto main() -> int
+{
+    auto pool = kirho::thread_pool_t{4};
+
+    int fds[4];
+    if (::pipe(fds) != 0 || ::pipe(fds + 2) != 0)
+    {
+        std::cerr << "failed to create the pipes\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    kirho::sync_wait(ping_pong(pool, fds)).except("the ping-pong failed");
+    const auto coroutines = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    auto callbacks = callback_ping_pong_t{pool, fds};
+    auto done = callbacks.done.get_future();
+    pool.post([&callbacks]() { callbacks.ping(); });
+    done.get();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    for (auto fd : fds)
+    {
+        ::close(fd);
+    }
+
+    const auto per_round = [](auto duration) {
+        return std::chrono::duration<double, std::nano>(duration).count() /
+               rounds;
+    };
+    std::cout << "pipe ping-pong: " << per_round(coroutines)
+              << "ns per round with tasks, " << per_round(elapsed)
+              << "ns per round with callbacks\n";
+}
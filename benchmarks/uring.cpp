@@ -0,0 +1,99 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <unistd.h>
+
+#include <kirho/uring.hpp>
+
+using kirho::uring_t;
+namespace sys = kirho::sys;
+
+constexpr auto block_size = std::size_t{4096};
+constexpr auto block_count = 4096;
+constexpr auto rounds = 10;
+
+// Reads a file that's in the page cache in batches of blocks, and returns how
+// many bytes were read per second.
+auto measure(uring_t ring, const sys::fd_t& file) -> double
+{
+    auto blocks = std::vector<std::array<std::byte, block_size>>(block_count);
+    auto futures = std::vector<uring_t::future_t>{};
+    futures.reserve(block_count);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto round = 0; round < rounds; round++)
+    {
+        futures.clear();
+        for (auto i = 0; i < block_count; i++)
+        {
+            futures.push_back(ring.pread(
+                file,
+                blocks[static_cast<std::size_t>(i)],
+                i * off_t{block_size}
+            ));
+        }
+        ring.submit().except("failed to submit the reads");
+
+        for (auto& future : futures)
+        {
+            if (future.get().except("a read failed") != block_size)
+            {
+                std::cerr << "a read came back short\n";
+                std::exit(1);
+            }
+        }
+    }
+    const auto seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start
+    )
+                             .count();
+
+    return static_cast<double>(block_size) * block_count * rounds / seconds;
+}
+
+// Compares the thread pool with whichever backend we get by default, and says
+// which one that was.
+auto main() -> int
+{
+    char path[] = "/tmp/kirho-uring-benchmark-XXXXXX";
+    const auto file = sys::fd_t{mkstemp(path)};
+    if (!file.is_open())
+    {
+        std::cerr << "failed to create the file\n";
+        return 1;
+    }
+    defer(path, unlink(path));
+
+    const auto block = std::array<std::byte, block_size>{};
+    for (auto i = 0; i < block_count; i++)
+    {
+        if (::write(file.get(), block.data(), block.size()) !=
+            static_cast<ssize_t>(block.size()))
+        {
+            std::cerr << "failed to fill the file\n";
+            return 1;
+        }
+    }
+
+    const auto pool = measure(
+        uring_t::create(256, uring_t::backend_t::thread_pool, 4)
+            .except("failed to create the thread pool backend"),
+        file
+    );
+    std::cout << "thread pool: " << pool / 1e6 << " MB/s\n";
+
+    auto automatic = uring_t::create(256).except("failed to create a backend");
+    const auto has_io_uring =
+        automatic.backend() == uring_t::backend_t::io_uring;
+    std::cout << "io_uring is " << (has_io_uring ? "" : "not ")
+              << "available\n";
+    if (has_io_uring)
+    {
+        const auto ring = measure(std::move(automatic), file);
+        std::cout << "io_uring: " << ring / 1e6 << " MB/s\n";
+    }
+}
@@ -0,0 +1,23 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <kirho/utf8.hpp>
+
+// Validates mostly ASCII text with some accents in it, which is what most
+// text looks like.
+auto main() -> int
+{
+    auto text = std::string{};
+    while (text.size() < (64 << 20))
+    {
+        text += "Français, español, and plain ASCII text. ";
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    kirho::validate_utf8(text).except("the text should be valid");
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << "validated at "
+              << static_cast<double>(text.size()) / seconds / 1e6 << " MB/s\n";
+}
@@ -0,0 +1,45 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <kirho/validation.hpp>
+
+using age_t = kirho::result_t<int, std::string>;
+
+constexpr auto count = 1000000;
+
+auto check_age(int age) -> age_t
+{
+    if (age < 0 || age > 150)
+    {
+        return age_t::error("out of range");
+    }
+
+    return age_t::success(age);
+}
+
+// How long validating three fields at once takes, when some of them fail.
+auto main() -> int
+{
+    auto valid = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < count; i++)
+    {
+        const auto checked = kirho::validate(
+            check_age(i % 200), check_age(i % 150), check_age(i % 100)
+        );
+        valid += checked.is_valid() ? 1 : 0;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (valid == 0 || valid == count)
+    {
+        std::cerr << "the checks all came out the same\n";
+        return 1;
+    }
+
+    std::cout << "validate: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     count
+              << "ns per three checks\n";
+}
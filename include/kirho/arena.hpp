@@ -0,0 +1,197 @@
+/**
+ * @file arena.hpp
+ * @brief Memory for short lived things, that's all given back at once.
+ *
+ * Contains @ref kirho::arena_t, a bump allocator that hands out memory from
+ * big blocks, and only gets it back all at once, when it's reset. It's also a
+ * `std::pmr::memory_resource`, so the `std::pmr` containers can use it.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace kirho
+{
+/**
+ * @brief Hands out memory by moving a pointer along a block, and gives all of
+ * it back at once.
+ *
+ * Allocating is a couple of additions and a comparison, unless the block is
+ * full, in which case it moves on to the next one. Deallocating does nothing,
+ * and @ref reset rewinds to the first block, keeping all of the blocks around
+ * for the next round, so an arena that's reset over and over stops allocating
+ * from the system once it has grown big enough.
+ *
+ * Nothing that's allocated from the arena is destroyed by it, so either
+ * destroy it yourself before resetting, or only put things in it that don't
+ * need to be destroyed. Arenas aren't thread safe, so every thread needs its
+ * own.
+ */
+class arena_t final : public std::pmr::memory_resource
+{
+  public:
+    /**
+     * @brief Creates an empty arena, which doesn't allocate anything until
+     * it's first used.
+     *
+     * @param p_block_size The size of the blocks. Bigger allocations get a
+     * block of their own.
+     */
+    explicit arena_t(std::size_t p_block_size = 64 * 1024) noexcept
+        : m_block_size{std::max<std::size_t>(p_block_size, 64)}
+    {
+    }
+
+    arena_t(const arena_t&) = delete;
+    arena_t& operator=(const arena_t&) = delete;
+
+    /**
+     * @brief Creates an object in the arena. It's never destroyed, which is
+     * why it has to be a type that doesn't need to be.
+     */
+    template <typename T, typename... Args>
+    auto make(Args&&... args) -> T*
+    {
+        static_assert(
+            std::is_trivially_destructible_v<T>,
+            "the arena never destroys what's in it"
+        );
+
+        // The arena is final, so this skips the virtual call that allocate
+        // would make.
+        return ::new (do_allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Gives everything back at once, and starts over from the first
+     * block. The blocks themselves are kept.
+     */
+    auto reset() noexcept -> void
+    {
+        m_block = 0;
+        m_used = 0;
+        if (m_blocks.empty())
+        {
+            m_cursor = nullptr;
+            m_end = nullptr;
+            return;
+        }
+
+        m_cursor = m_blocks.front().data.get();
+        m_end = m_cursor + m_blocks.front().size;
+    }
+
+    /**
+     * @brief Returns the number of bytes handed out since the last reset.
+     */
+    auto used() const noexcept -> std::size_t
+    {
+        return m_used;
+    }
+
+    /**
+     * @brief Returns the number of bytes in all of the blocks.
+     */
+    auto capacity() const noexcept -> std::size_t
+    {
+        auto capacity = std::size_t{0};
+        for (const auto& block : m_blocks)
+        {
+            capacity += block.size;
+        }
+
+        return capacity;
+    }
+
+  private:
+    struct block_t
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment)
+        -> void* override
+    {
+        auto* start = align(m_cursor, alignment);
+        if (!fits(start, bytes)) [[unlikely]]
+        {
+            start = next_block(bytes, alignment);
+        }
+
+        m_cursor = start + bytes;
+        m_used += bytes;
+        return start;
+    }
+
+    auto do_deallocate(void*, std::size_t, std::size_t) noexcept
+        -> void override
+    {
+    }
+
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept
+        -> bool override
+    {
+        return this == &other;
+    }
+
+    static auto align(std::byte* pointer, std::size_t alignment) noexcept
+        -> std::byte*
+    {
+        const auto address = reinterpret_cast<std::uintptr_t>(pointer);
+        const auto aligned = (address + alignment - 1) & ~(alignment - 1);
+        return pointer + (aligned - address);
+    }
+
+    auto fits(const std::byte* start, std::size_t bytes) const noexcept
+        -> bool
+    {
+        return start != nullptr && start <= m_end &&
+               static_cast<std::size_t>(m_end - start) >= bytes;
+    }
+
+    // Moves on to the next block that's big enough, making one if there
+    // isn't one. Blocks that are skipped stay where they are, and get used
+    // again after the next reset.
+    auto next_block(std::size_t bytes, std::size_t alignment) -> std::byte*
+    {
+        const auto needed = bytes + alignment;
+        auto index = m_blocks.empty() ? 0 : m_block + 1;
+        while (index < m_blocks.size() && m_blocks[index].size < needed)
+        {
+            index++;
+        }
+
+        if (index == m_blocks.size())
+        {
+            const auto size = std::max(m_block_size, needed);
+            // Not zeroed, which make_unique would do.
+            m_blocks.push_back(
+                {std::unique_ptr<std::byte[]>{new std::byte[size]}, size}
+            );
+        }
+
+        m_block = index;
+        auto* data = m_blocks[index].data.get();
+        m_end = data + m_blocks[index].size;
+        return align(data, alignment);
+    }
+
+  private:
+    std::size_t m_block_size;
+    std::vector<block_t> m_blocks;
+    std::size_t m_block = 0;
+    std::byte* m_cursor = nullptr;
+    std::byte* m_end = nullptr;
+    std::size_t m_used = 0;
+};
+} // namespace kirho
@@ -0,0 +1,487 @@
+/**
+ * @file arithmetic.hpp
+ * @brief Integer arithmetic that tells you when it overflows.
+ *
+ * Contains @ref kirho::checked_add and friends, which do the arithmetic that
+ * you asked for and return an error instead of a wrapped around or undefined
+ * result when it doesn't fit. There are also versions that work on whole
+ * arrays at once, which are written so that the compiler can vectorize them.
+ */
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The reason why some arithmetic could not be done.
+ */
+struct arith_error_t
+{
+    /**
+     * @brief The kinds of things that can go wrong.
+     */
+    enum class kind_t
+    {
+        /// The result doesn't fit into the type.
+        overflow,
+        /// Something was divided by zero.
+        division_by_zero,
+        /// The value doesn't fit into the type that it was converted to.
+        out_of_range,
+    };
+
+    /**
+     * @brief What went wrong.
+     */
+    kind_t kind = kind_t::overflow;
+
+    /**
+     * @brief For the functions that work on arrays, the index of the first
+     * element where it went wrong. Always 0 for the others.
+     */
+    std::size_t index = 0;
+
+    auto operator==(const arith_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const arith_error_t& error)
+    -> std::ostream&
+{
+    switch (error.kind)
+    {
+    case arith_error_t::kind_t::overflow:
+        stream << "overflow";
+        break;
+    case arith_error_t::kind_t::division_by_zero:
+        stream << "division by zero";
+        break;
+    case arith_error_t::kind_t::out_of_range:
+        stream << "value out of range";
+        break;
+    }
+
+    return stream << " at index " << error.index;
+}
+
+/**
+ * @brief The types that the checked functions work on.
+ */
+template <typename T>
+concept checked_integral_t = std::integral<T> && !std::same_as<T, bool>;
+
+/**
+ * @brief Adds the two numbers together.
+ */
+template <checked_integral_t T>
+auto checked_add(T lhs, std::type_identity_t<T> rhs) noexcept
+    -> result_t<T, arith_error_t>
+{
+    using result = result_t<T, arith_error_t>;
+
+    auto value = T{};
+    if (__builtin_add_overflow(lhs, rhs, &value))
+    {
+        return result::error({arith_error_t::kind_t::overflow});
+    }
+
+    return result::success(value);
+}
+
+/**
+ * @brief Subtracts the second number from the first.
+ */
+template <checked_integral_t T>
+auto checked_sub(T lhs, std::type_identity_t<T> rhs) noexcept
+    -> result_t<T, arith_error_t>
+{
+    using result = result_t<T, arith_error_t>;
+
+    auto value = T{};
+    if (__builtin_sub_overflow(lhs, rhs, &value))
+    {
+        return result::error({arith_error_t::kind_t::overflow});
+    }
+
+    return result::success(value);
+}
+
+/**
+ * @brief Multiplies the two numbers together.
+ */
+template <checked_integral_t T>
+auto checked_mul(T lhs, std::type_identity_t<T> rhs) noexcept
+    -> result_t<T, arith_error_t>
+{
+    using result = result_t<T, arith_error_t>;
+
+    auto value = T{};
+    if (__builtin_mul_overflow(lhs, rhs, &value))
+    {
+        return result::error({arith_error_t::kind_t::overflow});
+    }
+
+    return result::success(value);
+}
+
+/**
+ * @brief Divides the first number by the second, rounding towards zero.
+ *
+ * Besides dividing by zero, the one way for this to go wrong is dividing the
+ * smallest signed number by -1, since the result is one more than the largest.
+ */
+template <checked_integral_t T>
+auto checked_div(T lhs, std::type_identity_t<T> rhs) noexcept
+    -> result_t<T, arith_error_t>
+{
+    using result = result_t<T, arith_error_t>;
+
+    if (rhs == 0)
+    {
+        return result::error({arith_error_t::kind_t::division_by_zero});
+    }
+
+    if constexpr (std::is_signed_v<T>)
+    {
+        if (lhs == std::numeric_limits<T>::min() && rhs == -1)
+        {
+            return result::error({arith_error_t::kind_t::overflow});
+        }
+    }
+
+    return result::success(static_cast<T>(lhs / rhs));
+}
+
+/**
+ * @brief Converts the number to another integer type, if it fits.
+ *
+ * @tparam To The type to convert to.
+ */
+template <checked_integral_t To, checked_integral_t From>
+auto narrow_cast(From value) noexcept -> result_t<To, arith_error_t>
+{
+    using result = result_t<To, arith_error_t>;
+
+    if (!std::in_range<To>(value))
+    {
+        return result::error({arith_error_t::kind_t::out_of_range});
+    }
+
+    return result::success(static_cast<To>(value));
+}
+
+namespace detail
+{
+// The arrays are worked through in blocks of this many elements. Each block
+// is done without any branches, and only if something overflowed in it does
+// it get done again one element at a time to find out where.
+inline constexpr auto checked_block_size = std::size_t{64};
+
+[[noreturn]] inline auto checked_size_mismatch() noexcept -> void
+{
+    std::cerr << "kirho: the arrays have different sizes.\n";
+    std::terminate();
+}
+
+enum class checked_op_t
+{
+    add,
+    sub,
+    mul,
+};
+
+// Does the operation on a whole block with wrapping arithmetic, and returns
+// whether any of it overflowed. The results go into a local array first, so
+// that the compiler knows they don't overlap with the inputs, and they only
+// make it to the output if nothing overflowed. That way, when the output is
+// one of the inputs, the block can still be gone over again one element at a
+// time, to find the one that overflowed.
+template <checked_op_t Op, typename T>
+auto checked_block(const T* lhs, const T* rhs, T* output) noexcept -> bool
+{
+    using unsigned_t = std::make_unsigned_t<T>;
+
+    T block[checked_block_size];
+    auto flags = unsigned_t{0};
+    for (auto i = std::size_t{0}; i < checked_block_size; i++)
+    {
+        const auto a = lhs[i];
+        const auto b = rhs[i];
+        if constexpr (Op == checked_op_t::mul)
+        {
+            // There's no cheap way to spot multiplication overflows in vector
+            // registers, but this at least keeps the loop free of branches.
+            flags |= static_cast<unsigned_t>(
+                __builtin_mul_overflow(a, b, &block[i])
+            );
+        }
+        else
+        {
+            const auto value = static_cast<T>(
+                Op == checked_op_t::add
+                    ? static_cast<unsigned_t>(a) + static_cast<unsigned_t>(b)
+                    : static_cast<unsigned_t>(a) - static_cast<unsigned_t>(b)
+            );
+            block[i] = value;
+
+            // Signed addition overflows when the result has a different sign
+            // from both of the operands, and subtraction when the operands
+            // have different signs and the result has a different one from
+            // the first.
+            if constexpr (std::is_signed_v<T> && Op == checked_op_t::add)
+            {
+                flags |= static_cast<unsigned_t>((a ^ value) & (b ^ value));
+            }
+            else if constexpr (std::is_signed_v<T>)
+            {
+                flags |= static_cast<unsigned_t>((a ^ b) & (a ^ value));
+            }
+            else if constexpr (Op == checked_op_t::add)
+            {
+                flags |= static_cast<unsigned_t>(value < a);
+            }
+            else
+            {
+                flags |= static_cast<unsigned_t>(a < b);
+            }
+        }
+    }
+
+    auto overflowed = false;
+    if constexpr (std::is_signed_v<T> && Op != checked_op_t::mul)
+    {
+        overflowed =
+            (flags >> (std::numeric_limits<unsigned_t>::digits - 1)) != 0;
+    }
+    else
+    {
+        overflowed = flags != 0;
+    }
+
+    if (!overflowed)
+    {
+        std::memcpy(output, block, sizeof(block));
+    }
+
+    return overflowed;
+}
+
+template <checked_op_t Op, typename T>
+auto checked_one(T lhs, T rhs) noexcept -> result_t<T, arith_error_t>
+{
+    if constexpr (Op == checked_op_t::add)
+    {
+        return checked_add(lhs, rhs);
+    }
+    else if constexpr (Op == checked_op_t::sub)
+    {
+        return checked_sub(lhs, rhs);
+    }
+    else
+    {
+        return checked_mul(lhs, rhs);
+    }
+}
+
+template <checked_op_t Op, typename T>
+auto checked_batch(
+    std::span<const T> lhs,
+    std::span<const T> rhs,
+    std::span<T> output
+) noexcept -> result_t<empty_t, arith_error_t>
+{
+    using result = result_t<empty_t, arith_error_t>;
+
+    if (lhs.size() != rhs.size() || lhs.size() != output.size())
+    {
+        checked_size_mismatch();
+    }
+
+    auto position = std::size_t{0};
+    for (; lhs.size() - position >= checked_block_size;
+         position += checked_block_size)
+    {
+        const auto overflowed = checked_block<Op>(
+            lhs.data() + position,
+            rhs.data() + position,
+            output.data() + position
+        );
+        if (overflowed)
+        {
+            break;
+        }
+    }
+
+    for (; position < lhs.size(); position++)
+    {
+        if (!checked_one<Op>(lhs[position], rhs[position])
+                 .is_success(output[position]))
+        {
+            return result::error({arith_error_t::kind_t::overflow, position});
+        }
+    }
+
+    return result::success({});
+}
+
+// Sums up a whole block with wrapping arithmetic, if it can tell that none of
+// the running totals along the way can overflow. That's the case when the
+// total so far is within an eighth of the range around zero, and every
+// element is small enough that 64 of them only add up to another quarter.
+template <typename T>
+auto checked_sum_block(const T* values, T& total) noexcept -> bool
+{
+    using unsigned_t = std::make_unsigned_t<T>;
+    constexpr auto digits = std::numeric_limits<unsigned_t>::digits;
+    static_assert(checked_block_size == 64);
+
+    // Adding the bias moves the allowed range of signed values to start at
+    // zero, so one check covers both ends.
+    constexpr auto bias = std::is_signed_v<T> ? unsigned_t{1} << (digits - 8)
+                                              : unsigned_t{0};
+    constexpr auto total_bias = std::is_signed_v<T>
+                                    ? unsigned_t{1} << (digits - 3)
+                                    : unsigned_t{0};
+
+    const auto biased_total =
+        static_cast<unsigned_t>(static_cast<unsigned_t>(total) + total_bias);
+    if ((biased_total >> (digits - 2)) != 0)
+    {
+        return false;
+    }
+
+    auto sum = unsigned_t{0};
+    auto high = unsigned_t{0};
+    for (auto i = std::size_t{0}; i < checked_block_size; i++)
+    {
+        const auto value = static_cast<unsigned_t>(values[i]);
+        sum += value;
+        high |= static_cast<unsigned_t>(value + bias);
+    }
+
+    if ((high >> (digits - 7)) != 0)
+    {
+        return false;
+    }
+
+    total = static_cast<T>(static_cast<unsigned_t>(total) + sum);
+    return true;
+}
+} // namespace detail
+
+/**
+ * @brief Adds the arrays together, element by element.
+ *
+ * The arrays have to be the same size, or else we panic. The output can be
+ * the same array as one of the inputs, but it can't partially overlap them.
+ *
+ * @return Nothing, or the index of the first element that overflowed. In that
+ * case, the elements of the output before that index are filled in, and the
+ * rest are unspecified.
+ */
+template <checked_integral_t T>
+auto checked_add(
+    std::span<const std::type_identity_t<T>> lhs,
+    std::span<const std::type_identity_t<T>> rhs,
+    std::span<T> output
+) noexcept -> result_t<empty_t, arith_error_t>
+{
+    return detail::checked_batch<detail::checked_op_t::add, T>(
+        lhs, rhs, output
+    );
+}
+
+/**
+ * @brief Subtracts the second array from the first, element by element.
+ *
+ * This works the same way as the array version of @ref checked_add.
+ */
+template <checked_integral_t T>
+auto checked_sub(
+    std::span<const std::type_identity_t<T>> lhs,
+    std::span<const std::type_identity_t<T>> rhs,
+    std::span<T> output
+) noexcept -> result_t<empty_t, arith_error_t>
+{
+    return detail::checked_batch<detail::checked_op_t::sub, T>(
+        lhs, rhs, output
+    );
+}
+
+/**
+ * @brief Multiplies the arrays together, element by element.
+ *
+ * This works the same way as the array version of @ref checked_add, but it
+ * doesn't get vectorized, since overflows are harder to spot there.
+ */
+template <checked_integral_t T>
+auto checked_mul(
+    std::span<const std::type_identity_t<T>> lhs,
+    std::span<const std::type_identity_t<T>> rhs,
+    std::span<T> output
+) noexcept -> result_t<empty_t, arith_error_t>
+{
+    return detail::checked_batch<detail::checked_op_t::mul, T>(
+        lhs, rhs, output
+    );
+}
+
+/**
+ * @brief Adds up all of the numbers in the array.
+ *
+ * Every addition along the way is checked, so this fails even if a later
+ * number would have brought the total back into range. Blocks of numbers that
+ * are small enough that they can't overflow are added up without checking
+ * each one, which the compiler can vectorize.
+ *
+ * @return The total, or the index of the number that made it overflow.
+ */
+template <checked_integral_t T>
+auto checked_sum(std::span<const T> values) noexcept
+    -> result_t<T, arith_error_t>
+{
+    using result = result_t<T, arith_error_t>;
+
+    auto total = T{0};
+    auto position = std::size_t{0};
+    while (position < values.size())
+    {
+        if (values.size() - position >= detail::checked_block_size &&
+            detail::checked_sum_block(values.data() + position, total))
+        {
+            position += detail::checked_block_size;
+            continue;
+        }
+
+        // Otherwise, go through the block one at a time.
+        const auto end = std::min(
+            position + detail::checked_block_size, values.size()
+        );
+        for (; position < end; position++)
+        {
+            if (!checked_add(total, values[position]).is_success(total))
+            {
+                return result::error(
+                    {arith_error_t::kind_t::overflow, position}
+                );
+            }
+        }
+    }
+
+    return result::success(total);
+}
+} // namespace kirho
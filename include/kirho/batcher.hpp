@@ -0,0 +1,234 @@
+/**
+ * @file batcher.hpp
+ * @brief Doing many small fallible things at once.
+ *
+ * Contains @ref kirho::batcher_t, which collects items that are submitted one
+ * at a time, from however many threads, into batches, and hands each batch to
+ * a function that deals with all of it at once, such as a lookup that takes a
+ * lock or makes a system call only once for the whole batch.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The settings of a @ref batcher_t.
+ */
+struct batcher_options_t
+{
+    /**
+     * @brief The most items in a batch. A batch is handed over as soon as it
+     * has this many.
+     */
+    std::size_t max_size = 64;
+
+    /**
+     * @brief The longest that an item waits for the batch it's in to fill
+     * up, before the batch is handed over anyway.
+     */
+    std::chrono::steady_clock::duration max_delay =
+        std::chrono::milliseconds{1};
+};
+
+/**
+ * @brief Collects items into batches, and hands each item its own result once
+ * its batch has been dealt with.
+ *
+ * Batches are handed to the function on a thread that the batcher owns, so
+ * submitting never waits for the function. The function gets the items of a
+ * batch in the order in which they were submitted, and has to return exactly
+ * one result for each of them, in the same order.
+ *
+ * @tparam In The type of the items.
+ * @tparam Out The type of the success value for each item.
+ * @tparam E The type of the error for each item.
+ */
+template <typename In, typename Out, typename E>
+class batcher_t
+{
+  public:
+    using result = result_t<Out, E>;
+    using function_t = std::function<std::vector<result>(std::span<const In>)>;
+
+    /**
+     * @brief Starts the thread that hands the batches over.
+     *
+     * @param p_function The function that deals with a batch.
+     * @param p_options When to hand a batch over.
+     */
+    explicit batcher_t(function_t p_function, batcher_options_t p_options = {})
+        : m_function{std::move(p_function)}, m_options{p_options}
+    {
+        if (m_options.max_size == 0)
+        {
+            m_options.max_size = 1;
+        }
+
+        m_thread = std::thread{[this]() { work(); }};
+    }
+
+    batcher_t(const batcher_t&) = delete;
+    batcher_t& operator=(const batcher_t&) = delete;
+
+    /**
+     * @brief Hands over whatever is left, and stops the thread.
+     */
+    ~batcher_t()
+    {
+        {
+            const auto lock = std::lock_guard{m_mutex};
+            m_stopping = true;
+        }
+        m_condition.notify_one();
+
+        m_thread.join();
+    }
+
+    /**
+     * @brief Adds the item to the current batch.
+     *
+     * @return A future that gets the result for the item. If the function
+     * throws, it gets the exception instead, and so does every other item in
+     * the batch.
+     */
+    auto submit(In item) -> std::future<result>
+    {
+        auto promise = std::promise<result>{};
+        auto future = promise.get_future();
+
+        auto wake = false;
+        {
+            const auto lock = std::lock_guard{m_mutex};
+            if (m_items.empty())
+            {
+                m_oldest = std::chrono::steady_clock::now();
+                wake = true;
+            }
+
+            m_items.push_back(std::move(item));
+            m_promises.push_back(std::move(promise));
+            wake = wake || m_items.size() == m_options.max_size;
+        }
+
+        // The thread only needs to know when it has to start timing a batch,
+        // and when one is full, not about every single item.
+        if (wake)
+        {
+            m_condition.notify_one();
+        }
+
+        return future;
+    }
+
+    /**
+     * @brief Returns the number of batches that have been handed over so far.
+     */
+    auto batch_count() const noexcept -> std::size_t
+    {
+        const auto lock = std::lock_guard{m_mutex};
+        return m_batches;
+    }
+
+  private:
+    auto work() -> void
+    {
+        auto items = std::vector<In>{};
+        auto promises = std::vector<std::promise<result>>{};
+
+        auto lock = std::unique_lock{m_mutex};
+        while (true)
+        {
+            m_condition.wait(lock, [this]() {
+                return m_stopping || !m_items.empty();
+            });
+            if (m_items.empty())
+            {
+                return;
+            }
+
+            m_condition.wait_until(
+                lock, m_oldest + m_options.max_delay, [this]() {
+                    return m_stopping || m_items.size() >= m_options.max_size;
+                }
+            );
+
+            // Everything that's queued up is taken at once, and split up into
+            // batches afterwards, so that the queue is never shifted around.
+            items.clear();
+            promises.clear();
+            std::swap(items, m_items);
+            std::swap(promises, m_promises);
+
+            const auto size = m_options.max_size;
+            m_batches += (items.size() + size - 1) / size;
+            lock.unlock();
+            for (auto i = std::size_t{0}; i < items.size(); i += size)
+            {
+                const auto count = std::min(size, items.size() - i);
+                run(std::span{items}.subspan(i, count),
+                    std::span{promises}.subspan(i, count));
+            }
+            lock.lock();
+        }
+    }
+
+    auto run(std::span<In> items, std::span<std::promise<result>> promises)
+        -> void
+    {
+        auto results = std::vector<result>{};
+        try
+        {
+            results = m_function(std::span<const In>{items});
+        }
+        catch (...)
+        {
+            for (auto& promise : promises)
+            {
+                promise.set_exception(std::current_exception());
+            }
+            return;
+        }
+
+        if (results.size() != items.size())
+        {
+            std::cerr << "kirho: the batch function returned "
+                      << results.size() << " results for " << items.size()
+                      << " items.\n";
+            std::terminate();
+        }
+
+        for (auto i = std::size_t{0}; i < results.size(); i++)
+        {
+            promises[i].set_value(std::move(results[i]));
+        }
+    }
+
+  private:
+    function_t m_function;
+    batcher_options_t m_options;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<In> m_items;
+    std::vector<std::promise<result>> m_promises;
+    std::chrono::steady_clock::time_point m_oldest;
+    std::size_t m_batches = 0;
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+} // namespace kirho
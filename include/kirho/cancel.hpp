@@ -0,0 +1,263 @@
+/**
+ * @file cancel.hpp
+ * @brief Giving up on work that nobody is waiting for anymore.
+ *
+ * Contains @ref kirho::stop_source_t and @ref kirho::stop_token_t, for asking
+ * work to stop, and @ref kirho::deadline_t, for work that has to be done by a
+ * certain time. Neither of them stops anything by itself. The work checks
+ * them every now and then, and gives up with a @ref kirho::cancel_error_t
+ * when it should. The thread pool and the event loop check them for you.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <utility>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The error for work that was given up on.
+ */
+struct cancel_error_t
+{
+    /**
+     * @brief The reason why it was given up on.
+     */
+    enum class kind_t
+    {
+        /// Somebody asked for it to stop.
+        cancelled,
+        /// Its deadline passed.
+        timed_out,
+    };
+
+    kind_t kind = kind_t::cancelled;
+
+    auto operator==(const cancel_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const cancel_error_t& error)
+    -> std::ostream&
+{
+    return stream << (error.kind == cancel_error_t::kind_t::cancelled
+                          ? "cancelled"
+                          : "timed out");
+}
+
+/**
+ * @brief The side of a stop request that gets checked.
+ *
+ * Tokens are cheap to copy, and checking one is a single relaxed load, so it
+ * can be done in tight loops. Since the load is relaxed, it doesn't order
+ * anything else, so don't use it to hand data over. A token that wasn't made
+ * by a @ref stop_source_t is never stopped.
+ */
+class stop_token_t
+{
+  public:
+    stop_token_t() noexcept = default;
+
+    /**
+     * @brief Checks if stopping has been asked for.
+     */
+    auto stop_requested() const noexcept -> bool
+    {
+        return m_state != nullptr &&
+               m_state->load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Checks if stopping could ever be asked for, which is only the
+     * case for tokens that were made by a source.
+     */
+    auto stop_possible() const noexcept -> bool
+    {
+        return m_state != nullptr;
+    }
+
+  private:
+    friend class stop_source_t;
+
+    explicit stop_token_t(std::shared_ptr<std::atomic<bool>> p_state) noexcept
+        : m_state{std::move(p_state)}
+    {
+    }
+
+  private:
+    std::shared_ptr<std::atomic<bool>> m_state;
+};
+
+/**
+ * @brief The side of a stop request that makes it.
+ *
+ * Hand out tokens with @ref token, and call @ref request_stop once the work
+ * should stop. Copies of a source share the same state.
+ */
+class stop_source_t
+{
+  public:
+    stop_source_t() : m_state{std::make_shared<std::atomic<bool>>(false)}
+    {
+    }
+
+    /**
+     * @brief Returns a token that sees the requests made through this source.
+     */
+    auto token() const noexcept -> stop_token_t
+    {
+        return stop_token_t{m_state};
+    }
+
+    /**
+     * @brief Asks the work to stop. Asking more than once does nothing.
+     */
+    auto request_stop() noexcept -> void
+    {
+        m_state->store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Checks if stopping has been asked for.
+     */
+    auto stop_requested() const noexcept -> bool
+    {
+        return m_state->load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::shared_ptr<std::atomic<bool>> m_state;
+};
+
+/**
+ * @brief A point in time by which some work has to be done.
+ */
+class deadline_t
+{
+  public:
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * @brief Creates a deadline that never passes.
+     */
+    constexpr deadline_t() noexcept = default;
+
+    /**
+     * @brief Creates a deadline at the given point in time.
+     */
+    constexpr explicit deadline_t(clock_t::time_point p_time) noexcept
+        : m_time{p_time}
+    {
+    }
+
+    /**
+     * @brief Creates a deadline that never passes.
+     */
+    static constexpr auto never() noexcept -> deadline_t
+    {
+        return deadline_t{};
+    }
+
+    /**
+     * @brief Creates a deadline that passes once the duration is up.
+     */
+    template <typename Rep, typename Period>
+    static auto after(std::chrono::duration<Rep, Period> duration) noexcept
+        -> deadline_t
+    {
+        // Checked in the caller's units first, so that converting can't
+        // overflow.
+        using duration_t = std::chrono::duration<Rep, Period>;
+        const auto longest =
+            std::chrono::duration_cast<duration_t>(clock_t::duration::max());
+        if (duration >= longest)
+        {
+            return never();
+        }
+
+        const auto now = clock_t::now();
+        const auto delta = std::chrono::ceil<clock_t::duration>(duration);
+        if (delta >= clock_t::time_point::max() - now)
+        {
+            return never();
+        }
+
+        return deadline_t{now + delta};
+    }
+
+    /**
+     * @brief Checks if this deadline never passes, which can be done without
+     * reading the clock.
+     */
+    constexpr auto is_never() const noexcept -> bool
+    {
+        return m_time == clock_t::time_point::max();
+    }
+
+    /**
+     * @brief Checks if the deadline has passed.
+     */
+    auto expired() const noexcept -> bool
+    {
+        return !is_never() && clock_t::now() >= m_time;
+    }
+
+    /**
+     * @brief Returns how much time is left, which is zero once the deadline
+     * has passed.
+     */
+    auto remaining() const noexcept -> clock_t::duration
+    {
+        if (is_never())
+        {
+            return clock_t::duration::max();
+        }
+
+        const auto now = clock_t::now();
+        return m_time > now ? m_time - now : clock_t::duration::zero();
+    }
+
+    /**
+     * @brief Returns the point in time of the deadline.
+     */
+    constexpr auto time() const noexcept -> clock_t::time_point
+    {
+        return m_time;
+    }
+
+  private:
+    clock_t::time_point m_time = clock_t::time_point::max();
+};
+
+/**
+ * @brief Checks if work should go on, and returns why not if it shouldn't.
+ *
+ * The token is checked first, since that doesn't need to read the clock.
+ */
+inline auto check_cancelled(
+    const stop_token_t& token,
+    const deadline_t& deadline = deadline_t::never()
+) noexcept -> result_t<empty_t, cancel_error_t>
+{
+    using result = result_t<empty_t, cancel_error_t>;
+
+    if (token.stop_requested())
+    {
+        return result::error({cancel_error_t::kind_t::cancelled});
+    }
+
+    if (deadline.expired())
+    {
+        return result::error({cancel_error_t::kind_t::timed_out});
+    }
+
+    return result::success();
+}
+} // namespace kirho
@@ -0,0 +1,276 @@
+/**
+ * @file checked_span.hpp
+ * @brief Spans that check their bounds, unless you tell them not to.
+ *
+ * Contains @ref kirho::checked_span_t, a view of an array whose element
+ * accesses return errors instead of reading past the end. The checks can be
+ * turned off for builds where every last instruction counts, without changing
+ * any of the code that uses it.
+ */
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "kirho.hpp"
+
+// Whether checked_span_t checks its bounds unless told otherwise. It follows
+// NDEBUG, like assert does, but can be defined to override that.
+#ifndef KIRHO_CHECK_BOUNDS
+#ifdef NDEBUG
+#define KIRHO_CHECK_BOUNDS 0
+#else
+#define KIRHO_CHECK_BOUNDS 1
+#endif
+#endif
+
+namespace kirho
+{
+/**
+ * @brief The error for when an index is past the end of a span.
+ */
+struct out_of_bounds_t
+{
+    /**
+     * @brief The index that was asked for. For subspans, this is where the
+     * subspan would have ended.
+     */
+    std::size_t index = 0;
+
+    /**
+     * @brief The size of the span.
+     */
+    std::size_t size = 0;
+
+    auto operator==(const out_of_bounds_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const out_of_bounds_t& error)
+    -> std::ostream&
+{
+    return stream << "index " << error.index << " is out of bounds for size "
+                  << error.size;
+}
+
+/**
+ * @brief The bounds policy that actually checks.
+ */
+struct checked_bounds_t
+{
+    static constexpr auto checks = true;
+};
+
+/**
+ * @brief The bounds policy that assumes that every index is in bounds.
+ *
+ * Nothing is checked, and the compiler is told that the index is in bounds,
+ * so an index that isn't is undefined behaviour, just like with a raw pointer.
+ */
+struct assumed_bounds_t
+{
+    static constexpr auto checks = false;
+};
+
+/**
+ * @brief The bounds policy that @ref checked_span_t uses by default, which
+ * depends on @ref KIRHO_CHECK_BOUNDS.
+ */
+using default_bounds_t = std::conditional_t<
+    KIRHO_CHECK_BOUNDS != 0,
+    checked_bounds_t,
+    assumed_bounds_t>;
+
+/**
+ * @brief The things that can be used as a bounds policy.
+ */
+template <typename P>
+concept bounds_policy_t = requires {
+    {
+        P::checks
+    } -> std::convertible_to<bool>;
+};
+
+/**
+ * @brief A view of an array that checks its bounds.
+ *
+ * Everything that takes an index returns a result, so that the code that uses
+ * it has to deal with the index being out of bounds. With @ref
+ * assumed_bounds_t, those results are always successes, and once the
+ * compiler sees through them, what's left is plain pointer arithmetic.
+ *
+ * @tparam T The type of the elements, which can be const.
+ * @tparam P The bounds policy.
+ */
+template <typename T, bounds_policy_t P = default_bounds_t>
+class checked_span_t
+{
+  public:
+    using element_type = T;
+    using iterator = typename std::span<T>::iterator;
+
+    /**
+     * @brief Creates an empty span.
+     */
+    checked_span_t() noexcept = default;
+
+    /**
+     * @brief Creates a span of the given elements.
+     */
+    checked_span_t(T* p_data, std::size_t p_size) noexcept
+        : m_span{p_data, p_size}
+    {
+    }
+
+    /**
+     * @brief Creates a span of anything that a `std::span` can be made from,
+     * such as a vector or an array.
+     */
+    template <typename R>
+        requires std::convertible_to<R, std::span<T>>
+    checked_span_t(R&& range) noexcept : m_span{std::forward<R>(range)}
+    {
+    }
+
+    /**
+     * @brief Returns a reference to the element at the index.
+     */
+    auto at(std::size_t index) const noexcept
+        -> result_t<std::reference_wrapper<T>, out_of_bounds_t>
+    {
+        using result = result_t<std::reference_wrapper<T>, out_of_bounds_t>;
+
+        if (!in_bounds(index, size()))
+        {
+            return result::error({index, size()});
+        }
+
+        return result::success(std::ref(m_span.data()[index]));
+    }
+
+    /**
+     * @brief Returns a reference to the element at the index, and panics if
+     * it's out of bounds.
+     *
+     * This is for when an index being out of bounds is a bug, not something
+     * that needs to be dealt with.
+     */
+    auto operator[](std::size_t index) const noexcept -> T&
+    {
+        if (!in_bounds(index, size()))
+        {
+            std::cerr << "kirho: "
+                      << out_of_bounds_t{index, size()} << ".\n";
+            std::terminate();
+        }
+
+        return m_span.data()[index];
+    }
+
+    /**
+     * @brief Returns the part of the span that starts at the offset and has
+     * the given number of elements, or goes until the end if there's no
+     * count.
+     */
+    auto subspan_checked(
+        std::size_t offset,
+        std::size_t count = std::dynamic_extent
+    ) const noexcept -> result_t<checked_span_t, out_of_bounds_t>
+    {
+        using result = result_t<checked_span_t, out_of_bounds_t>;
+
+        if (!in_bounds(offset, size() + 1))
+        {
+            return result::error({offset, size()});
+        }
+
+        if (count == std::dynamic_extent)
+        {
+            count = size() - offset;
+        }
+
+        // Checked this way around so that huge counts can't wrap around.
+        if (!in_bounds(count, size() - offset + 1))
+        {
+            return result::error({offset + count, size()});
+        }
+
+        return result::success(checked_span_t{m_span.data() + offset, count});
+    }
+
+    /**
+     * @brief Returns the number of elements.
+     */
+    auto size() const noexcept -> std::size_t
+    {
+        return m_span.size();
+    }
+
+    /**
+     * @brief Checks if there are no elements.
+     */
+    auto empty() const noexcept -> bool
+    {
+        return m_span.empty();
+    }
+
+    /**
+     * @brief Returns a pointer to the first element.
+     */
+    auto data() const noexcept -> T*
+    {
+        return m_span.data();
+    }
+
+    auto begin() const noexcept -> iterator
+    {
+        return m_span.begin();
+    }
+
+    auto end() const noexcept -> iterator
+    {
+        return m_span.end();
+    }
+
+    /**
+     * @brief Returns the elements as a plain `std::span`.
+     */
+    auto span() const noexcept -> std::span<T>
+    {
+        return m_span;
+    }
+
+  private:
+    static auto in_bounds(std::size_t index, std::size_t size) noexcept -> bool
+    {
+        if constexpr (P::checks)
+        {
+            return index < size;
+        }
+        else
+        {
+            if (index >= size)
+            {
+                __builtin_unreachable();
+            }
+
+            return true;
+        }
+    }
+
+  private:
+    std::span<T> m_span;
+};
+
+template <typename R>
+checked_span_t(R&&) -> checked_span_t<
+    std::remove_reference_t<std::ranges::range_reference_t<R>>>;
+} // namespace kirho
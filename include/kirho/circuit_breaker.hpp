@@ -0,0 +1,431 @@
+/**
+ * @file circuit_breaker.hpp
+ * @brief Failing fast when something keeps failing.
+ *
+ * Contains @ref kirho::circuit_breaker_t, which wraps calls to something that
+ * can fail, such as a disk cache or another subsystem, and stops making those
+ * calls for a while once too many of them fail, so that the threads making
+ * them get an error right away instead of waiting on timeouts.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The error for calls that weren't made, because the circuit was open.
+ */
+struct circuit_open_t
+{
+    using duration_t = std::chrono::steady_clock::duration;
+
+    /**
+     * @brief How long until calls are let through again, at least as a probe.
+     */
+    duration_t retry_after = duration_t::zero();
+
+    auto operator==(const circuit_open_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const circuit_open_t& error)
+    -> std::ostream&
+{
+    return stream << "circuit open, retry after "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         error.retry_after
+                     )
+                         .count()
+                  << "ms";
+}
+
+/**
+ * @brief The settings of a @ref circuit_breaker_t.
+ */
+struct circuit_breaker_options_t
+{
+    using duration_t = std::chrono::steady_clock::duration;
+
+    /**
+     * @brief The share of failed calls in the window at which the circuit
+     * opens.
+     */
+    double failure_ratio = 0.5;
+
+    /**
+     * @brief The number of calls that there have to be in the window before
+     * the circuit can open, so that a couple of early failures don't open it.
+     */
+    std::uint32_t minimum_calls = 20;
+
+    /**
+     * @brief How far back calls are counted.
+     */
+    duration_t window = std::chrono::seconds{10};
+
+    /**
+     * @brief The number of parts that the window is split into. Calls fall
+     * out of the window one part at a time.
+     */
+    std::size_t buckets = 10;
+
+    /**
+     * @brief How long the circuit stays open before probing.
+     */
+    duration_t open_duration = std::chrono::seconds{5};
+
+    /**
+     * @brief The number of probes in a row that have to succeed for the
+     * circuit to close again.
+     */
+    std::uint32_t probes = 3;
+};
+
+/**
+ * @brief Watches the calls that are made through it, and stops letting them
+ * through once too many of them fail.
+ *
+ * While the circuit is closed, calls go through, and their outcomes are
+ * counted in a sliding window, made of buckets that each pack the time they
+ * belong to, the number of calls, and the number of failures into one atomic
+ * word. Once the share of failures crosses the threshold, the circuit opens,
+ * and calls fail right away. After a while, it's half open, and calls are let
+ * through one at a time as probes. If enough of those succeed in a row, the
+ * circuit closes again, and if one of them fails, it opens again.
+ *
+ * While the circuit is closed, checking whether a call can go through is a
+ * single load, and counting how it went is a compare-and-swap on one bucket.
+ * Only failures add up the whole window, to see whether it should open.
+ */
+class circuit_breaker_t
+{
+  public:
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * @brief The state of the circuit.
+     */
+    enum class state_t : std::uint32_t
+    {
+        /// Calls go through.
+        closed,
+        /// Calls fail right away.
+        open,
+        /// The next call goes through as a probe.
+        half_open,
+        /// A probe is under way, and other calls fail right away.
+        probing,
+    };
+
+    /**
+     * @brief Creates a closed circuit.
+     */
+    explicit circuit_breaker_t(circuit_breaker_options_t p_options = {})
+        : m_options{p_options}, m_start{clock_t::now()}
+    {
+        if (m_options.buckets == 0)
+        {
+            m_options.buckets = 1;
+        }
+
+        m_bucket_width = std::max<std::uint64_t>(
+            nanoseconds(m_options.window) / m_options.buckets, 1
+        );
+        m_buckets =
+            std::make_unique<std::atomic<std::uint64_t>[]>(m_options.buckets);
+    }
+
+    circuit_breaker_t(const circuit_breaker_t&) = delete;
+    circuit_breaker_t& operator=(const circuit_breaker_t&) = delete;
+
+    /**
+     * @brief Calls the function, unless the circuit is open.
+     *
+     * Errors from the function count as failures, and so do exceptions,
+     * which are let through afterwards.
+     *
+     * @param f The function, which takes no arguments and returns a result.
+     *
+     * @return The result of the function, or why it wasn't called.
+     */
+    template <typename F, typename R = std::invoke_result_t<F&>>
+    auto call(F&& f) -> result_t<R, circuit_open_t>
+    {
+        using result = result_t<R, circuit_open_t>;
+
+        auto probe = false;
+        const auto status = m_status.load(std::memory_order_acquire);
+        if (state_of(status) != state_t::closed) [[unlikely]]
+        {
+            auto error = circuit_open_t{};
+            switch (admit(status, error))
+            {
+            case admission_t::reject:
+                return result::error(error);
+            case admission_t::probe:
+                probe = true;
+                break;
+            case admission_t::call:
+                break;
+            }
+        }
+
+        // Exceptions leave this as it is, so they count as failures.
+        auto failed = true;
+        defer(recorded, record(probe, failed));
+
+        auto outcome = f();
+        auto error = typename R::error_type{};
+        failed = outcome.is_error(error);
+        return result::success(std::move(outcome));
+    }
+
+    /**
+     * @brief Returns the state of the circuit.
+     */
+    auto state() const noexcept -> state_t
+    {
+        return state_of(m_status.load(std::memory_order_acquire));
+    }
+
+  private:
+    // The layout of a bucket: which bucket of time it's for, then the number
+    // of calls, then the number of failures.
+    static constexpr auto count_bits = 20;
+    static constexpr auto count_mask = (std::uint64_t{1} << count_bits) - 1;
+    static constexpr auto epoch_shift = 2 * count_bits;
+    static constexpr auto epoch_mask =
+        (std::uint64_t{1} << (64 - epoch_shift)) - 1;
+
+    // The layout of the status: the state of the circuit, then the time it
+    // last opened, so that the two of them always change together.
+    static constexpr auto state_bits = 2;
+    static constexpr auto state_mask = (std::uint64_t{1} << state_bits) - 1;
+
+    static auto pack(state_t state, std::uint64_t opened_at) noexcept
+        -> std::uint64_t
+    {
+        return (opened_at << state_bits) | static_cast<std::uint64_t>(state);
+    }
+
+    static auto state_of(std::uint64_t status) noexcept -> state_t
+    {
+        return static_cast<state_t>(status & state_mask);
+    }
+
+    static auto opened_at(std::uint64_t status) noexcept -> std::uint64_t
+    {
+        return status >> state_bits;
+    }
+
+    template <typename D>
+    static auto nanoseconds(D duration) noexcept -> std::uint64_t
+    {
+        const auto count =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+                .count();
+        return count > 0 ? static_cast<std::uint64_t>(count) : 0;
+    }
+
+    auto elapsed() const noexcept -> std::uint64_t
+    {
+        return nanoseconds(clock_t::now() - m_start);
+    }
+
+    enum class admission_t
+    {
+        call,
+        probe,
+        reject,
+    };
+
+    // Decides what happens to a call while the circuit isn't closed.
+    auto admit(std::uint64_t status, circuit_open_t& error) noexcept
+        -> admission_t
+    {
+        const auto now = elapsed();
+        for (;;)
+        {
+            switch (state_of(status))
+            {
+            case state_t::closed:
+                // It closed again in the meantime.
+                return admission_t::call;
+            case state_t::probing:
+                error = circuit_open_t{};
+                return admission_t::reject;
+            case state_t::open:
+            {
+                const auto reopens_at =
+                    opened_at(status) + nanoseconds(m_options.open_duration);
+                if (now < reopens_at)
+                {
+                    error = circuit_open_t{
+                        std::chrono::nanoseconds{reopens_at - now}
+                    };
+                    return admission_t::reject;
+                }
+                break;
+            }
+            case state_t::half_open:
+                break;
+            }
+
+            if (m_status.compare_exchange_weak(
+                    status,
+                    pack(state_t::probing, opened_at(status)),
+                    std::memory_order_acquire
+                ))
+            {
+                return admission_t::probe;
+            }
+        }
+    }
+
+    auto record(bool probe, bool failed) noexcept -> void
+    {
+        if (probe)
+        {
+            finish_probe(failed);
+            return;
+        }
+
+        add(failed);
+        if (failed && tripped())
+        {
+            open(state_t::closed);
+        }
+    }
+
+    auto finish_probe(bool failed) noexcept -> void
+    {
+        if (failed)
+        {
+            m_probe_successes.store(0, std::memory_order_relaxed);
+            open(state_t::probing);
+            return;
+        }
+
+        const auto successes =
+            m_probe_successes.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (successes < m_options.probes)
+        {
+            leave_probing(state_t::half_open);
+            return;
+        }
+
+        // Start over with a clean window, or else the failures from before
+        // would open the circuit again right away.
+        m_probe_successes.store(0, std::memory_order_relaxed);
+        for (auto i = std::size_t{0}; i < m_options.buckets; i++)
+        {
+            m_buckets[i].store(0, std::memory_order_relaxed);
+        }
+        leave_probing(state_t::closed);
+    }
+
+    // Only the probe can move the circuit on while it's probing, since
+    // everything else waits for another state, so this doesn't need a
+    // compare-and-swap.
+    auto leave_probing(state_t state) noexcept -> void
+    {
+        const auto status = m_status.load(std::memory_order_relaxed);
+        m_status.store(
+            pack(state, opened_at(status)), std::memory_order_release
+        );
+    }
+
+    // Only opens the circuit if it's still in the state that the caller saw,
+    // since a call that was let through while it was closed can fail after
+    // it has already opened, and that mustn't push back when it reopens.
+    auto open(state_t from) noexcept -> void
+    {
+        auto status = m_status.load(std::memory_order_relaxed);
+        if (state_of(status) != from)
+        {
+            return;
+        }
+
+        m_status.compare_exchange_strong(
+            status, pack(state_t::open, elapsed()), std::memory_order_release
+        );
+    }
+
+    auto add(bool failed) noexcept -> void
+    {
+        const auto index = elapsed() / m_bucket_width;
+        const auto epoch = index & epoch_mask;
+        auto& bucket = m_buckets[index % m_options.buckets];
+
+        auto word = bucket.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto calls = std::uint64_t{0};
+            auto failures = std::uint64_t{0};
+            if (word >> epoch_shift == epoch)
+            {
+                calls = (word >> count_bits) & count_mask;
+                failures = word & count_mask;
+            }
+
+            // Full buckets stop counting, which keeps the ratio about right.
+            if (calls == count_mask)
+            {
+                return;
+            }
+
+            const auto next = (epoch << epoch_shift) |
+                              ((calls + 1) << count_bits) |
+                              (failures + (failed ? 1 : 0));
+            if (bucket.compare_exchange_weak(
+                    word, next, std::memory_order_relaxed
+                ))
+            {
+                return;
+            }
+        }
+    }
+
+    auto tripped() const noexcept -> bool
+    {
+        const auto index = elapsed() / m_bucket_width;
+        auto calls = std::uint64_t{0};
+        auto failures = std::uint64_t{0};
+        for (auto i = std::size_t{0}; i < m_options.buckets; i++)
+        {
+            const auto word = m_buckets[i].load(std::memory_order_relaxed);
+            const auto age = (index - (word >> epoch_shift)) & epoch_mask;
+            if (age < m_options.buckets)
+            {
+                calls += (word >> count_bits) & count_mask;
+                failures += word & count_mask;
+            }
+        }
+
+        return calls >= m_options.minimum_calls &&
+               static_cast<double>(failures) >=
+                   m_options.failure_ratio * static_cast<double>(calls);
+    }
+
+  private:
+    circuit_breaker_options_t m_options;
+    clock_t::time_point m_start;
+    std::uint64_t m_bucket_width = 1;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> m_buckets;
+    std::atomic<std::uint64_t> m_status = pack(state_t::closed, 0);
+    std::atomic<std::uint32_t> m_probe_successes = 0;
+};
+} // namespace kirho
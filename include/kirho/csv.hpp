@@ -0,0 +1,551 @@
+/**
+ * @file csv.hpp
+ * @brief Reading CSV files without copying them.
+ *
+ * Contains @ref kirho::csv_reader_t, which splits CSV text into rows and
+ * fields. The fields point straight into the text, so for big files, you'll
+ * want to map them into memory with @ref kirho::mapped_file_t and hand the
+ * reader the view of that.
+ */
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Whether we can use x86 vector instructions that the compiler wasn't told to
+// use, and check for them at runtime instead. Define it to 0 to always use the
+// scalar code.
+#ifndef KIRHO_X86_SIMD
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KIRHO_X86_SIMD 1
+#else
+#define KIRHO_X86_SIMD 0
+#endif
+#endif
+
+#if KIRHO_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The reason why a row could not be read.
+ */
+struct csv_error_t
+{
+    /**
+     * @brief The kinds of things that can be wrong with a row.
+     */
+    enum class kind_t
+    {
+        /// A quoted field is still open at the end of the text.
+        unterminated_quote,
+        /// There is a quote in the middle of a field that isn't quoted.
+        unexpected_quote,
+        /// There is something between the closing quote and the end of the
+        /// field.
+        text_after_quote,
+    };
+
+    /**
+     * @brief The line that the problem is on, starting at 1.
+     */
+    std::size_t line = 0;
+
+    /**
+     * @brief The column that the problem is in, starting at 1.
+     *
+     * Columns are counted in bytes, not characters.
+     */
+    std::size_t column = 0;
+
+    /**
+     * @brief What the problem is.
+     */
+    kind_t kind = kind_t::unterminated_quote;
+
+    auto operator==(const csv_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const csv_error_t& error)
+    -> std::ostream&
+{
+    stream << "line " << error.line << ", column " << error.column << ": ";
+
+    switch (error.kind)
+    {
+    case csv_error_t::kind_t::unterminated_quote:
+        return stream << "quoted field is never closed";
+    case csv_error_t::kind_t::unexpected_quote:
+        return stream << "quote inside of an unquoted field";
+    case csv_error_t::kind_t::text_after_quote:
+        return stream << "text after the closing quote";
+    }
+
+    return stream;
+}
+
+/**
+ * @brief Turns a field from @ref csv_reader_t into the text it stands for.
+ *
+ * The reader leaves doubled quotes in quoted fields as they are, so that it
+ * doesn't have to copy anything. Fields without quotes in them don't need
+ * this.
+ */
+inline auto csv_unescape(std::string_view field) -> std::string
+{
+    auto text = std::string{};
+    text.reserve(field.size());
+
+    for (auto i = std::size_t{0}; i < field.size(); i++)
+    {
+        text += field[i];
+        if (field[i] == '"')
+        {
+            i++;
+        }
+    }
+
+    return text;
+}
+
+namespace detail
+{
+// The interesting characters in a block of 64 bytes, one bit per byte.
+struct csv_masks_t
+{
+    std::uint64_t quotes = 0;
+    std::uint64_t delimiters = 0;
+    std::uint64_t newlines = 0;
+};
+
+using csv_kernel_t = csv_masks_t (*)(const char*, char);
+
+inline auto csv_masks_scalar(const char* block, char delimiter) -> csv_masks_t
+{
+    auto masks = csv_masks_t{};
+    for (auto i = 0; i < 64; i++)
+    {
+        const auto bit = std::uint64_t{1} << i;
+        masks.quotes |= block[i] == '"' ? bit : 0;
+        masks.delimiters |= block[i] == delimiter ? bit : 0;
+        masks.newlines |= block[i] == '\n' ? bit : 0;
+    }
+
+    return masks;
+}
+
+#if KIRHO_X86_SIMD
+// Puts the result of a movemask at the right place in a 64 bit mask.
+inline auto csv_bits(int mask, int shift) noexcept -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(mask))
+           << shift;
+}
+
+// SSE2 is always there on x86-64, so this one needs no checking.
+inline auto csv_masks_sse2(const char* block, char delimiter) -> csv_masks_t
+{
+    const auto quote = _mm_set1_epi8('"');
+    const auto separator = _mm_set1_epi8(delimiter);
+    const auto newline = _mm_set1_epi8('\n');
+
+    auto masks = csv_masks_t{};
+    for (auto i = 0; i < 4; i++)
+    {
+        const auto chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        masks.quotes |=
+            csv_bits(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)), i * 16);
+        masks.delimiters |= csv_bits(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, separator)), i * 16
+        );
+        masks.newlines |=
+            csv_bits(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)), i * 16);
+    }
+
+    return masks;
+}
+
+__attribute__((target("avx2"))) inline auto csv_masks_avx2(
+    const char* block,
+    char delimiter
+) -> csv_masks_t
+{
+    const auto quote = _mm256_set1_epi8('"');
+    const auto separator = _mm256_set1_epi8(delimiter);
+    const auto newline = _mm256_set1_epi8('\n');
+
+    auto masks = csv_masks_t{};
+    for (auto i = 0; i < 2; i++)
+    {
+        const auto chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(block + i * 32)
+        );
+        masks.quotes |= csv_bits(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)), i * 32
+        );
+        masks.delimiters |= csv_bits(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, separator)), i * 32
+        );
+        masks.newlines |= csv_bits(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)), i * 32
+        );
+    }
+
+    return masks;
+}
+#endif
+
+inline auto select_csv_kernel() noexcept -> csv_kernel_t
+{
+#if KIRHO_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return csv_masks_avx2;
+    }
+
+    return csv_masks_sse2;
+#else
+    return csv_masks_scalar;
+#endif
+}
+
+// Sets every bit from a quote up to the next one, which is what marks the
+// inside of quoted fields. Doubled quotes flip it twice, so they don't matter.
+inline auto prefix_xor(std::uint64_t bits) noexcept -> std::uint64_t
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+} // namespace detail
+
+/**
+ * @brief Splits CSV text into rows of fields.
+ *
+ * The text is scanned 64 bytes at a time, turning the quotes, delimiters and
+ * newlines into bitmasks with vector instructions, and working out which of
+ * them are inside of quoted fields with a bit of arithmetic on those masks.
+ * That's the same idea as the first stage of simdjson. Rows are then just a
+ * matter of walking from one set bit to the next.
+ *
+ * Fields are views into the text, so the text has to outlive them. Quoted
+ * fields come without their surrounding quotes, but with any doubled quotes
+ * still in there, see @ref csv_unescape. Lines can end in either `\n` or
+ * `\r\n`.
+ *
+ * Large inputs that don't fit into memory can be read in chunks. Pass false
+ * for `last` with every chunk but the last, and the reader will stop at the
+ * last complete row instead of treating the end of the chunk as the end of
+ * the file. The bytes from @ref consumed on have to be put in front of the
+ * next chunk.
+ */
+class csv_reader_t
+{
+  public:
+    /**
+     * @brief Creates a reader for the text.
+     *
+     * @param text The CSV text, or the first chunk of it.
+     * @param delimiter The character between fields.
+     * @param last Whether the text is the end of the input.
+     */
+    explicit csv_reader_t(
+        std::string_view text = {},
+        char delimiter = ',',
+        bool last = true
+    ) noexcept
+        : m_delimiter{delimiter}
+    {
+        reset(text, last);
+    }
+
+    /**
+     * @brief Carries on with the next chunk of the input.
+     *
+     * Line numbers carry on from where the previous chunk left off.
+     */
+    auto reset(std::string_view text, bool last = true) noexcept -> void
+    {
+        m_text = text;
+        m_last = last;
+        m_row_start = 0;
+        m_block = 0;
+        m_next_block = 0;
+        m_structurals = 0;
+        m_quotes = 0;
+        m_inside = 0;
+        m_failed = false;
+    }
+
+    /**
+     * @brief Reads the next row.
+     *
+     * The fields stay valid until the next call, or for as long as the text
+     * does, if you keep your own copies of the views.
+     *
+     * There's no telling where the next row starts after a malformed one, so
+     * the reader stops after reporting an error.
+     *
+     * @return The fields of the row, which are empty once there are no more
+     * complete rows, or the reason why the row is malformed.
+     */
+    auto read_row() -> result_t<std::span<const std::string_view>, csv_error_t>
+    {
+        using result = result_t<std::span<const std::string_view>, csv_error_t>;
+
+        if (m_failed || m_row_start >= m_text.size())
+        {
+            return result::success({});
+        }
+
+        m_fields.clear();
+        auto start = m_row_start;
+        auto newlines = std::size_t{0};
+        for (;;)
+        {
+            auto end = next_structural();
+            if (end == npos)
+            {
+                // A row that runs into the end of a chunk might carry on in
+                // the next one.
+                if (!m_last)
+                {
+                    return result::success({});
+                }
+
+                end = m_text.size();
+            }
+
+            const auto at_newline = end < m_text.size() && m_text[end] == '\n';
+            auto field = std::string_view{};
+            auto error = csv_error_t{};
+            const auto outcome = check_field(start, end, at_newline, newlines);
+            if (outcome.is_error(error))
+            {
+                m_failed = true;
+                return result::error(error);
+            }
+            outcome.is_success(field);
+            m_fields.push_back(field);
+
+            if (end == m_text.size() || at_newline)
+            {
+                m_line += 1 + newlines;
+                m_row_start = end + 1;
+                return result::success(m_fields);
+            }
+
+            start = end + 1;
+        }
+    }
+
+    /**
+     * @brief Returns how much of the text the complete rows took up.
+     */
+    auto consumed() const noexcept -> std::size_t
+    {
+        return std::min(m_row_start, m_text.size());
+    }
+
+    /**
+     * @brief Returns the line that the next row starts on.
+     */
+    auto line() const noexcept -> std::size_t
+    {
+        return m_line;
+    }
+
+  private:
+    static constexpr auto npos = std::string_view::npos;
+
+    // Returns the offset of the next delimiter or newline that isn't inside of
+    // quotes, or npos once there are none left.
+    auto next_structural() noexcept -> std::size_t
+    {
+        while (m_structurals == 0)
+        {
+            if (m_next_block >= m_text.size())
+            {
+                return npos;
+            }
+
+            load_block();
+        }
+
+        const auto bit = std::countr_zero(m_structurals);
+        m_structurals &= m_structurals - 1;
+        return m_block + static_cast<std::size_t>(bit);
+    }
+
+    auto load_block() noexcept -> void
+    {
+        static const auto kernel = detail::select_csv_kernel();
+
+        m_block = m_next_block;
+        m_next_block += 64;
+
+        // The last block is copied so that the kernel can read all of it.
+        const auto remaining = m_text.size() - m_block;
+        auto masks = detail::csv_masks_t{};
+        auto valid = ~std::uint64_t{0};
+        if (remaining >= 64)
+        {
+            masks = kernel(m_text.data() + m_block, m_delimiter);
+        }
+        else
+        {
+            char block[64] = {};
+            std::memcpy(block, m_text.data() + m_block, remaining);
+            masks = kernel(block, m_delimiter);
+            valid = (std::uint64_t{1} << remaining) - 1;
+        }
+
+        m_quotes = masks.quotes & valid;
+        const auto inside = detail::prefix_xor(m_quotes) ^ m_inside;
+        m_inside = static_cast<std::uint64_t>(
+            -static_cast<std::int64_t>(inside >> 63)
+        );
+        m_structurals = (masks.delimiters | masks.newlines) & ~inside & valid;
+    }
+
+    // Looks for a quote between the two offsets, using the mask when they're
+    // both in the current block.
+    auto find_quote(std::size_t start, std::size_t end) const noexcept
+        -> std::size_t
+    {
+        if (start == end)
+        {
+            return npos;
+        }
+
+        if (start >= m_block && end <= m_block + 64)
+        {
+            const auto length = end - start;
+            const auto range = length == 64 ? ~std::uint64_t{0}
+                                            : (std::uint64_t{1} << length) - 1;
+            const auto quotes = (m_quotes >> (start - m_block)) & range;
+            return quotes == 0 ? npos
+                               : start + static_cast<std::size_t>(
+                                             std::countr_zero(quotes)
+                                         );
+        }
+
+        const auto quote = m_text.substr(start, end - start).find('"');
+        return quote == npos ? npos : start + quote;
+    }
+
+    auto check_field(
+        std::size_t start,
+        std::size_t end,
+        bool at_newline,
+        std::size_t& newlines
+    ) const noexcept -> result_t<std::string_view, csv_error_t>
+    {
+        using result = result_t<std::string_view, csv_error_t>;
+        using kind_t = csv_error_t::kind_t;
+
+        auto content_end = end;
+        if (at_newline && content_end > start && m_text[end - 1] == '\r')
+        {
+            content_end--;
+        }
+
+        if (start == content_end || m_text[start] != '"')
+        {
+            const auto quote = find_quote(start, content_end);
+            if (quote != npos)
+            {
+                return result::error(error_at(quote, kind_t::unexpected_quote));
+            }
+
+            return result::success(
+                m_text.substr(start, content_end - start)
+            );
+        }
+
+        for (auto position = start + 1;;)
+        {
+            const auto quote = m_text.find('"', position);
+            if (quote == npos || quote >= content_end)
+            {
+                return result::error(
+                    error_at(start, kind_t::unterminated_quote)
+                );
+            }
+
+            if (quote + 1 < content_end && m_text[quote + 1] == '"')
+            {
+                position = quote + 2;
+                continue;
+            }
+
+            if (quote + 1 != content_end)
+            {
+                return result::error(
+                    error_at(quote + 1, kind_t::text_after_quote)
+                );
+            }
+
+            const auto content = m_text.substr(start + 1, quote - start - 1);
+            newlines += static_cast<std::size_t>(
+                std::count(content.begin(), content.end(), '\n')
+            );
+            return result::success(content);
+        }
+    }
+
+    auto error_at(std::size_t offset, csv_error_t::kind_t kind) const noexcept
+        -> csv_error_t
+    {
+        const auto before = m_text.substr(0, offset);
+        const auto row = before.substr(m_row_start);
+        const auto line_start = before.rfind('\n');
+
+        return {
+            m_line + static_cast<std::size_t>(
+                         std::count(row.begin(), row.end(), '\n')
+                     ),
+            offset - (line_start == npos ? 0 : line_start + 1) + 1,
+            kind,
+        };
+    }
+
+  private:
+    std::string_view m_text;
+    char m_delimiter;
+    bool m_last = true;
+    bool m_failed = false;
+    std::size_t m_line = 1;
+    std::size_t m_row_start = 0;
+    std::vector<std::string_view> m_fields;
+
+    // The state of the scan. The masks belong to the block at m_block, and
+    // m_inside is all ones if that block ends inside of quotes.
+    std::size_t m_block = 0;
+    std::size_t m_next_block = 0;
+    std::uint64_t m_structurals = 0;
+    std::uint64_t m_quotes = 0;
+    std::uint64_t m_inside = 0;
+};
+} // namespace kirho
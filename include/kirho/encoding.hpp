@@ -0,0 +1,973 @@
+/**
+ * @file encoding.hpp
+ * @brief Base64 and hexadecimal encoding and decoding.
+ *
+ * Contains the @ref kirho::base64 and @ref kirho::hex namespaces, which turn
+ * binary data into text and back. Nothing in here allocates, as everything is
+ * written into buffers that you provide. On x86-64 processors, the work is
+ * done with SSSE3 or AVX2 instructions, depending on what the processor
+ * supports.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+// Whether we can use x86 vector instructions that the compiler wasn't told to
+// use, and check for them at runtime instead. Define it to 0 to always use the
+// scalar code.
+#ifndef KIRHO_X86_SIMD
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KIRHO_X86_SIMD 1
+#else
+#define KIRHO_X86_SIMD 0
+#endif
+#endif
+
+#if KIRHO_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The reason why some text could not be decoded.
+ */
+struct decode_error_t
+{
+    /**
+     * @brief The kinds of things that can go wrong while decoding.
+     */
+    enum class kind_t
+    {
+        /// There is a character that isn't part of the alphabet.
+        invalid_character,
+        /// The text has a length that no encoded data can have.
+        invalid_length,
+        /// The output buffer is too small for the decoded data.
+        output_too_small,
+    };
+
+    /**
+     * @brief The offset of the invalid character.
+     *
+     * For the other kinds of errors, this is the length of the text.
+     */
+    std::size_t offset = 0;
+
+    /**
+     * @brief What went wrong.
+     */
+    kind_t kind = kind_t::invalid_character;
+
+    auto operator==(const decode_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const decode_error_t& error)
+    -> std::ostream&
+{
+    switch (error.kind)
+    {
+    case decode_error_t::kind_t::invalid_character:
+        return stream << "invalid character at offset " << error.offset;
+    case decode_error_t::kind_t::invalid_length:
+        return stream << "invalid length " << error.offset;
+    case decode_error_t::kind_t::output_too_small:
+        return stream << "output buffer too small";
+    }
+
+    return stream;
+}
+
+namespace detail
+{
+[[noreturn]] inline auto encode_buffer_too_small() noexcept -> void
+{
+    std::cerr << "kirho: the output buffer is too small for the encoding.\n";
+    std::terminate();
+}
+
+inline constexpr char base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+inline constexpr char hex_alphabet[] = "0123456789abcdef";
+
+// Maps every byte to its value in the alphabet, or 0xFF if it isn't in there.
+inline constexpr auto base64_values = []() {
+    auto values = std::array<std::uint8_t, 256>{};
+    values.fill(0xFF);
+    for (auto i = 0; i < 64; i++)
+    {
+        values[static_cast<unsigned char>(base64_alphabet[i])] =
+            static_cast<std::uint8_t>(i);
+    }
+    return values;
+}();
+
+inline constexpr auto hex_values = []() {
+    auto values = std::array<std::uint8_t, 256>{};
+    values.fill(0xFF);
+    for (auto i = 0; i < 10; i++)
+    {
+        values['0' + i] = static_cast<std::uint8_t>(i);
+    }
+    for (auto i = 0; i < 6; i++)
+    {
+        values['a' + i] = static_cast<std::uint8_t>(10 + i);
+        values['A' + i] = static_cast<std::uint8_t>(10 + i);
+    }
+    return values;
+}();
+
+// The kernels work through as many whole blocks as they can, and return how
+// much of the input they got through. Decoding kernels stop at the first block
+// with something wrong in it, and leave it to the scalar code to work out what
+// that is. They also write a little past the end of the data that they
+// produce, so they're only given the part of the output that the data goes in,
+// and only run while there's room for that in there.
+using encode_kernel_t =
+    std::size_t (*)(const unsigned char*, std::size_t, char*);
+using decode_kernel_t = std::size_t (*)(
+    const char*,
+    std::size_t,
+    unsigned char*,
+    std::size_t
+);
+
+struct encoding_kernels_t
+{
+    encode_kernel_t base64_encode;
+    decode_kernel_t base64_decode;
+    encode_kernel_t hex_encode;
+    decode_kernel_t hex_decode;
+};
+
+inline auto scalar_encode_kernel(const unsigned char*, std::size_t, char*)
+    -> std::size_t
+{
+    return 0;
+}
+
+inline auto scalar_decode_kernel(
+    const char*,
+    std::size_t,
+    unsigned char*,
+    std::size_t
+) -> std::size_t
+{
+    return 0;
+}
+
+#if KIRHO_X86_SIMD
+// The base64 kernels follow "Faster Base64 Encoding and Decoding Using AVX2
+// Instructions" by Wojciech Muła and Daniel Lemire.
+__attribute__((target("ssse3"))) inline auto base64_encode_ssse3(
+    const unsigned char* input,
+    std::size_t size,
+    char* output
+) -> std::size_t
+{
+    auto position = std::size_t{0};
+
+    // Twelve bytes become sixteen characters, but sixteen bytes are loaded.
+    for (; size - position >= 16; position += 12, output += 16)
+    {
+        auto in = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(input + position)
+        );
+
+        // Spread the three bytes of every group over four lanes, and move the
+        // six bits of each character to the bottom of its lane.
+        in = _mm_shuffle_epi8(
+            in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1)
+        );
+        const auto high = _mm_mulhi_epu16(
+            _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)),
+            _mm_set1_epi32(0x04000040)
+        );
+        const auto low = _mm_mullo_epi16(
+            _mm_and_si128(in, _mm_set1_epi32(0x003F03F0)),
+            _mm_set1_epi32(0x01000010)
+        );
+        const auto indices = _mm_or_si128(high, low);
+
+        // Turn the indices into characters by adding an offset that depends
+        // on which range of the alphabet they are in.
+        auto range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const auto is_upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(is_upper, _mm_set1_epi8(13)));
+        const auto offsets = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+            '/' - 63, 'A', 0, 0
+        );
+        const auto characters =
+            _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), characters);
+    }
+
+    return position;
+}
+
+__attribute__((target("avx2"))) inline auto base64_encode_avx2(
+    const unsigned char* input,
+    std::size_t size,
+    char* output
+) -> std::size_t
+{
+    auto position = std::size_t{0};
+
+    // Each lane gets twelve bytes, loaded as sixteen.
+    for (; size - position >= 28; position += 24, output += 32)
+    {
+        const auto low_lane = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(input + position)
+        );
+        const auto high_lane = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(input + position + 12)
+        );
+        auto in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(low_lane), high_lane, 1
+        );
+
+        in = _mm256_shuffle_epi8(
+            in,
+            _mm256_set_epi8(
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1
+            )
+        );
+        const auto high = _mm256_mulhi_epu16(
+            _mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)),
+            _mm256_set1_epi32(0x04000040)
+        );
+        const auto low = _mm256_mullo_epi16(
+            _mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)),
+            _mm256_set1_epi32(0x01000010)
+        );
+        const auto indices = _mm256_or_si256(high, low);
+
+        auto range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const auto is_upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(
+            range, _mm256_and_si256(is_upper, _mm256_set1_epi8(13))
+        );
+        const auto offsets = _mm256_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+            '/' - 63, 'A', 0, 0,
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+            '/' - 63, 'A', 0, 0
+        );
+        const auto characters =
+            _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), characters);
+    }
+
+    return position;
+}
+
+__attribute__((target("ssse3"))) inline auto base64_decode_ssse3(
+    const char* input,
+    std::size_t size,
+    unsigned char* output,
+    std::size_t output_size
+) -> std::size_t
+{
+    // Every character is classified by its two nibbles. A character is valid
+    // if the bits that come out of the two lookups have nothing in common.
+    const auto low_classes = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+    );
+    const auto high_classes = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+    );
+    const auto offsets = _mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+    );
+    const auto nibble = _mm_set1_epi8(0x0F);
+    const auto zero = _mm_setzero_si128();
+
+    auto position = std::size_t{0};
+    auto written = std::size_t{0};
+    for (; size - position >= 16 && output_size - written >= 16;
+         position += 16, written += 12)
+    {
+        const auto in = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(input + position)
+        );
+        const auto high_nibbles =
+            _mm_and_si128(_mm_srli_epi32(in, 4), nibble);
+        const auto low_nibbles = _mm_and_si128(in, nibble);
+
+        const auto invalid = _mm_and_si128(
+            _mm_shuffle_epi8(low_classes, low_nibbles),
+            _mm_shuffle_epi8(high_classes, high_nibbles)
+        );
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, zero)) != 0xFFFF)
+        {
+            break;
+        }
+
+        // '/' is the only character that shares its high nibble with
+        // another range, so it gets its own offset.
+        const auto is_slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+        const auto values = _mm_add_epi8(
+            in,
+            _mm_shuffle_epi8(offsets, _mm_add_epi8(is_slash, high_nibbles))
+        );
+
+        // Glue the six bit values back together into bytes.
+        const auto pairs =
+            _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const auto groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        const auto bytes = _mm_shuffle_epi8(
+            groups,
+            _mm_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+            )
+        );
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + written), bytes);
+    }
+
+    return position;
+}
+
+__attribute__((target("avx2"))) inline auto base64_decode_avx2(
+    const char* input,
+    std::size_t size,
+    unsigned char* output,
+    std::size_t output_size
+) -> std::size_t
+{
+    const auto low_classes = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+    );
+    const auto high_classes = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+    );
+    const auto offsets = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+    );
+    const auto nibble = _mm256_set1_epi8(0x0F);
+
+    auto position = std::size_t{0};
+    auto written = std::size_t{0};
+    for (; size - position >= 32 && output_size - written >= 32;
+         position += 32, written += 24)
+    {
+        const auto in = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(input + position)
+        );
+        const auto high_nibbles =
+            _mm256_and_si256(_mm256_srli_epi32(in, 4), nibble);
+        const auto low_nibbles = _mm256_and_si256(in, nibble);
+
+        const auto low = _mm256_shuffle_epi8(low_classes, low_nibbles);
+        const auto high = _mm256_shuffle_epi8(high_classes, high_nibbles);
+        if (!_mm256_testz_si256(low, high))
+        {
+            break;
+        }
+
+        const auto is_slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+        const auto values = _mm256_add_epi8(
+            in,
+            _mm256_shuffle_epi8(
+                offsets, _mm256_add_epi8(is_slash, high_nibbles)
+            )
+        );
+
+        const auto pairs =
+            _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        const auto groups =
+            _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        const auto packed = _mm256_shuffle_epi8(
+            groups,
+            _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+            )
+        );
+
+        // Each lane has twelve bytes at the bottom, which have to be put
+        // next to each other.
+        const auto bytes = _mm256_permutevar8x32_epi32(
+            packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7)
+        );
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(output + written), bytes
+        );
+    }
+
+    return position;
+}
+
+__attribute__((target("ssse3"))) inline auto hex_encode_ssse3(
+    const unsigned char* input,
+    std::size_t size,
+    char* output
+) -> std::size_t
+{
+    const auto digits = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(hex_alphabet)
+    );
+    const auto nibble = _mm_set1_epi8(0x0F);
+
+    auto position = std::size_t{0};
+    for (; size - position >= 16; position += 16, output += 32)
+    {
+        const auto in = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(input + position)
+        );
+        const auto high = _mm_shuffle_epi8(
+            digits, _mm_and_si128(_mm_srli_epi16(in, 4), nibble)
+        );
+        const auto low = _mm_shuffle_epi8(digits, _mm_and_si128(in, nibble));
+
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi8(high, low)
+        );
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(output + 16),
+            _mm_unpackhi_epi8(high, low)
+        );
+    }
+
+    return position;
+}
+
+__attribute__((target("avx2"))) inline auto hex_encode_avx2(
+    const unsigned char* input,
+    std::size_t size,
+    char* output
+) -> std::size_t
+{
+    const auto digits = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex_alphabet))
+    );
+    const auto nibble = _mm256_set1_epi8(0x0F);
+
+    auto position = std::size_t{0};
+    for (; size - position >= 32; position += 32, output += 64)
+    {
+        const auto in = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(input + position)
+        );
+        const auto high = _mm256_shuffle_epi8(
+            digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble)
+        );
+        const auto low =
+            _mm256_shuffle_epi8(digits, _mm256_and_si256(in, nibble));
+
+        // Interleaving only works within lanes, so the halves end up in the
+        // wrong place and have to be swapped around.
+        const auto first = _mm256_unpacklo_epi8(high, low);
+        const auto second = _mm256_unpackhi_epi8(high, low);
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(output),
+            _mm256_permute2x128_si256(first, second, 0x20)
+        );
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(output + 32),
+            _mm256_permute2x128_si256(first, second, 0x31)
+        );
+    }
+
+    return position;
+}
+
+// Turns sixteen hex digits into their values, and clears valid if any of them
+// isn't a hex digit.
+__attribute__((target("ssse3"))) inline auto hex_values_ssse3(
+    __m128i in,
+    bool& valid
+) -> __m128i
+{
+    const auto digit = _mm_sub_epi8(in, _mm_set1_epi8('0'));
+    const auto is_digit =
+        _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+
+    // Setting the 0x20 bit makes upper case letters lower case, and doesn't
+    // turn anything else into a lower case hex digit.
+    const auto letter = _mm_sub_epi8(
+        _mm_or_si128(in, _mm_set1_epi8(0x20)), _mm_set1_epi8('a')
+    );
+    const auto is_letter =
+        _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    valid = valid &&
+            _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) == 0xFFFF;
+
+    return _mm_or_si128(
+        _mm_and_si128(is_digit, digit),
+        _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10)))
+    );
+}
+
+__attribute__((target("ssse3"))) inline auto hex_decode_ssse3(
+    const char* input,
+    std::size_t size,
+    unsigned char* output,
+    std::size_t output_size
+) -> std::size_t
+{
+    auto position = std::size_t{0};
+    auto written = std::size_t{0};
+    for (; size - position >= 32 && output_size - written >= 16;
+         position += 32, written += 16)
+    {
+        auto valid = true;
+        const auto first = hex_values_ssse3(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + position)),
+            valid
+        );
+        const auto second = hex_values_ssse3(
+            _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(input + position + 16)
+            ),
+            valid
+        );
+        if (!valid)
+        {
+            break;
+        }
+
+        // Multiply the first digit of every pair by 16 and add the second.
+        const auto weights = _mm_set1_epi16(0x0110);
+        const auto bytes = _mm_packus_epi16(
+            _mm_maddubs_epi16(first, weights),
+            _mm_maddubs_epi16(second, weights)
+        );
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + written), bytes);
+    }
+
+    return position;
+}
+
+__attribute__((target("avx2"))) inline auto hex_values_avx2(
+    __m256i in,
+    bool& valid
+) -> __m256i
+{
+    const auto digit = _mm256_sub_epi8(in, _mm256_set1_epi8('0'));
+    const auto is_digit =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+
+    const auto letter = _mm256_sub_epi8(
+        _mm256_or_si256(in, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a')
+    );
+    const auto is_letter =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+
+    valid = valid &&
+            _mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) == -1;
+
+    return _mm256_or_si256(
+        _mm256_and_si256(is_digit, digit),
+        _mm256_and_si256(
+            is_letter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))
+        )
+    );
+}
+
+__attribute__((target("avx2"))) inline auto hex_decode_avx2(
+    const char* input,
+    std::size_t size,
+    unsigned char* output,
+    std::size_t output_size
+) -> std::size_t
+{
+    auto position = std::size_t{0};
+    auto written = std::size_t{0};
+    for (; size - position >= 64 && output_size - written >= 32;
+         position += 64, written += 32)
+    {
+        auto valid = true;
+        const auto first = hex_values_avx2(
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(input + position)
+            ),
+            valid
+        );
+        const auto second = hex_values_avx2(
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(input + position + 32)
+            ),
+            valid
+        );
+        if (!valid)
+        {
+            break;
+        }
+
+        // Packing works within lanes as well, so the middle two quarters
+        // have to be swapped afterwards.
+        const auto weights = _mm256_set1_epi16(0x0110);
+        const auto packed = _mm256_packus_epi16(
+            _mm256_maddubs_epi16(first, weights),
+            _mm256_maddubs_epi16(second, weights)
+        );
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(output + written),
+            _mm256_permute4x64_epi64(packed, 0xD8)
+        );
+    }
+
+    return position;
+}
+#endif
+
+inline auto select_encoding_kernels() noexcept -> encoding_kernels_t
+{
+#if KIRHO_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {
+            base64_encode_avx2,
+            base64_decode_avx2,
+            hex_encode_avx2,
+            hex_decode_avx2,
+        };
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return {
+            base64_encode_ssse3,
+            base64_decode_ssse3,
+            hex_encode_ssse3,
+            hex_decode_ssse3,
+        };
+    }
+#endif
+
+    return {
+        scalar_encode_kernel,
+        scalar_decode_kernel,
+        scalar_encode_kernel,
+        scalar_decode_kernel,
+    };
+}
+
+inline auto encoding_kernels() noexcept -> const encoding_kernels_t&
+{
+    static const auto kernels = select_encoding_kernels();
+    return kernels;
+}
+
+inline auto base64_encode_with(
+    encode_kernel_t kernel,
+    std::span<const std::byte> input,
+    std::span<char> output
+) noexcept -> std::size_t
+{
+    const auto size = (input.size() + 2) / 3 * 4;
+    if (output.size() < size)
+    {
+        encode_buffer_too_small();
+    }
+
+    const auto in = reinterpret_cast<const unsigned char*>(input.data());
+    auto out = output.data();
+
+    // The kernel writes sixteen characters for every twelve bytes, so it
+    // never writes past what the whole thing needs.
+    auto position = kernel(in, input.size(), out);
+    out += position / 3 * 4;
+
+    for (; input.size() - position >= 3; position += 3, out += 4)
+    {
+        const auto group = static_cast<std::uint32_t>(in[position]) << 16 |
+                           static_cast<std::uint32_t>(in[position + 1]) << 8 |
+                           in[position + 2];
+        out[0] = base64_alphabet[(group >> 18) & 0x3F];
+        out[1] = base64_alphabet[(group >> 12) & 0x3F];
+        out[2] = base64_alphabet[(group >> 6) & 0x3F];
+        out[3] = base64_alphabet[group & 0x3F];
+    }
+
+    const auto remaining = input.size() - position;
+    if (remaining > 0)
+    {
+        auto group = static_cast<std::uint32_t>(in[position]) << 16;
+        if (remaining == 2)
+        {
+            group |= static_cast<std::uint32_t>(in[position + 1]) << 8;
+        }
+
+        out[0] = base64_alphabet[(group >> 18) & 0x3F];
+        out[1] = base64_alphabet[(group >> 12) & 0x3F];
+        out[2] = remaining == 2 ? base64_alphabet[(group >> 6) & 0x3F] : '=';
+        out[3] = '=';
+    }
+
+    return size;
+}
+
+inline auto base64_decode_with(
+    decode_kernel_t kernel,
+    std::string_view input,
+    std::span<std::byte> output
+) noexcept -> result_t<std::size_t, decode_error_t>
+{
+    using result = result_t<std::size_t, decode_error_t>;
+    using kind_t = decode_error_t::kind_t;
+
+    // Padding is optional, but if it's there, it has to be right.
+    auto size = input.size();
+    if (size % 4 == 0 && size > 0 && input[size - 1] == '=')
+    {
+        size -= input[size - 2] == '=' ? 2 : 1;
+    }
+    if (size % 4 == 1)
+    {
+        return result::error({input.size(), kind_t::invalid_length});
+    }
+
+    const auto decoded_size = size / 4 * 3 + (size % 4 == 0 ? 0 : size % 4 - 1);
+    if (output.size() < decoded_size)
+    {
+        return result::error({input.size(), kind_t::output_too_small});
+    }
+
+    const auto out = reinterpret_cast<unsigned char*>(output.data());
+    auto position = kernel(input.data(), size, out, decoded_size);
+    auto written = position / 4 * 3;
+
+    for (; position < size; position += 4)
+    {
+        const auto count = size - position < 4 ? size - position : 4;
+        auto group = std::uint32_t{0};
+        for (auto i = std::size_t{0}; i < count; i++)
+        {
+            const auto value =
+                base64_values[static_cast<unsigned char>(input[position + i])];
+            if (value == 0xFF)
+            {
+                return result::error({position + i, kind_t::invalid_character});
+            }
+
+            group |= static_cast<std::uint32_t>(value) << (18 - 6 * i);
+        }
+
+        for (auto i = std::size_t{0}; i + 1 < count; i++)
+        {
+            out[written++] = static_cast<unsigned char>(group >> (16 - 8 * i));
+        }
+    }
+
+    return result::success(decoded_size);
+}
+
+inline auto hex_encode_with(
+    encode_kernel_t kernel,
+    std::span<const std::byte> input,
+    std::span<char> output
+) noexcept -> std::size_t
+{
+    if (output.size() < input.size() * 2)
+    {
+        encode_buffer_too_small();
+    }
+
+    const auto in = reinterpret_cast<const unsigned char*>(input.data());
+    auto position = kernel(in, input.size(), output.data());
+
+    for (; position < input.size(); position++)
+    {
+        output[position * 2] = hex_alphabet[in[position] >> 4];
+        output[position * 2 + 1] = hex_alphabet[in[position] & 0x0F];
+    }
+
+    return input.size() * 2;
+}
+
+inline auto hex_decode_with(
+    decode_kernel_t kernel,
+    std::string_view input,
+    std::span<std::byte> output
+) noexcept -> result_t<std::size_t, decode_error_t>
+{
+    using result = result_t<std::size_t, decode_error_t>;
+    using kind_t = decode_error_t::kind_t;
+
+    if (input.size() % 2 != 0)
+    {
+        return result::error({input.size(), kind_t::invalid_length});
+    }
+    if (output.size() < input.size() / 2)
+    {
+        return result::error({input.size(), kind_t::output_too_small});
+    }
+
+    const auto out = reinterpret_cast<unsigned char*>(output.data());
+    auto position =
+        kernel(input.data(), input.size(), out, input.size() / 2);
+
+    for (; position < input.size(); position += 2)
+    {
+        const auto high =
+            hex_values[static_cast<unsigned char>(input[position])];
+        const auto low =
+            hex_values[static_cast<unsigned char>(input[position + 1])];
+        if (high == 0xFF)
+        {
+            return result::error({position, kind_t::invalid_character});
+        }
+        if (low == 0xFF)
+        {
+            return result::error({position + 1, kind_t::invalid_character});
+        }
+
+        out[position / 2] = static_cast<unsigned char>(high << 4 | low);
+    }
+
+    return result::success(input.size() / 2);
+}
+} // namespace detail
+
+/**
+ * @brief Base64 encoding, with the standard alphabet from RFC 4648.
+ */
+namespace base64
+{
+/**
+ * @brief Returns the number of characters that the data encodes to, including
+ * the padding.
+ */
+constexpr auto encoded_size(std::size_t size) noexcept -> std::size_t
+{
+    return (size + 2) / 3 * 4;
+}
+
+/**
+ * @brief Returns the largest number of bytes that the text could decode to.
+ */
+constexpr auto decoded_size(std::size_t size) noexcept -> std::size_t
+{
+    return (size + 3) / 4 * 3;
+}
+
+/**
+ * @brief Encodes the data into the output, with padding.
+ *
+ * The output has to be at least @ref encoded_size long, or else we panic.
+ *
+ * @return The number of characters that were written.
+ */
+inline auto encode(
+    std::span<const std::byte> input,
+    std::span<char> output
+) noexcept -> std::size_t
+{
+    return detail::base64_encode_with(
+        detail::encoding_kernels().base64_encode, input, output
+    );
+}
+
+/**
+ * @brief Decodes the text into the output.
+ *
+ * The padding at the end is optional, but no whitespace is allowed anywhere.
+ * The output has to be big enough for the decoded data, which is never more
+ * than @ref decoded_size. Nothing after the decoded data is touched, but if the
+ * text turns out not to be base64, some of where the data would have gone may
+ * have been written to.
+ *
+ * @return The number of bytes that were written, or the reason why the text
+ * isn't base64.
+ */
+inline auto decode(std::string_view input, std::span<std::byte> output) noexcept
+    -> result_t<std::size_t, decode_error_t>
+{
+    return detail::base64_decode_with(
+        detail::encoding_kernels().base64_decode, input, output
+    );
+}
+} // namespace base64
+
+/**
+ * @brief Hexadecimal encoding.
+ */
+namespace hex
+{
+/**
+ * @brief Returns the number of characters that the data encodes to.
+ */
+constexpr auto encoded_size(std::size_t size) noexcept -> std::size_t
+{
+    return size * 2;
+}
+
+/**
+ * @brief Returns the number of bytes that the text decodes to.
+ */
+constexpr auto decoded_size(std::size_t size) noexcept -> std::size_t
+{
+    return size / 2;
+}
+
+/**
+ * @brief Encodes the data into the output, in lower case.
+ *
+ * The output has to be at least @ref encoded_size long, or else we panic.
+ *
+ * @return The number of characters that were written.
+ */
+inline auto encode(
+    std::span<const std::byte> input,
+    std::span<char> output
+) noexcept -> std::size_t
+{
+    return detail::hex_encode_with(
+        detail::encoding_kernels().hex_encode, input, output
+    );
+}
+
+/**
+ * @brief Decodes the text into the output.
+ *
+ * Both upper and lower case digits are accepted. Nothing after the decoded data
+ * is touched, but if the text turns out not to be hexadecimal, some of where
+ * the data would have gone may have been written to.
+ *
+ * @return The number of bytes that were written, or the reason why the text
+ * isn't hexadecimal.
+ */
+inline auto decode(std::string_view input, std::span<std::byte> output) noexcept
+    -> result_t<std::size_t, decode_error_t>
+{
+    return detail::hex_decode_with(
+        detail::encoding_kernels().hex_decode, input, output
+    );
+}
+} // namespace hex
+} // namespace kirho
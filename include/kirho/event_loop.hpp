@@ -0,0 +1,798 @@
+/**
+ * @file event_loop.hpp
+ * @brief A coroutine event loop built on top of epoll.
+ *
+ * Contains @ref kirho::event_loop_t, which lets you write code that reads from
+ * and writes to sockets and pipes as if it were blocking, while it actually
+ * runs on a single thread. Every operation reports its outcome as a
+ * @ref kirho::result_t, so no exceptions are involved anywhere. This is Linux
+ * only, as it is built on top of epoll.
+ */
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "cancel.hpp"
+#include "kirho.hpp"
+#include "sys.hpp"
+
+namespace kirho
+{
+/**
+ * @brief A coroutine that starts running right away and cleans up after
+ * itself.
+ *
+ * This is the return type for the coroutines that you run on an
+ * @ref event_loop_t. Calling the coroutine starts it immediately, and it runs
+ * until it has to wait on something, at which point the call returns. The loop
+ * resumes it later, and the coroutine frame is freed once it finishes. Since
+ * nobody waits on it, it cannot return anything, so report your errors some
+ * other way.
+ */
+struct detached_task_t
+{
+    struct promise_type
+    {
+        auto get_return_object() noexcept -> detached_task_t
+        {
+            return {};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto return_void() noexcept -> void
+        {
+        }
+
+        auto unhandled_exception() noexcept -> void
+        {
+            std::terminate();
+        }
+    };
+};
+
+/**
+ * @brief A single threaded event loop that resumes coroutines once the file
+ * descriptors that they are waiting on become ready.
+ *
+ * The file descriptors that you pass to it have to be in non-blocking mode (see
+ * @ref sys::set_nonblocking). Operations are first attempted right away, and
+ * the loop is only involved when they would block, so a read from a socket that
+ * already has data in it never touches epoll. Only one operation can be waiting
+ * on a file descriptor at any given time.
+ *
+ * Timers are kept in a hierarchical timer wheel with a resolution of one
+ * millisecond, which makes adding a timer and firing it constant time, no
+ * matter how many of them there are.
+ *
+ * Operations can be given a @ref deadline_t and a @ref stop_token_t. Both are
+ * checked before the operation is first attempted, and an operation that has
+ * to wait is given up on once its deadline passes, with `ETIMEDOUT`, or once
+ * it's asked to stop, with `ECANCELED`. Asking to stop doesn't wake the loop
+ * up by itself, so while any of the waiting operations could be stopped, the
+ * loop wakes up every few milliseconds to check on them.
+ */
+class event_loop_t
+{
+  public:
+    /**
+     * @brief Creates a new event loop.
+     *
+     * @return The event loop, or the error if the epoll instance could not be
+     * created.
+     */
+    static auto create() noexcept -> result_t<event_loop_t, sys_error_t>
+    {
+        using result = result_t<event_loop_t, sys_error_t>;
+
+        const auto epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll < 0)
+        {
+            return result::error(sys_error_t::from_errno());
+        }
+
+        return result::success(event_loop_t{sys::fd_t{epoll}});
+    }
+
+    event_loop_t(event_loop_t&&) noexcept = default;
+    event_loop_t& operator=(event_loop_t&&) noexcept = default;
+
+  private:
+    class io_waiter_t;
+
+    // Timers that belong to an operation give up on it when they fire,
+    // instead of resuming a coroutine. The level and slot are where the timer
+    // is in the wheel, so that it can be taken out again.
+    struct timer_node_t
+    {
+        std::uint64_t expiry;
+        std::coroutine_handle<> handle;
+        timer_node_t* next;
+        io_waiter_t* waiter = nullptr;
+        int level = 0;
+        std::uint64_t slot = 0;
+    };
+
+    // The part of a suspended operation that the loop knows about. The awaiter
+    // lives in the coroutine frame, so the loop doesn't have to allocate
+    // anything to keep track of it.
+    class io_waiter_t
+    {
+      public:
+        // Attempts the operation, and returns false if it would block.
+        virtual auto attempt() noexcept -> bool = 0;
+
+        // Checks if the operation has been asked to stop.
+        virtual auto stop_requested() const noexcept -> bool = 0;
+
+        // Gives up on the operation, because its deadline has passed, or it
+        // has been asked to stop.
+        virtual auto give_up(int error) noexcept -> void = 0;
+
+        std::coroutine_handle<> handle;
+        int fd;
+        std::uint32_t events;
+        timer_node_t* timer = nullptr;
+
+        // The operations that could be asked to stop are linked together, so
+        // that the loop can check on them while they wait.
+        bool stoppable = false;
+        io_waiter_t* previous_stoppable = nullptr;
+        io_waiter_t* next_stoppable = nullptr;
+
+      protected:
+        ~io_waiter_t() = default;
+    };
+
+  public:
+    /**
+     * @brief An awaitable I/O operation.
+     *
+     * This is what the `async_` functions return. When you `co_await` it, you
+     * get a `result_t<T, sys_error_t>` with the outcome of the operation.
+     */
+    template <typename T, typename F>
+    class io_awaitable_t : private io_waiter_t
+    {
+      public:
+        io_awaitable_t(
+            event_loop_t& p_loop,
+            int p_fd,
+            std::uint32_t p_events,
+            F p_call,
+            deadline_t p_deadline,
+            stop_token_t p_token
+        )
+            : m_loop{p_loop},
+              m_call{p_call},
+              m_deadline{p_deadline},
+              m_token{std::move(p_token)}
+        {
+            this->fd = p_fd;
+            this->events = p_events;
+        }
+
+        io_awaitable_t(const io_awaitable_t&) = delete;
+        io_awaitable_t& operator=(const io_awaitable_t&) = delete;
+
+        auto await_ready() noexcept -> bool
+        {
+            auto error = cancel_error_t{};
+            if (check_cancelled(m_token, m_deadline).is_error(error))
+            {
+                m_result = -1;
+                m_error = error.kind == cancel_error_t::kind_t::cancelled
+                              ? ECANCELED
+                              : ETIMEDOUT;
+                return true;
+            }
+
+            return attempt();
+        }
+
+        auto await_suspend(std::coroutine_handle<> p_handle) noexcept -> bool
+        {
+            this->handle = p_handle;
+            if (!m_loop.arm(*this))
+            {
+                m_result = -1;
+                m_error = errno;
+                return false;
+            }
+
+            if (!m_deadline.is_never())
+            {
+                m_timer.expiry = m_loop.tick_of(m_deadline);
+                m_timer.waiter = this;
+                this->timer = &m_timer;
+                m_loop.add_timer(m_timer);
+            }
+
+            if (m_token.stop_possible())
+            {
+                m_loop.link_stoppable(*this);
+            }
+
+            m_loop.m_pending_io++;
+            return true;
+        }
+
+        auto await_resume() noexcept -> result_t<T, sys_error_t>
+        {
+            using result = result_t<T, sys_error_t>;
+
+            if (m_result < 0)
+            {
+                return result::error(sys_error_t{m_error});
+            }
+
+            if constexpr (std::is_same_v<T, sys::fd_t>)
+            {
+                return result::success(sys::fd_t{static_cast<int>(m_result)});
+            }
+            else
+            {
+                return result::success(static_cast<T>(m_result));
+            }
+        }
+
+      private:
+        auto attempt() noexcept -> bool override
+        {
+            m_result = sys::retry_on_eintr(m_call);
+            if (m_result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                return false;
+            }
+
+            m_error = errno;
+            return true;
+        }
+
+        auto stop_requested() const noexcept -> bool override
+        {
+            return m_token.stop_requested();
+        }
+
+        auto give_up(int error) noexcept -> void override
+        {
+            m_result = -1;
+            m_error = error;
+        }
+
+      private:
+        event_loop_t& m_loop;
+        F m_call;
+        deadline_t m_deadline;
+        stop_token_t m_token;
+        timer_node_t m_timer{0, {}, nullptr};
+        long m_result = 0;
+        int m_error = 0;
+    };
+
+    /**
+     * @brief An awaitable that completes once a certain amount of time has
+     * passed.
+     */
+    class timer_awaitable_t
+    {
+      public:
+        timer_awaitable_t(event_loop_t& p_loop, std::uint64_t p_expiry)
+            : m_loop{p_loop}, m_node{p_expiry, {}, nullptr}
+        {
+        }
+
+        auto await_ready() const noexcept -> bool
+        {
+            return m_node.expiry <= m_loop.current_tick();
+        }
+
+        auto await_suspend(std::coroutine_handle<> p_handle) noexcept -> void
+        {
+            m_node.handle = p_handle;
+            m_loop.add_timer(m_node);
+        }
+
+        auto await_resume() const noexcept -> void
+        {
+        }
+
+      private:
+        event_loop_t& m_loop;
+        timer_node_t m_node;
+    };
+
+    /**
+     * @brief Reads from the file descriptor into the buffer.
+     *
+     * `co_await` the returned value to get the number of bytes that were read,
+     * which is zero at the end of the stream.
+     */
+    auto async_read(
+        const sys::fd_t& fd,
+        std::span<std::byte> buffer,
+        deadline_t deadline = deadline_t::never(),
+        stop_token_t token = {}
+    ) noexcept
+    {
+        const auto call = [fd = fd.get(), buffer]() noexcept {
+            return ::read(fd, buffer.data(), buffer.size());
+        };
+
+        return io_awaitable_t<std::size_t, decltype(call)>{
+            *this, fd.get(), EPOLLIN, call, deadline, std::move(token)
+        };
+    }
+
+    /**
+     * @brief Writes the buffer to the file descriptor.
+     *
+     * `co_await` the returned value to get the number of bytes that were
+     * written, which might be less than the size of the buffer.
+     */
+    auto async_write(
+        const sys::fd_t& fd,
+        std::span<const std::byte> buffer,
+        deadline_t deadline = deadline_t::never(),
+        stop_token_t token = {}
+    ) noexcept
+    {
+        // send is the only way to not get killed by SIGPIPE when the other
+        // side goes away, but it only works on sockets, so pipes need to go
+        // through write instead.
+        const auto call = [fd = fd.get(), buffer]() noexcept {
+            const auto count =
+                ::send(fd, buffer.data(), buffer.size(), MSG_NOSIGNAL);
+            if (count < 0 && errno == ENOTSOCK)
+            {
+                return ::write(fd, buffer.data(), buffer.size());
+            }
+
+            return count;
+        };
+
+        return io_awaitable_t<std::size_t, decltype(call)>{
+            *this, fd.get(), EPOLLOUT, call, deadline, std::move(token)
+        };
+    }
+
+    /**
+     * @brief Accepts a connection on the listening socket.
+     *
+     * `co_await` the returned value to get the socket for the new connection,
+     * which is already in non-blocking mode.
+     */
+    auto async_accept(
+        const sys::fd_t& listener,
+        deadline_t deadline = deadline_t::never(),
+        stop_token_t token = {}
+    ) noexcept
+    {
+        const auto call = [fd = listener.get()]() noexcept {
+            return ::accept4(
+                fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC
+            );
+        };
+
+        return io_awaitable_t<sys::fd_t, decltype(call)>{
+            *this, listener.get(), EPOLLIN, call, deadline, std::move(token)
+        };
+    }
+
+    /**
+     * @brief Suspends the coroutine for the specified amount of time.
+     *
+     * The duration is rounded up to the next millisecond, and then one more
+     * is added on top, since the current millisecond is already partly over.
+     * Durations of zero or less complete right away.
+     */
+    template <typename Rep, typename Period>
+    auto sleep_for(std::chrono::duration<Rep, Period> duration) noexcept
+        -> timer_awaitable_t
+    {
+        const auto ticks =
+            std::chrono::ceil<std::chrono::milliseconds>(duration).count();
+        const auto now = current_tick();
+
+        return timer_awaitable_t{
+            *this, ticks > 0 ? now + 1 + static_cast<std::uint64_t>(ticks) : now
+        };
+    }
+
+    /**
+     * @brief Runs the loop until there is nothing left to wait for.
+     *
+     * Coroutines are resumed on the thread that calls this. The loop returns
+     * once no coroutine is waiting on a file descriptor or a timer anymore.
+     *
+     * @return Nothing, or the error if epoll failed.
+     */
+    auto run() noexcept -> result_t<empty_t, sys_error_t>
+    {
+        using result = result_t<empty_t, sys_error_t>;
+
+        auto events = std::array<epoll_event, 64>{};
+        while (true)
+        {
+            advance_timers();
+            check_stops();
+            if (m_pending_io == 0 && m_timer_count == 0)
+            {
+                return result::success();
+            }
+
+            const auto count = ::epoll_wait(
+                m_epoll.get(),
+                events.data(),
+                static_cast<int>(events.size()),
+                next_timeout()
+            );
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                return result::error(sys_error_t::from_errno());
+            }
+
+            for (auto i = 0; i < count; i++)
+            {
+                auto& waiter = *static_cast<io_waiter_t*>(events[i].data.ptr);
+                if (waiter.attempt())
+                {
+                    finish_io(waiter);
+                }
+                else if (!arm(waiter))
+                {
+                    // The operation would block, but we can't wait on it
+                    // either, so the best we can do is to hand epoll's error
+                    // over.
+                    waiter.give_up(errno);
+                    finish_io(waiter);
+                }
+            }
+        }
+    }
+
+  private:
+    static constexpr auto wheel_bits = 6;
+    static constexpr auto wheel_size = std::uint64_t{1} << wheel_bits;
+    static constexpr auto wheel_levels = 4;
+    static constexpr auto wheel_span = std::uint64_t{1}
+                                       << (wheel_bits * wheel_levels);
+
+    // How often the loop wakes up to check on the operations that could be
+    // asked to stop, in milliseconds.
+    static constexpr auto stop_check_interval = 10;
+
+    event_loop_t(sys::fd_t p_epoll) noexcept
+        : m_epoll{std::move(p_epoll)}, m_start{std::chrono::steady_clock::now()}
+    {
+    }
+
+    auto arm(io_waiter_t& waiter) noexcept -> bool
+    {
+        auto event = epoll_event{};
+        event.events = waiter.events | EPOLLONESHOT;
+        event.data.ptr = &waiter;
+
+        // One-shot registrations stay around after they fire, so modifying is
+        // the common case. Adding is only needed the first time around, or
+        // after the file descriptor has been closed and reused.
+        if (::epoll_ctl(m_epoll.get(), EPOLL_CTL_MOD, waiter.fd, &event) == 0)
+        {
+            return true;
+        }
+
+        return errno == ENOENT &&
+               ::epoll_ctl(m_epoll.get(), EPOLL_CTL_ADD, waiter.fd, &event) ==
+                   0;
+    }
+
+    // Resumes an operation that's done, after taking its timer out of the
+    // wheel, since the timer lives in the awaiter.
+    auto finish_io(io_waiter_t& waiter) noexcept -> void
+    {
+        if (waiter.timer != nullptr)
+        {
+            remove_timer(*waiter.timer);
+        }
+
+        unlink_stoppable(waiter);
+        m_pending_io--;
+        waiter.handle.resume();
+    }
+
+    // Stops waiting on the file descriptor of an operation, and resumes it
+    // with the error.
+    auto abandon(io_waiter_t& waiter, int error) noexcept -> void
+    {
+        ::epoll_ctl(m_epoll.get(), EPOLL_CTL_DEL, waiter.fd, nullptr);
+        waiter.give_up(error);
+        finish_io(waiter);
+    }
+
+    auto link_stoppable(io_waiter_t& waiter) noexcept -> void
+    {
+        waiter.stoppable = true;
+        waiter.previous_stoppable = nullptr;
+        waiter.next_stoppable = m_stoppable;
+        if (m_stoppable != nullptr)
+        {
+            m_stoppable->previous_stoppable = &waiter;
+        }
+
+        m_stoppable = &waiter;
+    }
+
+    auto unlink_stoppable(io_waiter_t& waiter) noexcept -> void
+    {
+        if (!waiter.stoppable)
+        {
+            return;
+        }
+
+        waiter.stoppable = false;
+        if (waiter.previous_stoppable != nullptr)
+        {
+            waiter.previous_stoppable->next_stoppable = waiter.next_stoppable;
+        }
+        else
+        {
+            m_stoppable = waiter.next_stoppable;
+        }
+
+        if (waiter.next_stoppable != nullptr)
+        {
+            waiter.next_stoppable->previous_stoppable =
+                waiter.previous_stoppable;
+        }
+    }
+
+    // Gives up on the operations that were asked to stop while they were
+    // waiting. They're all taken out of the list before any of them is
+    // resumed, since resuming them can start new operations.
+    auto check_stops() noexcept -> void
+    {
+        auto* stopped = static_cast<io_waiter_t*>(nullptr);
+        auto* waiter = m_stoppable;
+        while (waiter != nullptr)
+        {
+            auto* next = waiter->next_stoppable;
+            if (waiter->stop_requested())
+            {
+                unlink_stoppable(*waiter);
+                waiter->next_stoppable = stopped;
+                stopped = waiter;
+            }
+
+            waiter = next;
+        }
+
+        while (stopped != nullptr)
+        {
+            waiter = std::exchange(stopped, stopped->next_stoppable);
+            abandon(*waiter, ECANCELED);
+        }
+    }
+
+    auto current_tick() const noexcept -> std::uint64_t
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                .count()
+        );
+    }
+
+    // Returns the first tick at which the deadline has passed.
+    auto tick_of(const deadline_t& deadline) const noexcept -> std::uint64_t
+    {
+        if (deadline.time() <= m_start)
+        {
+            return 0;
+        }
+
+        return static_cast<std::uint64_t>(
+            std::chrono::ceil<std::chrono::milliseconds>(
+                deadline.time() - m_start
+            )
+                .count()
+        );
+    }
+
+    static constexpr auto level_mask(int level) noexcept -> std::uint64_t
+    {
+        return (std::uint64_t{1} << (wheel_bits * level)) - 1;
+    }
+
+    auto add_timer(timer_node_t& node) noexcept -> void
+    {
+        // The wheel doesn't turn while it is empty, so catch up first, or else
+        // the next advance would have to tick through all of that time.
+        if (m_timer_count == 0)
+        {
+            m_now = current_tick();
+        }
+
+        // The slot for the current tick has already been fired, so anything
+        // that is due by now has to go into the next one.
+        if (node.expiry <= m_now)
+        {
+            node.expiry = m_now + 1;
+        }
+
+        m_timer_count++;
+        insert_timer(node);
+    }
+
+    auto insert_timer(timer_node_t& node) noexcept -> void
+    {
+        // Timers too far in the future are parked in the last slot that we
+        // can reach, and are put back in once they get cascaded down.
+        const auto delta = node.expiry > m_now ? node.expiry - m_now : 0;
+        const auto placement =
+            delta < wheel_span ? node.expiry : m_now + wheel_span - 1;
+
+        auto level = 0;
+        while (level < wheel_levels - 1 &&
+               (placement - m_now) >> (wheel_bits * (level + 1)) != 0)
+        {
+            level++;
+        }
+
+        const auto slot =
+            (placement >> (wheel_bits * level)) & (wheel_size - 1);
+        node.next = m_wheel[level][slot];
+        node.level = level;
+        node.slot = slot;
+        m_wheel[level][slot] = &node;
+        m_occupied[level] |= std::uint64_t{1} << slot;
+    }
+
+    // The lists are short, so finding the node in its slot is cheap enough,
+    // and it saves every node a pointer back.
+    auto remove_timer(timer_node_t& node) noexcept -> void
+    {
+        auto link = &m_wheel[node.level][node.slot];
+        while (*link != &node)
+        {
+            link = &(*link)->next;
+        }
+
+        *link = node.next;
+        if (m_wheel[node.level][node.slot] == nullptr)
+        {
+            m_occupied[node.level] &= ~(std::uint64_t{1} << node.slot);
+        }
+
+        m_timer_count--;
+    }
+
+    auto take_slot(int level, std::uint64_t slot) noexcept -> timer_node_t*
+    {
+        m_occupied[level] &= ~(std::uint64_t{1} << slot);
+        return std::exchange(m_wheel[level][slot], nullptr);
+    }
+
+    auto advance_timers() noexcept -> void
+    {
+        const auto target = current_tick();
+        while (m_timer_count > 0 && m_now < target)
+        {
+            m_now++;
+
+            // Move the timers of the higher levels down a level whenever the
+            // lower level wraps around, starting from the highest one.
+            auto wrapped = 0;
+            while (wrapped < wheel_levels - 1 &&
+                   (m_now & level_mask(wrapped + 1)) == 0)
+            {
+                wrapped++;
+            }
+
+            for (auto level = wrapped; level > 0; level--)
+            {
+                const auto slot =
+                    (m_now >> (wheel_bits * level)) & (wheel_size - 1);
+                auto node = take_slot(level, slot);
+                while (node != nullptr)
+                {
+                    insert_timer(*std::exchange(node, node->next));
+                }
+            }
+
+            auto node = take_slot(0, m_now & (wheel_size - 1));
+            while (node != nullptr)
+            {
+                const auto handle = node->handle;
+                const auto waiter = node->waiter;
+                node = node->next;
+                m_timer_count--;
+
+                if (waiter != nullptr)
+                {
+                    // The operation has been waiting for too long. Its timer
+                    // is already out of the wheel.
+                    waiter->timer = nullptr;
+                    abandon(*waiter, ETIMEDOUT);
+                }
+                else
+                {
+                    handle.resume();
+                }
+            }
+        }
+
+    }
+
+    // Returns how long epoll is allowed to sleep for. For timers in the
+    // higher levels, this is when they get cascaded down, which is always
+    // before they expire. It's never longer than the interval at which stop
+    // requests are checked, if there are any operations that could get one.
+    auto next_timeout() const noexcept -> int
+    {
+        const auto limit = m_stoppable != nullptr ? stop_check_interval : -1;
+        if (m_timer_count == 0)
+        {
+            return limit;
+        }
+
+        auto next = ~std::uint64_t{0};
+        for (auto level = 0; level < wheel_levels; level++)
+        {
+            if (m_occupied[level] == 0)
+            {
+                continue;
+            }
+
+            const auto shift = wheel_bits * level;
+            const auto current = (m_now >> shift) & (wheel_size - 1);
+            const auto rotated = std::rotr(
+                m_occupied[level], static_cast<int>((current + 1) % wheel_size)
+            );
+            const auto distance =
+                static_cast<std::uint64_t>(std::countr_zero(rotated)) + 1;
+            const auto tick = ((m_now >> shift) + distance) << shift;
+            next = tick < next ? tick : next;
+        }
+
+        const auto now = current_tick();
+        const auto timeout = next > now ? static_cast<int>(next - now) : 0;
+        return limit >= 0 && timeout > limit ? limit : timeout;
+    }
+
+  private:
+    sys::fd_t m_epoll;
+    std::chrono::steady_clock::time_point m_start;
+    std::size_t m_pending_io = 0;
+    std::size_t m_timer_count = 0;
+    io_waiter_t* m_stoppable = nullptr;
+    std::uint64_t m_now = 0;
+    std::array<std::array<timer_node_t*, wheel_size>, wheel_levels> m_wheel{};
+    std::array<std::uint64_t, wheel_levels> m_occupied{};
+};
+} // namespace kirho
@@ -0,0 +1,373 @@
+/**
+ * @file generator.hpp
+ * @brief Producing fallible items one at a time, only when they are needed.
+ *
+ * Contains @ref kirho::generator_t, a coroutine that yields results, and that
+ * can be iterated over like any other range. This lets readers and parsers be
+ * written as a plain loop that yields every item as it comes, rather than one
+ * that collects all of them into a vector before anyone gets to look at them.
+ */
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+namespace detail
+{
+// Coroutine frames are allocated in blocks of these, so that they are as
+// aligned as anything that comes out of plain new.
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_block_t
+{
+    std::byte bytes[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+};
+
+// Allocates coroutine frames with an allocator, and keeps a copy of it right
+// behind the frame, so that the frame can be given back to the same one.
+template <typename Allocator>
+class frame_allocator_t
+{
+  public:
+    using allocator_t = typename std::allocator_traits<
+        Allocator>::template rebind_alloc<frame_block_t>;
+    using traits_t = std::allocator_traits<allocator_t>;
+
+    static auto allocate(const Allocator& allocator, std::size_t size)
+        -> void*
+    {
+        auto rebound = allocator_t{allocator};
+        const auto blocks = blocks_for(size);
+        auto* frame = std::to_address(traits_t::allocate(rebound, blocks));
+        ::new (static_cast<void*>(stored(frame, size)))
+            allocator_t{std::move(rebound)};
+        return frame;
+    }
+
+    static auto deallocate(void* pointer, std::size_t size) noexcept -> void
+    {
+        auto* frame = static_cast<frame_block_t*>(pointer);
+        auto* allocator = stored(frame, size);
+        auto rebound = std::move(*allocator);
+        allocator->~allocator_t();
+        traits_t::deallocate(rebound, frame, blocks_for(size));
+    }
+
+  private:
+    static constexpr auto block_size = sizeof(frame_block_t);
+
+    static constexpr auto offset_of(std::size_t size) noexcept -> std::size_t
+    {
+        return (size + alignof(allocator_t) - 1) & ~(alignof(allocator_t) - 1);
+    }
+
+    static constexpr auto blocks_for(std::size_t size) noexcept -> std::size_t
+    {
+        return (offset_of(size) + sizeof(allocator_t) + block_size - 1) /
+               block_size;
+    }
+
+    static auto stored(frame_block_t* frame, std::size_t size) noexcept
+        -> allocator_t*
+    {
+        return reinterpret_cast<allocator_t*>(
+            reinterpret_cast<std::byte*>(frame) + offset_of(size)
+        );
+    }
+};
+} // namespace detail
+
+/**
+ * @brief A coroutine that yields results of type `R`, which is a
+ * @ref result_t, and that is iterated over like a range.
+ *
+ * The coroutine doesn't start until the first item is asked for, and runs
+ * only until it yields the next one, so items are produced as they are
+ * iterated over, and not at all if the iteration stops early. Yielded items
+ * aren't copied or moved anywhere. Iterating hands out a reference to the
+ * item right where it was yielded, which stays valid until the iterator is
+ * moved on.
+ *
+ * Coroutine frames come from `Allocator`. A default constructed one is used,
+ * unless the first two arguments of the coroutine are `std::allocator_arg`
+ * and the allocator to use, the same as for `std::generator`. GCC before 14
+ * wrongly warns about mismatched new and delete for coroutines that do the
+ * latter, with `-Wmismatched-new-delete`, which can be turned off for them.
+ *
+ * Exceptions that escape the coroutine come out of whichever iterator
+ * operation resumed it, and the generator is done after that.
+ *
+ * @tparam R The type of the items, which is a `result_t<T, E>`.
+ * @tparam Allocator The allocator for coroutine frames.
+ */
+template <typename R, typename Allocator = std::allocator<std::byte>>
+class generator_t
+{
+  public:
+    using error_type = typename R::error_type;
+
+    struct promise_type
+    {
+        auto get_return_object() noexcept -> generator_t
+        {
+            return generator_t{handle_t::from_promise(*this)};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_always
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_always
+        {
+            return {};
+        }
+
+        // Temporaries live until the end of the co_yield expression, which
+        // is after the coroutine is resumed again, so pointing at them is
+        // fine.
+        auto yield_value(R& item) noexcept -> std::suspend_always
+        {
+            m_item = std::addressof(item);
+            return {};
+        }
+
+        auto yield_value(R&& item) noexcept -> std::suspend_always
+        {
+            m_item = std::addressof(item);
+            return {};
+        }
+
+        auto return_void() noexcept -> void
+        {
+        }
+
+        auto unhandled_exception() noexcept -> void
+        {
+            m_exception = std::current_exception();
+        }
+
+        // Nothing would resume the coroutine if it waited on something.
+        template <typename U>
+        auto await_transform(U&&) = delete;
+
+        static auto operator new(std::size_t size) -> void*
+        {
+            return frame_allocator_t::allocate(Allocator{}, size);
+        }
+
+        template <typename... Args>
+        static auto operator new(
+            std::size_t size,
+            std::allocator_arg_t,
+            const Allocator& allocator,
+            const Args&...
+        ) -> void*
+        {
+            return frame_allocator_t::allocate(allocator, size);
+        }
+
+        static auto operator delete(void* pointer, std::size_t size) noexcept
+            -> void
+        {
+            frame_allocator_t::deallocate(pointer, size);
+        }
+
+        R* m_item = nullptr;
+        std::exception_ptr m_exception;
+    };
+
+    /**
+     * @brief The end of the items.
+     */
+    struct sentinel_t
+    {
+    };
+
+    /**
+     * @brief Goes through the items, resuming the coroutine for every one of
+     * them.
+     */
+    class iterator_t
+    {
+      public:
+        using value_type = R;
+        using difference_type = std::ptrdiff_t;
+
+        iterator_t() noexcept = default;
+
+        auto operator*() const noexcept -> R&
+        {
+            return *m_generator->m_handle.promise().m_item;
+        }
+
+        auto operator->() const noexcept -> R*
+        {
+            return m_generator->m_handle.promise().m_item;
+        }
+
+        auto operator++() -> iterator_t&
+        {
+            m_generator->advance();
+            return *this;
+        }
+
+        auto operator++(int) -> void
+        {
+            ++*this;
+        }
+
+        auto operator==(sentinel_t) const noexcept -> bool
+        {
+            return m_generator->m_done;
+        }
+
+      private:
+        friend class generator_t;
+
+        explicit iterator_t(generator_t* p_generator) noexcept
+            : m_generator{p_generator}
+        {
+        }
+
+      private:
+        generator_t* m_generator = nullptr;
+    };
+
+    generator_t(generator_t&& other) noexcept
+        : m_handle{std::exchange(other.m_handle, nullptr)},
+          m_started{other.m_started},
+          m_done{other.m_done},
+          m_stop_at_error{other.m_stop_at_error}
+    {
+    }
+
+    generator_t& operator=(generator_t&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+            m_started = other.m_started;
+            m_done = other.m_done;
+            m_stop_at_error = other.m_stop_at_error;
+        }
+
+        return *this;
+    }
+
+    generator_t(const generator_t&) = delete;
+    generator_t& operator=(const generator_t&) = delete;
+
+    /**
+     * @brief Frees the coroutine frame, whether the coroutine finished or
+     * not.
+     */
+    ~generator_t()
+    {
+        destroy();
+    }
+
+    /**
+     * @brief Makes the iteration stop after the first item that holds an
+     * error, without resuming the coroutine again. The error is still handed
+     * out, as the last item.
+     */
+    auto stop_at_error() & noexcept -> generator_t&
+    {
+        m_stop_at_error = true;
+        return *this;
+    }
+
+    /**
+     * @brief Does the same for a generator that was just created, and returns
+     * it by value, so that it lives as long as the loop over it.
+     */
+    auto stop_at_error() && noexcept -> generator_t
+    {
+        m_stop_at_error = true;
+        return std::move(*this);
+    }
+
+    /**
+     * @brief Starts the coroutine, and runs it up to the first item.
+     *
+     * A generator can only be iterated over once.
+     */
+    auto begin() -> iterator_t
+    {
+        if (!m_started)
+        {
+            m_started = true;
+            resume();
+        }
+
+        return iterator_t{this};
+    }
+
+    auto end() const noexcept -> sentinel_t
+    {
+        return {};
+    }
+
+  private:
+    using handle_t = std::coroutine_handle<promise_type>;
+    using frame_allocator_t = detail::frame_allocator_t<Allocator>;
+
+    explicit generator_t(handle_t p_handle) noexcept : m_handle{p_handle}
+    {
+    }
+
+    auto advance() -> void
+    {
+        if (m_stop_at_error)
+        {
+            auto error = error_type{};
+            if (m_handle.promise().m_item->is_error(error))
+            {
+                m_done = true;
+                return;
+            }
+        }
+
+        resume();
+    }
+
+    auto resume() -> void
+    {
+        auto& promise = m_handle.promise();
+        promise.m_item = nullptr;
+        m_handle.resume();
+        if (m_handle.done())
+        {
+            m_done = true;
+            if (promise.m_exception)
+            {
+                std::rethrow_exception(std::exchange(promise.m_exception, {}));
+            }
+        }
+    }
+
+    auto destroy() noexcept -> void
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+  private:
+    handle_t m_handle;
+    bool m_started = false;
+    bool m_done = false;
+    bool m_stop_at_error = false;
+};
+} // namespace kirho
@@ -0,0 +1,173 @@
+/**
+ * @file iovec_builder.hpp
+ * @brief Gathering buffers into a single vectored write.
+ *
+ * Contains @ref kirho::iovec_builder_t, which lets you write a bunch of
+ * separate buffers with one system call, instead of copying them into one big
+ * buffer first.
+ */
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+#include <sys/uio.h>
+
+#include "kirho.hpp"
+#include "sys.hpp"
+
+namespace kirho
+{
+/**
+ * @brief Collects buffers to be written out with `writev`.
+ *
+ * The buffers are only referred to, never copied, so they have to stay alive
+ * until they are written. The list of buffers is kept inside the object, which
+ * means that there is no allocation, but also that there is a limit on how
+ * many buffers it can hold.
+ *
+ * @tparam N The maximum number of buffers.
+ */
+template <std::size_t N = 16>
+class iovec_builder_t
+{
+  public:
+    /**
+     * @brief Adds the bytes to the end of the list.
+     *
+     * Empty buffers are skipped, since there is nothing to write.
+     *
+     * @return Whether there was room for the buffer.
+     */
+    auto add(std::span<const std::byte> bytes) noexcept -> bool
+    {
+        if (bytes.empty())
+        {
+            return true;
+        }
+
+        if (m_count == N)
+        {
+            return false;
+        }
+
+        // iovec wants a mutable pointer, even though writev never writes
+        // through it.
+        m_buffers[m_count].iov_base = const_cast<std::byte*>(bytes.data());
+        m_buffers[m_count].iov_len = bytes.size();
+        m_count++;
+        m_size += bytes.size();
+
+        return true;
+    }
+
+    /**
+     * @brief Adds the text to the end of the list.
+     *
+     * @return Whether there was room for the text.
+     */
+    auto add(std::string_view text) noexcept -> bool
+    {
+        return add(std::as_bytes(std::span{text.data(), text.size()}));
+    }
+
+    /**
+     * @brief Returns the buffers that are yet to be written.
+     */
+    auto buffers() const noexcept -> std::span<const iovec>
+    {
+        return std::span{m_buffers}.subspan(m_first, m_count - m_first);
+    }
+
+    /**
+     * @brief Returns the number of bytes that are yet to be written.
+     */
+    auto size() const noexcept -> std::size_t
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Removes all of the buffers.
+     */
+    auto clear() noexcept -> void
+    {
+        m_count = 0;
+        m_first = 0;
+        m_size = 0;
+    }
+
+    /**
+     * @brief Writes all of the buffers to the file descriptor.
+     *
+     * Partial writes are taken care of by carrying on from where the last one
+     * stopped, until everything has been written. If writing fails, the
+     * buffers are left pointing at whatever hadn't been written yet, so you can
+     * call this again to resume, for example once a non-blocking socket has
+     * room again.
+     *
+     * @return The number of bytes that were written by this call.
+     */
+    auto write_to(const sys::fd_t& fd) noexcept
+        -> result_t<std::size_t, sys_error_t>
+    {
+        using result = result_t<std::size_t, sys_error_t>;
+
+        auto total = std::size_t{0};
+        while (m_size > 0)
+        {
+            constexpr auto max_buffers = static_cast<std::size_t>(IOV_MAX);
+
+            auto pending = buffers();
+            if (pending.size() > max_buffers)
+            {
+                pending = pending.first(max_buffers);
+            }
+
+            auto written = std::size_t{0};
+            auto error = sys_error_t{};
+            const auto outcome = sys::writev(fd, pending);
+            if (outcome.is_error(error))
+            {
+                return result::error(error);
+            }
+            outcome.is_success(written);
+
+            total += written;
+            consume(written);
+        }
+
+        clear();
+        return result::success(total);
+    }
+
+  private:
+    auto consume(std::size_t count) noexcept -> void
+    {
+        m_size -= count;
+        while (count > 0)
+        {
+            auto& buffer = m_buffers[m_first];
+            if (count < buffer.iov_len)
+            {
+                buffer.iov_base = static_cast<std::byte*>(buffer.iov_base) +
+                                  count;
+                buffer.iov_len -= count;
+                return;
+            }
+
+            count -= buffer.iov_len;
+            m_first++;
+        }
+    }
+
+  private:
+    std::array<iovec, N> m_buffers;
+    std::size_t m_count = 0;
+    std::size_t m_first = 0;
+    std::size_t m_size = 0;
+};
+} // namespace kirho
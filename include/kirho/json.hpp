@@ -0,0 +1,1512 @@
+/**
+ * @file json.hpp
+ * @brief Reading JSON without building a tree out of it.
+ *
+ * Contains @ref kirho::json_document_t, which finds where everything in some
+ * JSON text is in one fast pass, and then lets you pick out only the values
+ * that you're interested in. Nothing gets turned into numbers or strings until
+ * you ask for it, and strings without escapes in them are never copied.
+ */
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Whether we can use x86 vector instructions that the compiler wasn't told to
+// use, and check for them at runtime instead. Define it to 0 to always use the
+// scalar code.
+#ifndef KIRHO_X86_SIMD
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KIRHO_X86_SIMD 1
+#else
+#define KIRHO_X86_SIMD 0
+#endif
+#endif
+
+#if KIRHO_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "kirho.hpp"
+#include "parse.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The reason why some JSON could not be read.
+ */
+struct json_error_t
+{
+    /**
+     * @brief The kinds of things that can go wrong.
+     */
+    enum class kind_t
+    {
+        /// The text ends in the middle of a value.
+        unexpected_end,
+        /// There is something that doesn't belong where it is.
+        unexpected_character,
+        /// A string is never closed.
+        unterminated_string,
+        /// There is a backslash in a string that isn't a valid escape.
+        invalid_escape,
+        /// There is a control character in a string that isn't escaped.
+        control_character,
+        /// A number isn't written the way JSON wants it.
+        invalid_number,
+        /// A number doesn't fit into the type that was asked for.
+        number_out_of_range,
+        /// The value isn't of the type that was asked for.
+        incorrect_type,
+        /// The object has no field with that name.
+        no_such_field,
+        /// The array has fewer elements than that.
+        index_out_of_range,
+        /// The text is over 4 GiB, which is more than we can index.
+        too_large,
+    };
+
+    /**
+     * @brief The offset in the text where the problem is.
+     *
+     * For errors about a value, this is where the value starts.
+     */
+    std::size_t offset = 0;
+
+    /**
+     * @brief What the problem is.
+     */
+    kind_t kind = kind_t::unexpected_end;
+
+    auto operator==(const json_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const json_error_t& error)
+    -> std::ostream&
+{
+    using kind_t = json_error_t::kind_t;
+
+    switch (error.kind)
+    {
+    case kind_t::unexpected_end:
+        return stream << "unexpected end of the text";
+    case kind_t::unexpected_character:
+        return stream << "unexpected character at offset " << error.offset;
+    case kind_t::unterminated_string:
+        return stream << "string at offset " << error.offset
+                      << " is never closed";
+    case kind_t::invalid_escape:
+        return stream << "invalid escape at offset " << error.offset;
+    case kind_t::control_character:
+        return stream << "unescaped control character at offset "
+                      << error.offset;
+    case kind_t::invalid_number:
+        return stream << "invalid number at offset " << error.offset;
+    case kind_t::number_out_of_range:
+        return stream << "number at offset " << error.offset
+                      << " is out of range";
+    case kind_t::incorrect_type:
+        return stream << "value at offset " << error.offset
+                      << " has the wrong type";
+    case kind_t::no_such_field:
+        return stream << "object at offset " << error.offset
+                      << " has no such field";
+    case kind_t::index_out_of_range:
+        return stream << "array at offset " << error.offset
+                      << " has no such element";
+    case kind_t::too_large:
+        return stream << "text is too large";
+    }
+
+    return stream;
+}
+
+/**
+ * @brief The types that a JSON value can have.
+ */
+enum class json_type_t
+{
+    object,
+    array,
+    string,
+    number,
+    boolean,
+    null,
+};
+
+class json_document_t;
+class json_object_t;
+class json_array_t;
+
+namespace detail
+{
+// The interesting characters in a block of 64 bytes, one bit per byte.
+struct json_masks_t
+{
+    std::uint64_t quotes = 0;
+    std::uint64_t backslashes = 0;
+    std::uint64_t whitespace = 0;
+    std::uint64_t operators = 0;
+    // Everything below a space, which strings can only have escaped.
+    std::uint64_t controls = 0;
+};
+
+using json_kernel_t = json_masks_t (*)(const char*);
+
+inline auto is_json_whitespace(char c) noexcept -> bool
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline auto is_json_operator(char c) noexcept -> bool
+{
+    return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' ||
+           c == ',';
+}
+
+inline auto json_masks_scalar(const char* block) -> json_masks_t
+{
+    auto masks = json_masks_t{};
+    for (auto i = 0; i < 64; i++)
+    {
+        const auto bit = std::uint64_t{1} << i;
+        masks.quotes |= block[i] == '"' ? bit : 0;
+        masks.backslashes |= block[i] == '\\' ? bit : 0;
+        masks.whitespace |= is_json_whitespace(block[i]) ? bit : 0;
+        masks.operators |= is_json_operator(block[i]) ? bit : 0;
+        masks.controls |= static_cast<unsigned char>(block[i]) < 0x20 ? bit : 0;
+    }
+
+    return masks;
+}
+
+#if KIRHO_X86_SIMD
+// Puts the result of a movemask at the right place in a 64 bit mask.
+inline auto json_bits(int mask, int shift) noexcept -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(mask))
+           << shift;
+}
+
+// Setting the 0x20 bit turns square brackets into curly ones, and doesn't
+// turn anything else into either, so brackets take two comparisons, not four.
+inline auto json_masks_sse2(const char* block) -> json_masks_t
+{
+    auto masks = json_masks_t{};
+    for (auto i = 0; i < 4; i++)
+    {
+        const auto chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        const auto folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+
+        const auto quotes = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        const auto backslashes = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        const auto whitespace = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))
+            ),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))
+            )
+        );
+        const auto operators = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))
+            ),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')),
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))
+            )
+        );
+        // There's no unsigned comparison, but a byte is below 0x20 exactly
+        // when the bigger of it and 0x1f is 0x1f.
+        const auto controls = _mm_cmpeq_epi8(
+            _mm_max_epu8(chunk, _mm_set1_epi8(0x1f)), _mm_set1_epi8(0x1f)
+        );
+
+        masks.quotes |= json_bits(_mm_movemask_epi8(quotes), i * 16);
+        masks.backslashes |= json_bits(_mm_movemask_epi8(backslashes), i * 16);
+        masks.whitespace |= json_bits(_mm_movemask_epi8(whitespace), i * 16);
+        masks.operators |= json_bits(_mm_movemask_epi8(operators), i * 16);
+        masks.controls |= json_bits(_mm_movemask_epi8(controls), i * 16);
+    }
+
+    return masks;
+}
+
+__attribute__((target("avx2"))) inline auto json_masks_avx2(const char* block)
+    -> json_masks_t
+{
+    auto masks = json_masks_t{};
+    for (auto i = 0; i < 2; i++)
+    {
+        const auto chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(block + i * 32)
+        );
+        const auto folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+
+        const auto quotes = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+        const auto backslashes =
+            _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+        const auto whitespace = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))
+            ),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')),
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))
+            )
+        );
+        const auto operators = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+                _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))
+            ),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')),
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))
+            )
+        );
+        const auto controls = _mm256_cmpeq_epi8(
+            _mm256_max_epu8(chunk, _mm256_set1_epi8(0x1f)),
+            _mm256_set1_epi8(0x1f)
+        );
+
+        masks.quotes |= json_bits(_mm256_movemask_epi8(quotes), i * 32);
+        masks.backslashes |=
+            json_bits(_mm256_movemask_epi8(backslashes), i * 32);
+        masks.whitespace |= json_bits(_mm256_movemask_epi8(whitespace), i * 32);
+        masks.operators |= json_bits(_mm256_movemask_epi8(operators), i * 32);
+        masks.controls |= json_bits(_mm256_movemask_epi8(controls), i * 32);
+    }
+
+    return masks;
+}
+#endif
+
+inline auto select_json_kernel() noexcept -> json_kernel_t
+{
+#if KIRHO_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return json_masks_avx2;
+    }
+
+    return json_masks_sse2;
+#else
+    return json_masks_scalar;
+#endif
+}
+
+// Returns the characters that come right after a backslash, and so don't mean
+// what they usually do. Backslashes are rare enough that going through them
+// one at a time is fine.
+inline auto json_escaped(std::uint64_t backslashes, bool& carry) noexcept
+    -> std::uint64_t
+{
+    auto escaped = std::uint64_t{0};
+    if (carry)
+    {
+        escaped = 1;
+        backslashes &= ~std::uint64_t{1};
+        carry = false;
+    }
+
+    while (backslashes != 0)
+    {
+        const auto bit = std::countr_zero(backslashes);
+        if (bit == 63)
+        {
+            carry = true;
+            break;
+        }
+
+        escaped |= std::uint64_t{2} << bit;
+        backslashes &= ~(std::uint64_t{3} << bit);
+    }
+
+    return escaped;
+}
+
+// Sets every bit from a quote up to the next one, which is what marks the
+// inside of strings.
+inline auto json_prefix_xor(std::uint64_t bits) noexcept -> std::uint64_t
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Checks that the text is a number in the format that JSON allows, and says
+// whether it has a fraction or an exponent.
+enum class json_number_t
+{
+    invalid,
+    integer,
+    real,
+};
+
+inline auto json_number_kind(std::string_view text) noexcept -> json_number_t
+{
+    auto position = std::size_t{0};
+    const auto digits = [&]() {
+        const auto start = position;
+        while (position < text.size() && text[position] >= '0' &&
+               text[position] <= '9')
+        {
+            position++;
+        }
+        return position - start;
+    };
+
+    if (position < text.size() && text[position] == '-')
+    {
+        position++;
+    }
+
+    const auto leading_zero = position < text.size() && text[position] == '0';
+    const auto integer_digits = digits();
+    if (integer_digits == 0 || (leading_zero && integer_digits > 1))
+    {
+        return json_number_t::invalid;
+    }
+
+    auto kind = json_number_t::integer;
+    if (position < text.size() && text[position] == '.')
+    {
+        position++;
+        if (digits() == 0)
+        {
+            return json_number_t::invalid;
+        }
+        kind = json_number_t::real;
+    }
+
+    if (position < text.size() && (text[position] | 0x20) == 'e')
+    {
+        position++;
+        if (position < text.size() &&
+            (text[position] == '+' || text[position] == '-'))
+        {
+            position++;
+        }
+        if (digits() == 0)
+        {
+            return json_number_t::invalid;
+        }
+        kind = json_number_t::real;
+    }
+
+    return position == text.size() ? kind : json_number_t::invalid;
+}
+
+inline auto json_hex4(std::string_view text, std::size_t position) noexcept
+    -> std::uint32_t
+{
+    auto value = std::uint32_t{0};
+    for (auto i = position; i < position + 4; i++)
+    {
+        const auto c = text[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9')
+        {
+            value |= static_cast<std::uint32_t>(c - '0');
+        }
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+        {
+            value |= static_cast<std::uint32_t>((c | 0x20) - 'a' + 10);
+        }
+        else
+        {
+            return 0xFFFFFFFF;
+        }
+    }
+
+    return value;
+}
+
+// Writes the string between the quotes at start and end to the output, with
+// the escapes turned into what they stand for.
+inline auto json_unescape(
+    std::string_view text,
+    std::size_t start,
+    std::size_t end,
+    char* output
+) noexcept -> result_t<std::size_t, json_error_t>
+{
+    using result = result_t<std::size_t, json_error_t>;
+
+    auto written = std::size_t{0};
+    for (auto position = start; position < end;)
+    {
+        const auto c = text[position];
+        if (c != '\\')
+        {
+            output[written++] = c;
+            position++;
+            continue;
+        }
+
+        const auto escape = position;
+        const auto error =
+            json_error_t{escape, json_error_t::kind_t::invalid_escape};
+        if (position + 1 >= end)
+        {
+            return result::error(error);
+        }
+
+        position += 2;
+        switch (text[escape + 1])
+        {
+        case '"':
+        case '\\':
+        case '/':
+            output[written++] = text[escape + 1];
+            continue;
+        case 'b':
+            output[written++] = '\b';
+            continue;
+        case 'f':
+            output[written++] = '\f';
+            continue;
+        case 'n':
+            output[written++] = '\n';
+            continue;
+        case 'r':
+            output[written++] = '\r';
+            continue;
+        case 't':
+            output[written++] = '\t';
+            continue;
+        case 'u':
+            break;
+        default:
+            return result::error(error);
+        }
+
+        if (end - position < 4)
+        {
+            return result::error(error);
+        }
+
+        auto code_point = json_hex4(text, position);
+        position += 4;
+        if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+        {
+            return result::error(error);
+        }
+
+        // Characters outside of the basic plane are written as two escapes.
+        if (code_point >= 0xD800 && code_point <= 0xDBFF)
+        {
+            if (end - position < 6 || text[position] != '\\' ||
+                text[position + 1] != 'u')
+            {
+                return result::error(error);
+            }
+
+            const auto low = json_hex4(text, position + 2);
+            if (low < 0xDC00 || low > 0xDFFF)
+            {
+                return result::error(error);
+            }
+
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+            position += 6;
+        }
+        else if (code_point == 0xFFFFFFFF)
+        {
+            return result::error(error);
+        }
+
+        if (code_point < 0x80)
+        {
+            output[written++] = static_cast<char>(code_point);
+        }
+        else if (code_point < 0x800)
+        {
+            output[written++] = static_cast<char>(0xC0 | (code_point >> 6));
+            output[written++] = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else if (code_point < 0x10000)
+        {
+            output[written++] = static_cast<char>(0xE0 | (code_point >> 12));
+            output[written++] =
+                static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            output[written++] = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else
+        {
+            output[written++] = static_cast<char>(0xF0 | (code_point >> 18));
+            output[written++] =
+                static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            output[written++] =
+                static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            output[written++] = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+    }
+
+    return result::success(written);
+}
+} // namespace detail
+
+/**
+ * @brief A single value somewhere in a @ref json_document_t.
+ *
+ * This is just a reference to the place where the value is, so it's cheap to
+ * copy around. It stays valid for as long as the document does. None of the
+ * accessors look at anything but the value itself, which is what makes
+ * skipping over the rest of the document cheap.
+ */
+class json_value_t
+{
+  public:
+    /**
+     * @brief Returns the type of the value, going by its first character.
+     */
+    auto type() const noexcept -> json_type_t;
+
+    /**
+     * @brief Returns the text of the value, exactly as it is in the document.
+     */
+    auto raw() const noexcept -> std::string_view;
+
+    /**
+     * @brief Returns the value as an object, if it is one.
+     */
+    auto get_object() const noexcept -> result_t<json_object_t, json_error_t>;
+
+    /**
+     * @brief Returns the value as an array, if it is one.
+     */
+    auto get_array() const noexcept -> result_t<json_array_t, json_error_t>;
+
+    /**
+     * @brief Returns the contents of the string.
+     *
+     * Strings without escapes are views straight into the text. Strings with
+     * escapes are decoded into a buffer that belongs to the document, which
+     * means that this isn't safe to call from several threads at once.
+     */
+    auto get_string() const -> result_t<std::string_view, json_error_t>;
+
+    /**
+     * @brief Returns the number, if it's an integer that fits.
+     */
+    auto get_int64() const noexcept -> result_t<std::int64_t, json_error_t>;
+
+    /**
+     * @brief Returns the number, if it's a non-negative integer that fits.
+     */
+    auto get_uint64() const noexcept -> result_t<std::uint64_t, json_error_t>;
+
+    /**
+     * @brief Returns the number, which may also be an integer.
+     */
+    auto get_double() const noexcept -> result_t<double, json_error_t>;
+
+    /**
+     * @brief Returns the value as a boolean, if it is one.
+     */
+    auto get_bool() const noexcept -> result_t<bool, json_error_t>;
+
+    /**
+     * @brief Checks if the value is null.
+     */
+    auto is_null() const noexcept -> bool;
+
+    /**
+     * @brief Looks up a field, if the value is an object.
+     */
+    auto find_field(std::string_view key) const
+        -> result_t<json_value_t, json_error_t>;
+
+    /**
+     * @brief Looks up an element, if the value is an array.
+     */
+    auto at(std::size_t index) const noexcept
+        -> result_t<json_value_t, json_error_t>;
+
+  private:
+    friend class json_document_t;
+    friend class json_object_t;
+    friend class json_array_t;
+
+    json_value_t(const json_document_t* p_document, std::uint32_t p_token)
+        noexcept
+        : m_document{p_document}, m_token{p_token}
+    {
+    }
+
+    auto offset() const noexcept -> std::size_t;
+
+    template <typename T>
+    auto get_number() const noexcept -> result_t<T, json_error_t>;
+
+  private:
+    const json_document_t* m_document;
+    std::uint32_t m_token;
+};
+
+/**
+ * @brief A field in a @ref json_object_t.
+ */
+struct json_field_t
+{
+    /**
+     * @brief The name of the field, which is always a string.
+     */
+    json_value_t key;
+
+    /**
+     * @brief The value of the field.
+     */
+    json_value_t value;
+};
+
+/**
+ * @brief An object in a @ref json_document_t, whose fields you can go through
+ * in order.
+ */
+class json_object_t
+{
+  public:
+    class iterator_t
+    {
+      public:
+        using value_type = json_field_t;
+        using difference_type = std::ptrdiff_t;
+
+        iterator_t() noexcept = default;
+
+        auto operator*() const noexcept -> json_field_t;
+        auto operator++() noexcept -> iterator_t&;
+        auto operator++(int) noexcept -> iterator_t
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        auto operator==(const iterator_t&) const noexcept -> bool = default;
+
+      private:
+        friend class json_object_t;
+
+        iterator_t(const json_document_t* p_document, std::uint32_t p_token)
+            noexcept
+            : m_document{p_document}, m_token{p_token}
+        {
+        }
+
+      private:
+        const json_document_t* m_document = nullptr;
+        std::uint32_t m_token = 0;
+    };
+
+    auto begin() const noexcept -> iterator_t;
+    auto end() const noexcept -> iterator_t;
+
+    /**
+     * @brief Looks up a field by name.
+     *
+     * The fields are searched from the start, so for objects with lots of
+     * fields that you want all of, going through them in order is quicker.
+     * If there are several fields with the name, the first one is returned.
+     */
+    auto find_field(std::string_view key) const
+        -> result_t<json_value_t, json_error_t>;
+
+    /**
+     * @brief Counts the fields, which means going through all of them.
+     */
+    auto size() const noexcept -> std::size_t;
+
+  private:
+    friend class json_value_t;
+
+    json_object_t(const json_document_t* p_document, std::uint32_t p_token)
+        noexcept
+        : m_document{p_document}, m_token{p_token}
+    {
+    }
+
+  private:
+    const json_document_t* m_document;
+    std::uint32_t m_token;
+};
+
+/**
+ * @brief An array in a @ref json_document_t, whose elements you can go
+ * through in order.
+ */
+class json_array_t
+{
+  public:
+    class iterator_t
+    {
+      public:
+        using value_type = json_value_t;
+        using difference_type = std::ptrdiff_t;
+
+        iterator_t() noexcept = default;
+
+        auto operator*() const noexcept -> json_value_t;
+        auto operator++() noexcept -> iterator_t&;
+        auto operator++(int) noexcept -> iterator_t
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        auto operator==(const iterator_t&) const noexcept -> bool = default;
+
+      private:
+        friend class json_array_t;
+
+        iterator_t(const json_document_t* p_document, std::uint32_t p_token)
+            noexcept
+            : m_document{p_document}, m_token{p_token}
+        {
+        }
+
+      private:
+        const json_document_t* m_document = nullptr;
+        std::uint32_t m_token = 0;
+    };
+
+    auto begin() const noexcept -> iterator_t;
+    auto end() const noexcept -> iterator_t;
+
+    /**
+     * @brief Returns the element at the index, going through the ones
+     * before it to get there.
+     */
+    auto at(std::size_t index) const noexcept
+        -> result_t<json_value_t, json_error_t>;
+
+    /**
+     * @brief Counts the elements, which means going through all of them.
+     */
+    auto size() const noexcept -> std::size_t;
+
+  private:
+    friend class json_value_t;
+
+    json_array_t(const json_document_t* p_document, std::uint32_t p_token)
+        noexcept
+        : m_document{p_document}, m_token{p_token}
+    {
+    }
+
+  private:
+    const json_document_t* m_document;
+    std::uint32_t m_token;
+};
+
+/**
+ * @brief Some JSON text, with the positions of everything in it worked out.
+ *
+ * Parsing happens in two passes. The first one goes over the text 64 bytes at
+ * a time, finding the quotes, backslashes, whitespace and punctuation with
+ * vector instructions, and turning those into a list of where every value and
+ * every bit of punctuation outside of strings starts. That's the first stage
+ * of simdjson. The second one goes over that list and checks that everything
+ * is in an order that makes sense, noting down where every object and array
+ * ends on the way. Numbers and strings are only looked at when you ask for
+ * them, so that's also when mistakes in them are found, apart from control
+ * characters in strings that aren't escaped, which the first pass spots.
+ *
+ * The document refers to the text, so the text has to outlive it, as well as
+ * the values that come out of it.
+ */
+class json_document_t
+{
+  public:
+    json_document_t(const json_document_t&) = delete;
+    auto operator=(const json_document_t&) -> json_document_t& = delete;
+    json_document_t(json_document_t&&) noexcept = default;
+    auto operator=(json_document_t&&) noexcept -> json_document_t& = default;
+
+    /**
+     * @brief Indexes the text, and checks that it's well-formed.
+     *
+     * @return The document, or the first thing that's wrong with the text.
+     */
+    static auto parse(std::string_view text)
+        -> result_t<json_document_t, json_error_t>
+    {
+        using result = result_t<json_document_t, json_error_t>;
+
+        if (text.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+            return result::error({0, json_error_t::kind_t::too_large});
+        }
+
+        auto document = json_document_t{text};
+        auto error = json_error_t{};
+        if (document.index().is_error(error) ||
+            document.check().is_error(error))
+        {
+            return result::error(error);
+        }
+
+        return result::success(std::move(document));
+    }
+
+    /**
+     * @brief Returns the value that the whole text is.
+     */
+    auto root() const noexcept -> json_value_t
+    {
+        return json_value_t{this, 0};
+    }
+
+    /**
+     * @brief Returns the text that the document refers to.
+     */
+    auto text() const noexcept -> std::string_view
+    {
+        return m_text;
+    }
+
+  private:
+    friend class json_value_t;
+    friend class json_object_t;
+    friend class json_array_t;
+
+    explicit json_document_t(std::string_view p_text) : m_text{p_text}
+    {
+    }
+
+    // The first pass, which finds where every value and every bit of
+    // punctuation starts.
+    auto index() -> result_t<empty_t, json_error_t>
+    {
+        using result = result_t<empty_t, json_error_t>;
+
+        static const auto kernel = detail::select_json_kernel();
+
+        m_offsets.reserve(m_text.size() / 8 + 1);
+
+        auto escaped_carry = false;
+        auto string_carry = std::uint64_t{0};
+        auto follows_carry = std::uint64_t{1};
+        auto last_quote = std::size_t{0};
+        for (auto block = std::size_t{0}; block < m_text.size(); block += 64)
+        {
+            // The last block is copied so that the kernel can read all of it.
+            const auto remaining = m_text.size() - block;
+            auto masks = detail::json_masks_t{};
+            auto valid = ~std::uint64_t{0};
+            if (remaining >= 64)
+            {
+                masks = kernel(m_text.data() + block);
+            }
+            else
+            {
+                char padded[64] = {};
+                std::memcpy(padded, m_text.data() + block, remaining);
+                masks = kernel(padded);
+                valid = (std::uint64_t{1} << remaining) - 1;
+            }
+
+            auto quotes = masks.quotes;
+            if (masks.backslashes != 0 || escaped_carry)
+            {
+                quotes &= ~detail::json_escaped(
+                    masks.backslashes, escaped_carry
+                );
+            }
+
+            const auto inside = detail::json_prefix_xor(quotes) ^ string_carry;
+            string_carry = static_cast<std::uint64_t>(
+                -static_cast<std::int64_t>(inside >> 63)
+            );
+
+            // RFC 8259 only allows control characters in strings as escapes.
+            const auto controls = masks.controls & inside & valid;
+            if (controls != 0) [[unlikely]]
+            {
+                return result::error(
+                    {block + static_cast<std::size_t>(
+                                 std::countr_zero(controls)
+                             ),
+                     json_error_t::kind_t::control_character}
+                );
+            }
+
+            const auto opening = quotes & inside;
+            const auto closing = quotes & ~inside;
+            if (opening != 0)
+            {
+                last_quote = block + 63 -
+                             static_cast<std::size_t>(
+                                 std::countl_zero(opening)
+                             );
+            }
+
+            // Values other than strings start wherever something other than
+            // whitespace comes right after whitespace, punctuation or the end
+            // of a string.
+            const auto operators = masks.operators & ~inside;
+            const auto separators =
+                operators | (masks.whitespace & ~inside) | closing;
+            const auto scalars = ~(separators | quotes | inside);
+            const auto starts = scalars & ((separators << 1) | follows_carry);
+            follows_carry = separators >> 63;
+
+            auto structurals = (operators | opening | starts) & valid;
+            while (structurals != 0)
+            {
+                m_offsets.push_back(static_cast<std::uint32_t>(
+                    block + static_cast<std::size_t>(
+                                std::countr_zero(structurals)
+                            )
+                ));
+                structurals &= structurals - 1;
+            }
+        }
+
+        if (string_carry != 0)
+        {
+            return result::error(
+                {last_quote, json_error_t::kind_t::unterminated_string}
+            );
+        }
+
+        return result::success({});
+    }
+
+    // The second pass, which checks that the punctuation is where it should
+    // be, and notes down where every object and array ends.
+    auto check() -> result_t<empty_t, json_error_t>
+    {
+        using result = result_t<empty_t, json_error_t>;
+        using kind_t = json_error_t::kind_t;
+
+        enum class expect_t
+        {
+            value,
+            value_or_end,
+            key,
+            key_or_end,
+            colon,
+            comma_or_end,
+        };
+
+        m_matches.resize(m_offsets.size());
+
+        auto open = std::vector<std::uint32_t>{};
+        auto expect = expect_t::value;
+        for (auto token = std::uint32_t{0}; token < m_offsets.size(); token++)
+        {
+            const auto offset = m_offsets[token];
+            const auto c = m_text[offset];
+            const auto unexpected =
+                json_error_t{offset, kind_t::unexpected_character};
+
+            // Closing brackets are fine wherever a comma would be, and right
+            // after the opening one.
+            const auto closing = c == '}' || c == ']';
+            if (closing && (expect == expect_t::comma_or_end ||
+                            expect == expect_t::value_or_end ||
+                            expect == expect_t::key_or_end))
+            {
+                if (open.empty() ||
+                    char_at(open.back()) != (c == '}' ? '{' : '['))
+                {
+                    return result::error(unexpected);
+                }
+
+                m_matches[open.back()] = token;
+                open.pop_back();
+                expect = expect_t::comma_or_end;
+                continue;
+            }
+
+            switch (expect)
+            {
+            case expect_t::value:
+            case expect_t::value_or_end:
+                if (c == '{')
+                {
+                    open.push_back(token);
+                    expect = expect_t::key_or_end;
+                }
+                else if (c == '[')
+                {
+                    open.push_back(token);
+                    expect = expect_t::value_or_end;
+                }
+                else if (is_scalar_start(offset))
+                {
+                    expect = expect_t::comma_or_end;
+                }
+                else
+                {
+                    return result::error(unexpected);
+                }
+                break;
+            case expect_t::key:
+            case expect_t::key_or_end:
+                if (c != '"')
+                {
+                    return result::error(unexpected);
+                }
+                expect = expect_t::colon;
+                break;
+            case expect_t::colon:
+                if (c != ':')
+                {
+                    return result::error(unexpected);
+                }
+                expect = expect_t::value;
+                break;
+            case expect_t::comma_or_end:
+                if (c != ',' || open.empty())
+                {
+                    return result::error(unexpected);
+                }
+                expect = char_at(open.back()) == '{' ? expect_t::key
+                                                     : expect_t::value;
+                break;
+            }
+        }
+
+        if (!open.empty() || expect != expect_t::comma_or_end)
+        {
+            return result::error({m_text.size(), kind_t::unexpected_end});
+        }
+
+        return result::success({});
+    }
+
+    // Checks the first character of a value that isn't an object or an array,
+    // and the whole of it for the literals, since they're short.
+    auto is_scalar_start(std::size_t offset) const noexcept -> bool
+    {
+        const auto c = m_text[offset];
+        if (c == '"' || c == '-' || (c >= '0' && c <= '9'))
+        {
+            return true;
+        }
+
+        const auto token = token_text(offset);
+        return token == "true" || token == "false" || token == "null";
+    }
+
+    // Returns the text from the offset up to the next token, minus the
+    // whitespace in between.
+    auto token_text(std::size_t offset) const noexcept -> std::string_view
+    {
+        auto end = offset + 1;
+        while (end < m_text.size() && !detail::is_json_operator(m_text[end]) &&
+               !detail::is_json_whitespace(m_text[end]))
+        {
+            end++;
+        }
+
+        return m_text.substr(offset, end - offset);
+    }
+
+    auto char_at(std::uint32_t token) const noexcept -> char
+    {
+        return m_text[m_offsets[token]];
+    }
+
+    // Returns the token after the value that starts at the token.
+    auto skip(std::uint32_t token) const noexcept -> std::uint32_t
+    {
+        const auto c = char_at(token);
+        return c == '{' || c == '[' ? m_matches[token] + 1 : token + 1;
+    }
+
+    // Returns the token that the next element or field starts at, or the
+    // closing bracket if there are no more.
+    auto next(std::uint32_t value) const noexcept -> std::uint32_t
+    {
+        const auto after = skip(value);
+        return char_at(after) == ',' ? after + 1 : after;
+    }
+
+    // Returns the end of the string that starts at the token, which is the
+    // last quote before the next token.
+    auto string_end(std::uint32_t token) const noexcept -> std::size_t
+    {
+        auto end = token + 1 < m_offsets.size() ? m_offsets[token + 1]
+                                                : m_text.size();
+        while (m_text[end - 1] != '"')
+        {
+            end--;
+        }
+
+        return end - 1;
+    }
+
+    auto get_string(std::uint32_t token) const
+        -> result_t<std::string_view, json_error_t>
+    {
+        using result = result_t<std::string_view, json_error_t>;
+
+        const auto start = std::size_t{m_offsets[token]} + 1;
+        const auto end = string_end(token);
+        const auto contents = m_text.substr(start, end - start);
+        if (contents.find('\\') == std::string_view::npos)
+        {
+            return result::success(contents);
+        }
+
+        // Escapes never take up less room than what they stand for, so every
+        // string fits into the same place in a buffer as big as the text.
+        if (!m_strings)
+        {
+            m_strings = std::make_unique_for_overwrite<char[]>(m_text.size());
+        }
+
+        const auto output = m_strings.get() + start;
+        auto size = std::size_t{0};
+        auto error = json_error_t{};
+        const auto outcome = detail::json_unescape(m_text, start, end, output);
+        if (outcome.is_error(error))
+        {
+            return result::error(error);
+        }
+        outcome.is_success(size);
+
+        return result::success(std::string_view{output, size});
+    }
+
+  private:
+    std::string_view m_text;
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<std::uint32_t> m_matches;
+    mutable std::unique_ptr<char[]> m_strings;
+};
+
+inline auto json_value_t::offset() const noexcept -> std::size_t
+{
+    return m_document->m_offsets[m_token];
+}
+
+inline auto json_value_t::type() const noexcept -> json_type_t
+{
+    switch (m_document->char_at(m_token))
+    {
+    case '{':
+        return json_type_t::object;
+    case '[':
+        return json_type_t::array;
+    case '"':
+        return json_type_t::string;
+    case 't':
+    case 'f':
+        return json_type_t::boolean;
+    case 'n':
+        return json_type_t::null;
+    default:
+        return json_type_t::number;
+    }
+}
+
+inline auto json_value_t::raw() const noexcept -> std::string_view
+{
+    const auto start = offset();
+    switch (type())
+    {
+    case json_type_t::object:
+    case json_type_t::array:
+    {
+        const auto end = m_document->m_offsets[m_document->m_matches[m_token]];
+        return m_document->m_text.substr(start, end - start + 1);
+    }
+    case json_type_t::string:
+        return m_document->m_text.substr(
+            start, m_document->string_end(m_token) - start + 1
+        );
+    default:
+        return m_document->token_text(start);
+    }
+}
+
+inline auto json_value_t::get_object() const noexcept
+    -> result_t<json_object_t, json_error_t>
+{
+    using result = result_t<json_object_t, json_error_t>;
+
+    if (type() != json_type_t::object)
+    {
+        return result::error({offset(), json_error_t::kind_t::incorrect_type});
+    }
+
+    return result::success(json_object_t{m_document, m_token});
+}
+
+inline auto json_value_t::get_array() const noexcept
+    -> result_t<json_array_t, json_error_t>
+{
+    using result = result_t<json_array_t, json_error_t>;
+
+    if (type() != json_type_t::array)
+    {
+        return result::error({offset(), json_error_t::kind_t::incorrect_type});
+    }
+
+    return result::success(json_array_t{m_document, m_token});
+}
+
+inline auto json_value_t::get_string() const
+    -> result_t<std::string_view, json_error_t>
+{
+    using result = result_t<std::string_view, json_error_t>;
+
+    if (type() != json_type_t::string)
+    {
+        return result::error({offset(), json_error_t::kind_t::incorrect_type});
+    }
+
+    return m_document->get_string(m_token);
+}
+
+template <typename T>
+auto json_value_t::get_number() const noexcept -> result_t<T, json_error_t>
+{
+    using result = result_t<T, json_error_t>;
+    using kind_t = json_error_t::kind_t;
+
+    if (type() != json_type_t::number)
+    {
+        return result::error({offset(), kind_t::incorrect_type});
+    }
+
+    const auto text = m_document->token_text(offset());
+    const auto kind = detail::json_number_kind(text);
+    if (kind == detail::json_number_t::invalid)
+    {
+        return result::error({offset(), kind_t::invalid_number});
+    }
+    if (std::integral<T> && kind == detail::json_number_t::real)
+    {
+        return result::error({offset(), kind_t::incorrect_type});
+    }
+    if (std::unsigned_integral<T> && text.front() == '-')
+    {
+        return result::error({offset(), kind_t::number_out_of_range});
+    }
+
+    auto value = T{};
+    if (!kirho::parse<T>(text).is_success(value))
+    {
+        return result::error({offset(), kind_t::number_out_of_range});
+    }
+
+    return result::success(value);
+}
+
+inline auto json_value_t::get_int64() const noexcept
+    -> result_t<std::int64_t, json_error_t>
+{
+    return get_number<std::int64_t>();
+}
+
+inline auto json_value_t::get_uint64() const noexcept
+    -> result_t<std::uint64_t, json_error_t>
+{
+    return get_number<std::uint64_t>();
+}
+
+inline auto json_value_t::get_double() const noexcept
+    -> result_t<double, json_error_t>
+{
+    return get_number<double>();
+}
+
+inline auto json_value_t::get_bool() const noexcept
+    -> result_t<bool, json_error_t>
+{
+    using result = result_t<bool, json_error_t>;
+
+    if (type() != json_type_t::boolean)
+    {
+        return result::error({offset(), json_error_t::kind_t::incorrect_type});
+    }
+
+    return result::success(m_document->char_at(m_token) == 't');
+}
+
+inline auto json_value_t::is_null() const noexcept -> bool
+{
+    return type() == json_type_t::null;
+}
+
+inline auto json_value_t::find_field(std::string_view key) const
+    -> result_t<json_value_t, json_error_t>
+{
+    using result = result_t<json_value_t, json_error_t>;
+
+    auto object = json_object_t{m_document, m_token};
+    auto error = json_error_t{};
+    if (get_object().is_error(error))
+    {
+        return result::error(error);
+    }
+
+    return object.find_field(key);
+}
+
+inline auto json_value_t::at(std::size_t index) const noexcept
+    -> result_t<json_value_t, json_error_t>
+{
+    using result = result_t<json_value_t, json_error_t>;
+
+    auto array = json_array_t{m_document, m_token};
+    auto error = json_error_t{};
+    if (get_array().is_error(error))
+    {
+        return result::error(error);
+    }
+
+    return array.at(index);
+}
+
+inline auto json_object_t::iterator_t::operator*() const noexcept
+    -> json_field_t
+{
+    return {
+        json_value_t{m_document, m_token},
+        json_value_t{m_document, m_token + 2},
+    };
+}
+
+inline auto json_object_t::iterator_t::operator++() noexcept -> iterator_t&
+{
+    m_token = m_document->next(m_token + 2);
+    return *this;
+}
+
+inline auto json_object_t::begin() const noexcept -> iterator_t
+{
+    return iterator_t{m_document, m_token + 1};
+}
+
+inline auto json_object_t::end() const noexcept -> iterator_t
+{
+    return iterator_t{m_document, m_document->m_matches[m_token]};
+}
+
+inline auto json_object_t::find_field(std::string_view key) const
+    -> result_t<json_value_t, json_error_t>
+{
+    using result = result_t<json_value_t, json_error_t>;
+
+    for (const auto field : *this)
+    {
+        // Most keys have no escapes, and can be compared as they are.
+        const auto token = field.key.m_token;
+        const auto start = std::size_t{m_document->m_offsets[token]};
+        const auto raw = m_document->m_text.substr(
+            start + 1, m_document->string_end(token) - start - 1
+        );
+        if (raw == key)
+        {
+            return result::success(field.value);
+        }
+
+        auto name = std::string_view{};
+        if (raw.find('\\') != std::string_view::npos &&
+            field.key.get_string().is_success(name) && name == key)
+        {
+            return result::success(field.value);
+        }
+    }
+
+    return result::error(
+        {m_document->m_offsets[m_token], json_error_t::kind_t::no_such_field}
+    );
+}
+
+inline auto json_object_t::size() const noexcept -> std::size_t
+{
+    auto count = std::size_t{0};
+    for (auto it = begin(); it != end(); ++it)
+    {
+        count++;
+    }
+
+    return count;
+}
+
+inline auto json_array_t::iterator_t::operator*() const noexcept
+    -> json_value_t
+{
+    return json_value_t{m_document, m_token};
+}
+
+inline auto json_array_t::iterator_t::operator++() noexcept -> iterator_t&
+{
+    m_token = m_document->next(m_token);
+    return *this;
+}
+
+inline auto json_array_t::begin() const noexcept -> iterator_t
+{
+    return iterator_t{m_document, m_token + 1};
+}
+
+inline auto json_array_t::end() const noexcept -> iterator_t
+{
+    return iterator_t{m_document, m_document->m_matches[m_token]};
+}
+
+inline auto json_array_t::at(std::size_t index) const noexcept
+    -> result_t<json_value_t, json_error_t>
+{
+    using result = result_t<json_value_t, json_error_t>;
+
+    for (const auto element : *this)
+    {
+        if (index-- == 0)
+        {
+            return result::success(element);
+        }
+    }
+
+    return result::error(
+        {m_document->m_offsets[m_token],
+         json_error_t::kind_t::index_out_of_range}
+    );
+}
+
+inline auto json_array_t::size() const noexcept -> std::size_t
+{
+    auto count = std::size_t{0};
+    for (auto it = begin(); it != end(); ++it)
+    {
+        count++;
+    }
+
+    return count;
+}
+} // namespace kirho
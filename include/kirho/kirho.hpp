@@ -2,11 +2,10 @@
  * @file kirho.hpp
  * @brief Core Kirho library features.
  *
- * In other words, this file contains all of the features that are part of the
- * kirho library. There are, unfortunately, no more files in this library. I
- * suppose that you can say that this is not only a header only library, but
- * also a single-header library. Unsure of how long this is going to last,
- * however, as the library could become multifile in the future.
+ * In other words, this file contains all of the core features of the kirho
+ * library. It used to be the only file in the library, but that did not last,
+ * and the bigger features now live in their own headers next to this one. They
+ * all include this file, so you only have to include the ones you use.
  */
 #pragma once
 
@@ -131,6 +130,9 @@ template <typename T, typename E>
 class result_t
 {
   public:
+    using value_type = T;
+    using error_type = E;
+
     /**
      * @brief Creates a success value.
      *
@@ -140,7 +142,9 @@ class result_t
      */
     static auto success(T value = T{}) noexcept -> result_t<T, E>
     {
-        return result_t<T, E>{true, std::variant<T, E>{std::move(value)}};
+        return result_t<T, E>{
+            std::variant<T, E>{std::in_place_index<0>, std::move(value)}
+        };
     }
 
     /**
@@ -152,7 +156,9 @@ class result_t
      */
     static auto error(E error = E{}) noexcept -> result_t<T, E>
     {
-        return result_t<T, E>{false, std::variant<T, E>{std::move(error)}};
+        return result_t<T, E>{
+            std::variant<T, E>{std::in_place_index<1>, std::move(error)}
+        };
     }
 
     /**
@@ -167,12 +173,12 @@ class result_t
      */
     auto is_success(T& value) const noexcept -> bool
     {
-        if (m_success)
+        if (holds_success())
         {
             value = std::get<T>(m_union);
         }
 
-        return m_success;
+        return holds_success();
     }
 
     /**
@@ -187,12 +193,12 @@ class result_t
      */
     auto is_error(E& error) const noexcept -> bool
     {
-        if (!m_success)
+        if (!holds_success())
         {
             error = std::get<E>(m_union);
         }
 
-        return !m_success;
+        return !holds_success();
     }
 
     /**
@@ -205,7 +211,7 @@ class result_t
      */
     auto to_optional() const noexcept -> std::optional<T>
     {
-        if (m_success)
+        if (holds_success())
         {
             return std::optional<T>(std::get<T>(m_union));
         }
@@ -225,9 +231,9 @@ class result_t
      * @return The success value if this result is not an error value.
      */
     template <printable_t... S>
-    auto except(S... values) const noexcept -> T
+    auto except(S... values) const& noexcept -> T
     {
-        if (!m_success)
+        if (!holds_success())
         {
             (std::cerr << ... << values) << '\n';
             std::terminate();
@@ -236,6 +242,26 @@ class result_t
         return std::get<T>(m_union);
     }
 
+    /**
+     * @brief Panic and prints the passed values if it is an error value.
+     *
+     * The same as the other except, but moves the success value out instead
+     * of copying it.
+     *
+     * @return The success value if this result is not an error value.
+     */
+    template <printable_t... S>
+    auto except(S... values) && noexcept -> T
+    {
+        if (!holds_success())
+        {
+            (std::cerr << ... << values) << '\n';
+            std::terminate();
+        }
+
+        return std::get<T>(std::move(m_union));
+    }
+
     /**
      * Panics if the result is an error value, otherwise return the success
      * value.
@@ -246,9 +272,9 @@ class result_t
      *
      * @return The success value if this result is not an error value.
      */
-    auto unwrap() const noexcept -> T
+    auto unwrap() const& noexcept -> T
     {
-        if (!m_success)
+        if (!holds_success())
         {
             std::cerr << "result_t::unwrap called on error value.\n";
             std::terminate();
@@ -257,9 +283,33 @@ class result_t
         return std::get<T>(m_union);
     }
 
+    /**
+     * @brief Moves the success value out of the result, or panics if it is an
+     * error value.
+     *
+     * Same as the other unwrap, except that the success value gets moved out
+     * instead of copied, which makes it usable with types that you cannot copy,
+     * such as file handles and mappings.
+     *
+     * @return The success value if this result is not an error value.
+     */
+    auto unwrap() && noexcept -> T
+    {
+        if (!holds_success())
+        {
+            std::cerr << "result_t::unwrap called on error value.\n";
+            std::terminate();
+        }
+
+        return std::get<T>(std::move(m_union));
+    }
+
     result_t(const result_t&) = delete;
     result_t& operator=(const result_t&) = delete;
 
+    result_t(result_t&&) noexcept = default;
+    result_t& operator=(result_t&&) noexcept = default;
+
     /**
      * @brief Calls the passed lambda with the error value if this is indeed an
      * error type.
@@ -275,23 +325,36 @@ class result_t
     template <error_handler_t<E> F>
     auto handle_error(F handler) const -> void
     {
-        if (!m_success)
+        if (!holds_success())
         {
             handler(std::get<E>(m_union));
         }
     }
 
   private:
-    result_t(bool p_success, std::variant<T, E> p_union)
-        : m_success{p_success}, m_union{p_union}
+    result_t(std::variant<T, E> p_union) : m_union{std::move(p_union)}
     {
     }
 
-  private:
-    bool m_success;
+    // The variant already knows which of the two it holds, so there is no need
+    // to keep a separate flag around, which would only make the result bigger.
+    auto holds_success() const noexcept -> bool
+    {
+        return m_union.index() == 0;
+    }
 
+  private:
     std::variant<T, E> m_union;
 };
+
+/**
+ * @brief A result for functions that return nothing, but still might fail.
+ *
+ * It's just a shorter way to write `result_t<empty_t, E>`, which comes up a
+ * lot.
+ */
+template <typename E>
+using status_t = result_t<empty_t, E>;
 } // namespace kirho
 
 /**
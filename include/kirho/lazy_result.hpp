@@ -0,0 +1,188 @@
+/**
+ * @file lazy_result.hpp
+ * @brief Values that are set up the first time they are needed.
+ *
+ * Contains @ref kirho::lazy_result_t, for global resources that are expensive
+ * to set up and might fail to, such as configuration files or big lookup
+ * tables, and that should only be set up once, no matter how many threads
+ * need them.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief A value that is worked out by a fallible function the first time it
+ * is asked for.
+ *
+ * The function is run by whichever thread asks for the value first, and any
+ * other threads that ask for it in the meantime wait for it to finish. Once
+ * it has, getting the value takes nothing more than a single atomic load.
+ *
+ * Everything is coordinated through one atomic state word, which threads wait
+ * on with `std::atomic::wait`, so there is no mutex involved.
+ *
+ * @tparam T The type of the value.
+ * @tparam E The type of the error.
+ */
+template <typename T, typename E>
+class lazy_result_t
+{
+  public:
+    /**
+     * @brief What to do when the function fails.
+     */
+    enum class error_policy_t
+    {
+        /// Keep the error, and hand it out from then on, just like a value.
+        cache,
+        /// Hand the error out to whoever ran the function, and run it again
+        /// the next time that the value is asked for.
+        retry,
+    };
+
+    using initializer_t = std::function<result_t<T, E>()>;
+
+    /**
+     * @brief Creates the cell, without running the function yet.
+     *
+     * @param p_initializer The function that works out the value.
+     * @param p_policy What to do when the function fails.
+     */
+    explicit lazy_result_t(
+        initializer_t p_initializer,
+        error_policy_t p_policy = error_policy_t::cache
+    )
+        : m_initializer{std::move(p_initializer)}, m_policy{p_policy}
+    {
+    }
+
+    lazy_result_t(const lazy_result_t&) = delete;
+    lazy_result_t& operator=(const lazy_result_t&) = delete;
+
+    /**
+     * @brief Returns the value, working it out first if that hasn't been done
+     * yet.
+     *
+     * The value lives inside of the cell, so what's returned is a reference
+     * to it, which stays valid for as long as the cell does.
+     *
+     * @return The value, or the error from the function.
+     */
+    auto get() -> result_t<std::reference_wrapper<const T>, E>
+    {
+        using result = result_t<std::reference_wrapper<const T>, E>;
+
+        const auto state = m_state.load(std::memory_order_acquire);
+        if (state == ready) [[likely]]
+        {
+            return result::success(std::cref(*m_value));
+        }
+
+        return get_slow(state);
+    }
+
+    /**
+     * @brief Checks if the value has been worked out successfully.
+     */
+    auto is_ready() const noexcept -> bool
+    {
+        return m_state.load(std::memory_order_acquire) == ready;
+    }
+
+  private:
+    static constexpr auto empty = std::uint32_t{0};
+    static constexpr auto running = std::uint32_t{1};
+    static constexpr auto ready = std::uint32_t{2};
+    static constexpr auto failed = std::uint32_t{3};
+
+    auto get_slow(std::uint32_t state)
+        -> result_t<std::reference_wrapper<const T>, E>
+    {
+        using result = result_t<std::reference_wrapper<const T>, E>;
+
+        for (;;)
+        {
+            switch (state)
+            {
+            case ready:
+                return result::success(std::cref(*m_value));
+            case failed:
+                return result::error(*m_error);
+            case running:
+                m_state.wait(running, std::memory_order_acquire);
+                state = m_state.load(std::memory_order_acquire);
+                continue;
+            default:
+                break;
+            }
+
+            if (m_state.compare_exchange_weak(
+                    state, running, std::memory_order_acquire
+                ))
+            {
+                return initialize();
+            }
+        }
+    }
+
+    auto initialize() -> result_t<std::reference_wrapper<const T>, E>
+    {
+        using result = result_t<std::reference_wrapper<const T>, E>;
+
+        // If the function throws, put things back the way they were, so that
+        // the threads that are waiting don't wait forever.
+        auto outcome = std::optional<result_t<T, E>>{};
+        try
+        {
+            outcome.emplace(m_initializer());
+        }
+        catch (...)
+        {
+            publish(empty);
+            throw;
+        }
+
+        auto error = E{};
+        if (outcome->is_error(error))
+        {
+            if (m_policy == error_policy_t::cache)
+            {
+                m_error.emplace(error);
+                publish(failed);
+            }
+            else
+            {
+                publish(empty);
+            }
+
+            return result::error(std::move(error));
+        }
+
+        m_value.emplace(std::move(*outcome).unwrap());
+        publish(ready);
+        return result::success(std::cref(*m_value));
+    }
+
+    auto publish(std::uint32_t state) noexcept -> void
+    {
+        m_state.store(state, std::memory_order_release);
+        m_state.notify_all();
+    }
+
+  private:
+    std::atomic<std::uint32_t> m_state = empty;
+    initializer_t m_initializer;
+    error_policy_t m_policy;
+    std::optional<T> m_value;
+    std::optional<E> m_error;
+};
+} // namespace kirho
@@ -0,0 +1,221 @@
+/**
+ * @file mapped_file.hpp
+ * @brief Read-only memory mapped files.
+ *
+ * Contains @ref kirho::mapped_file_t, which is a way to look at the contents of
+ * a file without reading it into a buffer first. The kernel pages the file in
+ * as you touch it, which means that there are no copies at all.
+ */
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "kirho.hpp"
+#include "sys.hpp"
+
+namespace kirho
+{
+/**
+ * @brief A file that has been mapped into memory for reading.
+ *
+ * The mapping lives for as long as the object does, and is unmapped in the
+ * destructor, much like how a @ref defer_t would do it. The object can be
+ * moved around, but not copied, since there is only one mapping.
+ */
+class mapped_file_t
+{
+  public:
+    /**
+     * @brief Hints about how the mapping is going to be accessed.
+     *
+     * These are passed on to `madvise`, and the kernel is free to ignore them.
+     */
+    enum class advice_t
+    {
+        /// No particular access pattern.
+        normal,
+        /// The file will be read from front to back, so read ahead.
+        sequential,
+        /// The file will be read all over the place, so don't read ahead.
+        random,
+        /// The whole file is going to be needed soon, so start reading it.
+        willneed,
+        /// Back the mapping with huge pages, if the kernel can do that.
+        hugepages,
+    };
+
+    /**
+     * @brief Maps the file at the specified path.
+     *
+     * Opens the file, maps the whole thing, and closes the file again, since
+     * the mapping does not need the file descriptor to stay around. An empty
+     * file results in an empty mapping rather than an error.
+     *
+     * @param path The path to the file to map.
+     *
+     * @return The mapped file, or the error reported by the system.
+     */
+    static auto open(const char* path) noexcept
+        -> result_t<mapped_file_t, sys_error_t>
+    {
+        using result = result_t<mapped_file_t, sys_error_t>;
+
+        const auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return result::error(sys_error_t::from_errno());
+        }
+        defer(fd, ::close(fd));
+
+        struct stat info;
+        if (::fstat(fd, &info) < 0)
+        {
+            return result::error(sys_error_t::from_errno());
+        }
+
+        const auto size = static_cast<std::size_t>(info.st_size);
+        if (size == 0)
+        {
+            return result::success(mapped_file_t{});
+        }
+
+        const auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            return result::error(sys_error_t::from_errno());
+        }
+
+        return result::success(mapped_file_t{data, size});
+    }
+
+    mapped_file_t() noexcept = default;
+
+    mapped_file_t(const mapped_file_t&) = delete;
+    mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+    mapped_file_t(mapped_file_t&& other) noexcept
+        : m_data{std::exchange(other.m_data, nullptr)},
+          m_size{std::exchange(other.m_size, 0)}
+    {
+    }
+
+    mapped_file_t& operator=(mapped_file_t&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~mapped_file_t() noexcept
+    {
+        unmap();
+    }
+
+    /**
+     * @brief Tells the kernel how the mapping is going to be accessed.
+     *
+     * @param advice The access pattern to hint at.
+     *
+     * @return Nothing, or the error if the kernel did not like the hint.
+     */
+    auto advise(advice_t advice) const noexcept
+        -> result_t<empty_t, sys_error_t>
+    {
+        using result = result_t<empty_t, sys_error_t>;
+
+        if (m_size == 0)
+        {
+            return result::success();
+        }
+
+        auto flag = MADV_NORMAL;
+        switch (advice)
+        {
+        case advice_t::normal:
+            flag = MADV_NORMAL;
+            break;
+        case advice_t::sequential:
+            flag = MADV_SEQUENTIAL;
+            break;
+        case advice_t::random:
+            flag = MADV_RANDOM;
+            break;
+        case advice_t::willneed:
+            flag = MADV_WILLNEED;
+            break;
+        case advice_t::hugepages:
+#ifdef MADV_HUGEPAGE
+            flag = MADV_HUGEPAGE;
+            break;
+#else
+            return result::error(sys_error_t{ENOTSUP});
+#endif
+        }
+
+        if (::madvise(m_data, m_size, flag) < 0)
+        {
+            return result::error(sys_error_t::from_errno());
+        }
+
+        return result::success();
+    }
+
+    /**
+     * @brief Returns the contents of the file as raw bytes.
+     */
+    auto bytes() const noexcept -> std::span<const std::byte>
+    {
+        return {static_cast<const std::byte*>(m_data), m_size};
+    }
+
+    /**
+     * @brief Returns the contents of the file as text.
+     */
+    auto view() const noexcept -> std::string_view
+    {
+        return {static_cast<const char*>(m_data), m_size};
+    }
+
+    /**
+     * @brief Returns the size of the file in bytes.
+     */
+    auto size() const noexcept -> std::size_t
+    {
+        return m_size;
+    }
+
+  private:
+    mapped_file_t(void* p_data, std::size_t p_size) noexcept
+        : m_data{p_data}, m_size{p_size}
+    {
+    }
+
+    auto unmap() noexcept -> void
+    {
+        if (m_data != nullptr)
+        {
+            ::munmap(m_data, m_size);
+        }
+    }
+
+  private:
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+} // namespace kirho
@@ -0,0 +1,416 @@
+/**
+ * @file memoize.hpp
+ * @brief Remembering what fallible functions returned.
+ *
+ * Contains @ref kirho::memoize_t, a cache that sits in front of a function
+ * that returns a @ref kirho::result_t, so that calling it again with the same
+ * arguments doesn't do the work again. Errors can be remembered too, for a
+ * shorter time than successes usually.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The settings of a @ref memoize_t.
+ */
+struct memoize_options_t
+{
+    using duration_t = std::chrono::steady_clock::duration;
+
+    /**
+     * @brief The most results that are remembered at once.
+     */
+    std::size_t capacity = 1024;
+
+    /**
+     * @brief The number of parts that the cache is split into, each with its
+     * own lock, so that threads looking up different keys rarely wait for
+     * each other.
+     */
+    std::size_t shards = 16;
+
+    /**
+     * @brief How long successes are remembered for. Forever by default.
+     */
+    duration_t success_ttl = duration_t::max();
+
+    /**
+     * @brief How long errors are remembered for. Not at all by default.
+     */
+    duration_t error_ttl = duration_t::zero();
+};
+
+template <typename S>
+class memoize_t;
+
+/**
+ * @brief A cache of the results of a function.
+ *
+ * Results are keyed by the arguments, which have to be hashable with
+ * `std::hash` and comparable with `==`, and are copied into the cache. When
+ * the cache is full, the CLOCK algorithm picks which result to throw out.
+ * Every result has a bit that's set whenever it's used, and a hand goes round
+ * the results, clearing those bits, until it finds one that hasn't been used
+ * since the last time it came past. Hits only need a shared lock, since all
+ * they do to the cache is set that bit.
+ *
+ * When several threads miss on the same key at the same time, only one of
+ * them runs the function, and the others wait for its result.
+ *
+ * @tparam T The type of the success value, which has to be copyable.
+ * @tparam E The type of the error, which has to be copyable.
+ * @tparam Args The types of the arguments.
+ */
+template <typename T, typename E, typename... Args>
+class memoize_t<result_t<T, E>(Args...)>
+{
+  public:
+    using function_t = std::function<result_t<T, E>(Args...)>;
+
+    /**
+     * @brief Creates an empty cache in front of the function.
+     */
+    explicit memoize_t(
+        function_t p_function,
+        memoize_options_t p_options = {}
+    )
+        : m_function{std::move(p_function)}, m_options{p_options}
+    {
+        if (m_options.shards == 0)
+        {
+            m_options.shards = 1;
+        }
+
+        const auto capacity = std::max(
+            (m_options.capacity + m_options.shards - 1) / m_options.shards,
+            std::size_t{1}
+        );
+
+        m_shards = std::make_unique<shard_t[]>(m_options.shards);
+        for (auto i = std::size_t{0}; i < m_options.shards; i++)
+        {
+            m_shards[i].entries = std::make_unique<entry_t[]>(capacity);
+            m_shards[i].capacity = capacity;
+        }
+    }
+
+    memoize_t(const memoize_t&) = delete;
+    memoize_t& operator=(const memoize_t&) = delete;
+
+    /**
+     * @brief Returns the result of calling the function with the arguments,
+     * from the cache if it's in there.
+     */
+    auto operator()(const Args&... args) -> result_t<T, E>
+    {
+        auto key = key_t{args...};
+        const auto hash = key_hash_t{}(key);
+        auto& shard = m_shards[hash % m_options.shards];
+
+        if (auto value = find(shard, key))
+        {
+            return to_result(std::move(*value));
+        }
+
+        // Either join the thread that's already working on it, or become the
+        // one that does.
+        auto future = std::shared_future<value_t>{};
+        auto promise = std::optional<std::promise<value_t>>{};
+        {
+            const auto lock = std::unique_lock{shard.mutex};
+            if (auto value = find_locked(shard, key))
+            {
+                return to_result(std::move(*value));
+            }
+
+            const auto flight = shard.flights.find(key);
+            if (flight != shard.flights.end())
+            {
+                future = flight->second;
+            }
+            else
+            {
+                promise.emplace();
+                future = promise->get_future().share();
+                shard.flights.emplace(key, future);
+            }
+        }
+
+        if (!promise)
+        {
+            return to_result(future.get());
+        }
+
+        // The threads that are waiting get the exception too, if there is
+        // one.
+        auto value = std::optional<value_t>{};
+        try
+        {
+            value.emplace(call(args...));
+        }
+        catch (...)
+        {
+            {
+                const auto lock = std::unique_lock{shard.mutex};
+                shard.flights.erase(key);
+            }
+            promise->set_exception(std::current_exception());
+            throw;
+        }
+
+        {
+            const auto lock = std::unique_lock{shard.mutex};
+            insert(shard, key, *value);
+            shard.flights.erase(key);
+        }
+        promise->set_value(*value);
+
+        return to_result(std::move(*value));
+    }
+
+    /**
+     * @brief Forgets everything.
+     */
+    auto clear() -> void
+    {
+        for (auto i = std::size_t{0}; i < m_options.shards; i++)
+        {
+            auto& shard = m_shards[i];
+            const auto lock = std::unique_lock{shard.mutex};
+            shard.index.clear();
+            shard.size = 0;
+            shard.hand = 0;
+            for (auto j = std::size_t{0}; j < shard.capacity; j++)
+            {
+                shard.entries[j].key.reset();
+                shard.entries[j].value.reset();
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of results in the cache, including the ones
+     * that have expired but haven't been thrown out yet.
+     */
+    auto size() const -> std::size_t
+    {
+        auto size = std::size_t{0};
+        for (auto i = std::size_t{0}; i < m_options.shards; i++)
+        {
+            const auto lock = std::shared_lock{m_shards[i].mutex};
+            size += m_shards[i].size;
+        }
+
+        return size;
+    }
+
+  private:
+    using clock_t = std::chrono::steady_clock;
+    using key_t = std::tuple<std::decay_t<Args>...>;
+    using value_t = std::variant<T, E>;
+
+    struct key_hash_t
+    {
+        auto operator()(const key_t& key) const noexcept -> std::size_t
+        {
+            return std::apply(
+                [](const auto&... parts) {
+                    auto seed = std::size_t{0};
+                    (..., combine(seed, parts));
+                    return seed;
+                },
+                key
+            );
+        }
+
+        template <typename U>
+        static auto combine(std::size_t& seed, const U& part) noexcept -> void
+        {
+            seed ^= std::hash<U>{}(part) + 0x9E3779B97F4A7C15 + (seed << 6) +
+                    (seed >> 2);
+        }
+    };
+
+    struct entry_t
+    {
+        std::optional<key_t> key;
+        std::optional<value_t> value;
+        clock_t::time_point expiry;
+        std::atomic<bool> referenced = false;
+    };
+
+    struct shard_t
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<key_t, std::size_t, key_hash_t> index;
+        std::unordered_map<key_t, std::shared_future<value_t>, key_hash_t>
+            flights;
+        std::unique_ptr<entry_t[]> entries;
+        std::size_t capacity = 0;
+        std::size_t size = 0;
+        std::size_t hand = 0;
+    };
+
+    static auto to_result(value_t value) -> result_t<T, E>
+    {
+        if (value.index() == 0)
+        {
+            return result_t<T, E>::success(std::get<0>(std::move(value)));
+        }
+
+        return result_t<T, E>::error(std::get<1>(std::move(value)));
+    }
+
+    auto call(const Args&... args) -> value_t
+    {
+        auto outcome = m_function(args...);
+        auto error = E{};
+        if (outcome.is_error(error))
+        {
+            return value_t{std::in_place_index<1>, std::move(error)};
+        }
+
+        return value_t{std::in_place_index<0>, std::move(outcome).unwrap()};
+    }
+
+    auto find(shard_t& shard, const key_t& key) const -> std::optional<value_t>
+    {
+        const auto lock = std::shared_lock{shard.mutex};
+        return find_locked(shard, key);
+    }
+
+    auto find_locked(shard_t& shard, const key_t& key) const
+        -> std::optional<value_t>
+    {
+        const auto found = shard.index.find(key);
+        if (found == shard.index.end())
+        {
+            return std::nullopt;
+        }
+
+        auto& entry = shard.entries[found->second];
+        if (clock_t::now() >= entry.expiry)
+        {
+            return std::nullopt;
+        }
+
+        entry.referenced.store(true, std::memory_order_relaxed);
+        return entry.value;
+    }
+
+    auto insert(shard_t& shard, const key_t& key, const value_t& value)
+        -> void
+    {
+        const auto ttl =
+            value.index() == 0 ? m_options.success_ttl : m_options.error_ttl;
+        if (ttl <= clock_t::duration::zero())
+        {
+            return;
+        }
+
+        const auto now = clock_t::now();
+        const auto expiry = ttl >= clock_t::time_point::max() - now
+                                ? clock_t::time_point::max()
+                                : now + ttl;
+
+        // Results that have expired are overwritten where they are.
+        auto slot = std::size_t{0};
+        const auto found = shard.index.find(key);
+        if (found != shard.index.end())
+        {
+            slot = found->second;
+        }
+        else if (shard.size < shard.capacity)
+        {
+            slot = shard.size++;
+            shard.index.emplace(key, slot);
+        }
+        else
+        {
+            slot = evict(shard);
+            shard.index.emplace(key, slot);
+        }
+
+        auto& entry = shard.entries[slot];
+        entry.key = key;
+        entry.value = value;
+        entry.expiry = expiry;
+        entry.referenced.store(false, std::memory_order_relaxed);
+    }
+
+    // Moves the hand round until it finds a result that hasn't been used
+    // since it last came past, or has expired, and throws that one out.
+    auto evict(shard_t& shard) -> std::size_t
+    {
+        const auto now = clock_t::now();
+        for (;;)
+        {
+            const auto slot = shard.hand;
+            auto& entry = shard.entries[slot];
+            shard.hand = (shard.hand + 1) % shard.capacity;
+
+            if (entry.expiry > now &&
+                entry.referenced.exchange(false, std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            shard.index.erase(*entry.key);
+            return slot;
+        }
+    }
+
+  private:
+    function_t m_function;
+    memoize_options_t m_options;
+    std::unique_ptr<shard_t[]> m_shards;
+};
+
+namespace detail
+{
+template <typename F>
+struct signature_of_t;
+
+template <typename R, typename... Args>
+struct signature_of_t<std::function<R(Args...)>>
+{
+    using type = R(Args...);
+};
+} // namespace detail
+
+/**
+ * @brief Creates a cache in front of the function, working out the types of
+ * the arguments and the result from it.
+ *
+ * The function can't be overloaded or generic, since there'd be no telling
+ * which arguments it takes.
+ */
+template <typename F>
+auto memoize(F function, memoize_options_t options = {})
+{
+    using function_t = decltype(std::function{std::move(function)});
+    using signature_t = typename detail::signature_of_t<function_t>::type;
+
+    return memoize_t<signature_t>{std::move(function), options};
+}
+} // namespace kirho
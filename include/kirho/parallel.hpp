@@ -0,0 +1,556 @@
+/**
+ * @file parallel.hpp
+ * @brief Going over big ranges on all of the threads of a pool.
+ *
+ * Contains @ref kirho::parallel_try_reduce, which folds a range into a single
+ * value on a @ref kirho::thread_pool_t with a function that can fail, and
+ * stops as soon as it does, and @ref kirho::parallel_for, which runs a
+ * function that can fail for every index, and collects the failures.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "kirho.hpp"
+#include "thread_pool.hpp"
+
+namespace kirho
+{
+namespace detail
+{
+// Every thread gets about this many chunks, so that a thread that's done
+// early has something to take over from the ones that aren't.
+constexpr auto chunks_per_thread = std::size_t{8};
+
+// Hands chunks out through a single counter, so whichever thread is free
+// takes the next one, and lets the calling thread wait for all of them.
+class chunks_t
+{
+  public:
+    explicit chunks_t(std::size_t p_count) noexcept : m_count{p_count}
+    {
+    }
+
+    // Runs chunks until there are none left. Called from the pool, and from
+    // the calling thread, which doesn't have to wait for the pool to get
+    // around to it.
+    template <typename F>
+    auto work(F&& run) -> void
+    {
+        for (;;)
+        {
+            const auto chunk = m_next.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= m_count)
+            {
+                return;
+            }
+
+            run(chunk);
+            if (m_finished.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+                m_count)
+            {
+                m_finished.notify_all();
+            }
+        }
+    }
+
+    // Waits for every chunk to be done, which is enough, since threads that
+    // start after that don't get one.
+    auto wait() const noexcept -> void
+    {
+        auto finished = m_finished.load(std::memory_order_acquire);
+        while (finished != m_count)
+        {
+            m_finished.wait(finished, std::memory_order_acquire);
+            finished = m_finished.load(std::memory_order_acquire);
+        }
+    }
+
+  private:
+    std::size_t m_count;
+    std::atomic<std::size_t> m_next = 0;
+    std::atomic<std::size_t> m_finished = 0;
+};
+
+// What the threads of a parallel_try_reduce share. Every chunk leaves its
+// accumulator in its own slot.
+template <typename It, typename Acc, typename E, typename Op>
+class reduction_t
+{
+  public:
+    reduction_t(
+        It p_begin,
+        std::size_t p_size,
+        std::size_t p_chunks,
+        const Acc& p_init,
+        Op& p_op
+    )
+        : m_begin{p_begin},
+          m_size{p_size},
+          m_count{p_chunks},
+          m_chunks{p_chunks},
+          m_init{p_init},
+          m_op{p_op},
+          m_partials(p_chunks)
+    {
+    }
+
+    auto work() -> void
+    {
+        m_chunks.work([this](std::size_t chunk) {
+            if (!m_failed.load(std::memory_order_relaxed))
+            {
+                run(chunk);
+            }
+        });
+    }
+
+    auto wait() const noexcept -> void
+    {
+        m_chunks.wait();
+    }
+
+    auto is_error(E& error) const -> bool
+    {
+        if (!m_error)
+        {
+            return false;
+        }
+
+        error = *m_error;
+        return true;
+    }
+
+    auto take_partials() noexcept -> std::vector<std::optional<Acc>>&
+    {
+        return m_partials;
+    }
+
+  private:
+    auto run(std::size_t chunk) -> void
+    {
+        const auto first = m_size * chunk / m_count;
+        const auto last = m_size * (chunk + 1) / m_count;
+
+        auto accumulator = m_init;
+        auto it = m_begin + static_cast<std::ptrdiff_t>(first);
+        for (auto i = first; i < last; i++, ++it)
+        {
+            auto outcome = m_op(std::move(accumulator), *it);
+            auto error = E{};
+            if (outcome.is_error(error))
+            {
+                fail(std::move(error));
+                return;
+            }
+
+            accumulator = std::move(outcome).unwrap();
+
+            // Checked every so often, so that the other chunks stop soon
+            // after one of them fails, without a load for every element.
+            if ((i & 255) == 255 && m_failed.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+
+        m_partials[chunk].emplace(std::move(accumulator));
+    }
+
+    auto fail(E error) -> void
+    {
+        if (!m_failed.exchange(true, std::memory_order_relaxed))
+        {
+            m_error.emplace(std::move(error));
+        }
+    }
+
+  private:
+    It m_begin;
+    std::size_t m_size;
+    std::size_t m_count;
+    chunks_t m_chunks;
+    const Acc& m_init;
+    Op& m_op;
+    std::vector<std::optional<Acc>> m_partials;
+    std::optional<E> m_error;
+    std::atomic<bool> m_failed = false;
+};
+} // namespace detail
+
+/**
+ * @brief Folds the range into a single value on all of the threads of the
+ * pool, stopping at the first error.
+ *
+ * The range is split into chunks, which the threads of the pool, and the
+ * calling thread, take one at a time until there are none left. Every chunk is
+ * folded on its own, starting from `init`, and then the chunks are combined
+ * pairwise, neighbours first, in a tree. That's always the same tree for the
+ * same number of threads, so the outcome doesn't depend on which thread was
+ * quicker, even for operations like adding floating point numbers.
+ *
+ * Since every chunk starts from `init`, it has to be what the operation
+ * leaves things as they are with, such as zero for a sum, and the operation
+ * has to be associative.
+ *
+ * As soon as one chunk fails, the others stop too, and the calling thread gets
+ * the error. If more than one of them fails, it's whichever failed first.
+ *
+ * The functions are called from several threads at once, so they have to be
+ * thread safe, and they must not throw.
+ *
+ * @param pool The pool to run the chunks on.
+ * @param range The range, which has to have random access.
+ * @param init The value that every chunk starts from.
+ * @param op Takes an accumulator and an element, and returns a
+ * `result_t<Acc, E>` of the new accumulator.
+ * @param combine Takes two accumulators, and returns a `result_t<Acc, E>` of
+ * both of them combined.
+ *
+ * @return The value that the whole range folds into, or the first error.
+ */
+template <
+    std::ranges::random_access_range R,
+    typename Acc,
+    typename Op,
+    typename Combine>
+auto parallel_try_reduce(
+    thread_pool_t& pool, R&& range, Acc init, Op op, Combine combine
+) -> std::invoke_result_t<Op&, Acc, std::ranges::range_reference_t<R>>
+{
+    using result =
+        std::invoke_result_t<Op&, Acc, std::ranges::range_reference_t<R>>;
+    using error_t = typename result::error_type;
+    using iterator_t = std::ranges::iterator_t<R>;
+    using reduction_t = detail::reduction_t<iterator_t, Acc, error_t, Op>;
+
+    const auto size = static_cast<std::size_t>(std::ranges::distance(range));
+    if (size == 0)
+    {
+        return result::success(std::move(init));
+    }
+
+    // The calling thread helps out, so it counts as one more thread.
+    const auto threads = pool.thread_count() + 1;
+    const auto chunks = std::min(size, threads * detail::chunks_per_thread);
+
+    // The pool might get around to its part after the calling thread is long
+    // gone, so what the threads share is kept alive by all of them.
+    auto reduction = std::make_shared<reduction_t>(
+        std::ranges::begin(range), size, chunks, init, op
+    );
+    for (auto i = std::size_t{1}; i < threads; i++)
+    {
+        pool.post([reduction]() { reduction->work(); });
+    }
+    reduction->work();
+    reduction->wait();
+
+    auto error = error_t{};
+    if (reduction->is_error(error))
+    {
+        return result::error(std::move(error));
+    }
+
+    auto& partials = reduction->take_partials();
+    for (auto width = std::size_t{1}; width < chunks; width *= 2)
+    {
+        for (auto i = std::size_t{0}; i + width < chunks; i += 2 * width)
+        {
+            auto combined = combine(
+                std::move(*partials[i]), std::move(*partials[i + width])
+            );
+            if (combined.is_error(error))
+            {
+                return result::error(std::move(error));
+            }
+
+            partials[i].emplace(std::move(combined).unwrap());
+        }
+    }
+
+    return result::success(std::move(*partials[0]));
+}
+
+/**
+ * @brief Folds the range into a single value on all of the threads of the
+ * pool, stopping at the first error, using the same operation to combine the
+ * chunks as to fold them.
+ *
+ * This works for ranges whose elements are accumulators themselves, such as
+ * sums of numbers.
+ */
+template <std::ranges::random_access_range R, typename Acc, typename Op>
+auto parallel_try_reduce(thread_pool_t& pool, R&& range, Acc init, Op op)
+    -> std::invoke_result_t<Op&, Acc, std::ranges::range_reference_t<R>>
+{
+    return parallel_try_reduce(
+        pool, std::forward<R>(range), std::move(init), op, op
+    );
+}
+
+namespace detail
+{
+// The arena that parallel_for hands out on this thread. It's kept around
+// between loops, so that its blocks are reused, unless a loop is run from
+// inside of another one, which then gets its own, so that it doesn't reset
+// the one that the outer loop is still using.
+class loop_arena_t
+{
+  public:
+    loop_arena_t()
+    {
+        if (busy())
+        {
+            m_arena = &m_nested.emplace();
+            return;
+        }
+
+        busy() = true;
+        m_arena = &shared();
+    }
+
+    loop_arena_t(const loop_arena_t&) = delete;
+    loop_arena_t& operator=(const loop_arena_t&) = delete;
+
+    ~loop_arena_t()
+    {
+        if (!m_nested)
+        {
+            busy() = false;
+        }
+    }
+
+    auto get() noexcept -> arena_t&
+    {
+        return *m_arena;
+    }
+
+  private:
+    static auto shared() -> arena_t&
+    {
+        thread_local auto arena = arena_t{};
+        return arena;
+    }
+
+    static auto busy() noexcept -> bool&
+    {
+        thread_local auto busy = false;
+        return busy;
+    }
+
+  private:
+    std::optional<arena_t> m_nested;
+    arena_t* m_arena = nullptr;
+};
+
+// What the function of a parallel_for returns, which depends on whether it
+// takes an arena.
+template <typename F>
+auto loop_outcome() noexcept
+{
+    if constexpr (std::is_invocable_v<F&, std::size_t, arena_t&>)
+    {
+        return std::type_identity<
+            std::invoke_result_t<F&, std::size_t, arena_t&>>{};
+    }
+    else
+    {
+        return std::type_identity<std::invoke_result_t<F&, std::size_t>>{};
+    }
+}
+
+template <typename F>
+using loop_error_t = typename decltype(loop_outcome<F>())::type::error_type;
+
+// What the threads of a parallel_for share. Every thread collects its errors
+// in its own list, so there's nothing to lock, and only the number of them is
+// shared, to keep to the cap.
+template <typename E, typename F>
+class loop_t
+{
+  public:
+    loop_t(
+        std::size_t p_count,
+        std::size_t p_grain,
+        std::size_t p_threads,
+        std::size_t p_max_errors,
+        F& p_f
+    )
+        : m_count{p_count},
+          m_grain{p_grain},
+          m_chunks{(p_count + p_grain - 1) / p_grain},
+          m_max_errors{p_max_errors},
+          m_f{p_f},
+          m_errors(p_threads)
+    {
+    }
+
+    auto work() -> void
+    {
+        auto arena = loop_arena_t{};
+        auto& errors =
+            m_errors[m_workers.fetch_add(1, std::memory_order_relaxed)];
+        m_chunks.work([&](std::size_t chunk) {
+            arena.get().reset();
+            const auto first = chunk * m_grain;
+            const auto last = std::min(m_count, first + m_grain);
+            for (auto i = first; i < last; i++)
+            {
+                if (m_full.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+
+                auto error = E{};
+                if (call(i, arena.get()).is_error(error))
+                {
+                    record(errors, i, std::move(error));
+                }
+            }
+        });
+    }
+
+    auto wait() const noexcept -> void
+    {
+        m_chunks.wait();
+    }
+
+    // Gathers the errors of every thread, in order of their indices.
+    auto take_errors() -> std::vector<std::pair<std::size_t, E>>
+    {
+        auto all = std::vector<std::pair<std::size_t, E>>{};
+        for (auto& errors : m_errors)
+        {
+            std::move(errors.begin(), errors.end(), std::back_inserter(all));
+        }
+
+        std::sort(all.begin(), all.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+        return all;
+    }
+
+  private:
+    auto call(std::size_t index, arena_t& arena)
+    {
+        if constexpr (std::is_invocable_v<F&, std::size_t, arena_t&>)
+        {
+            return m_f(index, arena);
+        }
+        else
+        {
+            return m_f(index);
+        }
+    }
+
+    auto record(
+        std::vector<std::pair<std::size_t, E>>& errors,
+        std::size_t index,
+        E error
+    ) -> void
+    {
+        const auto count =
+            m_error_count.fetch_add(1, std::memory_order_relaxed);
+        if (count < m_max_errors)
+        {
+            errors.emplace_back(index, std::move(error));
+        }
+
+        if (count + 1 >= m_max_errors)
+        {
+            m_full.store(true, std::memory_order_relaxed);
+        }
+    }
+
+  private:
+    std::size_t m_count;
+    std::size_t m_grain;
+    chunks_t m_chunks;
+    std::size_t m_max_errors;
+    F& m_f;
+    std::vector<std::vector<std::pair<std::size_t, E>>> m_errors;
+    std::atomic<std::size_t> m_workers = 0;
+    std::atomic<std::size_t> m_error_count = 0;
+    std::atomic<bool> m_full = false;
+};
+} // namespace detail
+
+/**
+ * @brief Runs the function for every index from zero up to `count`, on all
+ * of the threads of the pool, and collects the indices for which it failed.
+ *
+ * The indices are split into chunks of `grain` of them, which the threads of
+ * the pool, and the calling thread, take one at a time until there are none
+ * left. A failure doesn't stop the loop, so every one of them is found, up to
+ * `max_errors` of them, at which point the loop does stop. Which ones are kept
+ * then is down to which threads got to them first.
+ *
+ * The function can also take an @ref arena_t, as its second argument, for
+ * scratch memory. Every thread has its own, which is reset before every
+ * chunk, and kept around between loops.
+ *
+ * The function is called from several threads at once, so it has to be
+ * thread safe, and it must not throw.
+ *
+ * @param pool The pool to run the chunks on.
+ * @param count The number of indices.
+ * @param grain The number of indices in every chunk.
+ * @param f Takes an index, and maybe an arena, and returns a `status_t<E>`.
+ * @param max_errors The most failures that are collected.
+ *
+ * @return Nothing, or the indices that failed along with their errors, in
+ * order of their indices.
+ */
+template <typename F>
+auto parallel_for(
+    thread_pool_t& pool,
+    std::size_t count,
+    std::size_t grain,
+    F f,
+    std::size_t max_errors = 64
+) -> status_t<std::vector<std::pair<std::size_t, detail::loop_error_t<F>>>>
+{
+    using error_t = detail::loop_error_t<F>;
+    using result = status_t<std::vector<std::pair<std::size_t, error_t>>>;
+
+    if (count == 0)
+    {
+        return result::success();
+    }
+
+    // The calling thread helps out, so it counts as one more thread.
+    const auto threads = pool.thread_count() + 1;
+    auto loop = std::make_shared<detail::loop_t<error_t, F>>(
+        count,
+        grain == 0 ? 1 : grain,
+        threads,
+        max_errors == 0 ? 1 : max_errors,
+        f
+    );
+    for (auto i = std::size_t{1}; i < threads; i++)
+    {
+        pool.post([loop]() { loop->work(); });
+    }
+    loop->work();
+    loop->wait();
+
+    auto errors = loop->take_errors();
+    if (!errors.empty())
+    {
+        return result::error(std::move(errors));
+    }
+
+    return result::success();
+}
+} // namespace kirho
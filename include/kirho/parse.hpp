@@ -0,0 +1,323 @@
+/**
+ * @file parse.hpp
+ * @brief Parsing numbers out of text.
+ *
+ * Contains @ref kirho::parse, which turns text into numbers and tells you what
+ * was wrong with the text when it can't, instead of throwing like `std::stoi`
+ * does.
+ */
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The reason why some text could not be parsed as a number.
+ */
+struct parse_error_t
+{
+    /**
+     * @brief The kinds of things that can be wrong with the text.
+     */
+    enum class kind_t
+    {
+        /// There was no text at all.
+        empty,
+        /// There was a character that doesn't belong in a number.
+        invalid_character,
+        /// The number doesn't fit into the type.
+        overflow,
+        /// The number is too close to zero for the floating point type.
+        underflow,
+    };
+
+    /**
+     * @brief Where in the text the problem is.
+     *
+     * For invalid characters, this is the offset of the first one. For
+     * overflows and underflows, this is the start of the number.
+     */
+    std::size_t offset = 0;
+
+    /**
+     * @brief What the problem is.
+     */
+    kind_t kind = kind_t::empty;
+
+    auto operator==(const parse_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const parse_error_t& error)
+    -> std::ostream&
+{
+    switch (error.kind)
+    {
+    case parse_error_t::kind_t::empty:
+        return stream << "nothing to parse";
+    case parse_error_t::kind_t::invalid_character:
+        return stream << "invalid character at offset " << error.offset;
+    case parse_error_t::kind_t::overflow:
+        return stream << "number at offset " << error.offset
+                      << " is out of range";
+    case parse_error_t::kind_t::underflow:
+        return stream << "number at offset " << error.offset
+                      << " is too close to zero";
+    }
+
+    return stream;
+}
+
+/**
+ * @brief The types that @ref parse can turn text into.
+ */
+template <typename T>
+concept parsable_t = (std::integral<T> && !std::same_as<T, bool>) ||
+                     std::floating_point<T>;
+
+namespace detail
+{
+// Checks if all of the eight bytes are ASCII digits. This and the function
+// below come from the fast_float and simdjson libraries, and only work on
+// little endian machines.
+inline auto is_eight_digits(std::uint64_t chunk) noexcept -> bool
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+            (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+           0x3333333333333333;
+}
+
+// Turns eight ASCII digits into the number that they represent, with three
+// multiplications instead of eight.
+inline auto parse_eight_digits(std::uint64_t chunk) noexcept -> std::uint64_t
+{
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8);
+    return (((chunk & 0x000000FF000000FF) * 0x000F424000000064) +
+            (((chunk >> 16) & 0x000000FF000000FF) * 0x0000271000000001)) >>
+           32;
+}
+
+// Parses a run of up to 19 digits, which is as many as always fit into 64
+// bits. Returns false if there is anything other than digits in there.
+inline auto parse_digits(std::string_view text, std::uint64_t& value) noexcept
+    -> bool
+{
+    auto position = std::size_t{0};
+    value = 0;
+
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        while (text.size() - position >= 8)
+        {
+            auto chunk = std::uint64_t{0};
+            std::memcpy(&chunk, text.data() + position, sizeof(chunk));
+            if (!is_eight_digits(chunk))
+            {
+                return false;
+            }
+
+            value = value * 100000000 + parse_eight_digits(chunk);
+            position += 8;
+        }
+    }
+
+    for (; position < text.size(); position++)
+    {
+        const auto digit = static_cast<unsigned char>(text[position] - '0');
+        if (digit > 9)
+        {
+            return false;
+        }
+
+        value = value * 10 + digit;
+    }
+
+    return true;
+}
+
+// Works out whether a floating point number that from_chars says is out of
+// range is too close to zero, rather than too big, since it doesn't tell the
+// two apart. That's down to whether the first significant digit ends up before
+// or after the decimal point, once the exponent is taken into account.
+inline auto is_too_small(std::string_view text) noexcept -> bool
+{
+    auto position = text.begin() + (text.starts_with('-') ? 1 : 0);
+
+    // The power of ten of the first significant digit.
+    auto scale = 0l;
+    auto significant = false;
+    auto fraction = false;
+    for (; position != text.end() && *position != 'e' && *position != 'E';
+         position++)
+    {
+        if (*position == '.')
+        {
+            fraction = true;
+            continue;
+        }
+
+        if (fraction)
+        {
+            scale -= significant ? 0 : 1;
+            significant = significant || *position != '0';
+        }
+        else if (significant)
+        {
+            scale++;
+        }
+        else
+        {
+            significant = *position != '0';
+        }
+    }
+
+    // Exponents are capped well beyond what any floating point type can hold,
+    // so that adding them up can't overflow.
+    auto exponent = 0l;
+    if (position != text.end())
+    {
+        position++;
+        const auto negative = position != text.end() && *position == '-';
+        if (position != text.end() && (*position == '-' || *position == '+'))
+        {
+            position++;
+        }
+
+        for (; position != text.end(); position++)
+        {
+            exponent = std::min(exponent * 10 + (*position - '0'), 100000l);
+        }
+        exponent = negative ? -exponent : exponent;
+    }
+
+    return scale + exponent < 0;
+}
+
+// The slow but thorough way, which is also what figures out what exactly is
+// wrong with the text.
+template <parsable_t T>
+auto parse_with_from_chars(std::string_view text) noexcept
+    -> result_t<T, parse_error_t>
+{
+    using result = result_t<T, parse_error_t>;
+
+    const auto begin = text.data();
+    const auto end = text.data() + text.size();
+
+    auto value = T{};
+    const auto [pointer, error] = std::from_chars(begin, end, value);
+    if (error == std::errc::result_out_of_range)
+    {
+        if constexpr (std::floating_point<T>)
+        {
+            if (is_too_small(text))
+            {
+                return result::error({0, parse_error_t::kind_t::underflow});
+            }
+        }
+
+        return result::error({0, parse_error_t::kind_t::overflow});
+    }
+
+    if (error != std::errc{})
+    {
+        // from_chars doesn't tell us where exactly it gave up, but the only
+        // way for it to not find a number at all is if the first character
+        // after the sign is wrong.
+        const auto has_sign = std::is_signed_v<T> && text.front() == '-';
+        const auto offset = has_sign && text.size() > 1 ? 1 : 0;
+        return result::error(
+            {static_cast<std::size_t>(offset),
+             parse_error_t::kind_t::invalid_character}
+        );
+    }
+
+    if (pointer != end)
+    {
+        return result::error(
+            {static_cast<std::size_t>(pointer - begin),
+             parse_error_t::kind_t::invalid_character}
+        );
+    }
+
+    return result::success(value);
+}
+} // namespace detail
+
+/**
+ * @brief Parses the whole of the text as a number.
+ *
+ * The text has to be a number and nothing else, so no spaces, and no plus
+ * signs either. It's the same format as the one `std::from_chars` takes.
+ * Integers of up to 19 digits are parsed eight digits at a time, and
+ * everything else is left to `std::from_chars`, which already uses the
+ * Eisel-Lemire algorithm for floating point numbers in recent standard
+ * libraries.
+ *
+ * @tparam T The type of number.
+ *
+ * @param text The text to parse.
+ *
+ * @return The number, or the reason why the text isn't one.
+ */
+template <parsable_t T>
+auto parse(std::string_view text) noexcept -> result_t<T, parse_error_t>
+{
+    using result = result_t<T, parse_error_t>;
+
+    if (text.empty())
+    {
+        return result::error({0, parse_error_t::kind_t::empty});
+    }
+
+    if constexpr (std::integral<T>)
+    {
+        const auto negative = std::is_signed_v<T> && text.front() == '-';
+        const auto digits = text.substr(negative ? 1 : 0);
+
+        auto magnitude = std::uint64_t{0};
+        if (!digits.empty() && digits.size() <= 19 &&
+            detail::parse_digits(digits, magnitude))
+        {
+            using unsigned_t = std::make_unsigned_t<T>;
+            constexpr auto max = static_cast<std::uint64_t>(
+                std::numeric_limits<T>::max()
+            );
+
+            if (!negative && magnitude <= max)
+            {
+                return result::success(static_cast<T>(magnitude));
+            }
+
+            if (negative && magnitude <= max + 1)
+            {
+                return result::success(static_cast<T>(
+                    static_cast<unsigned_t>(0) -
+                    static_cast<unsigned_t>(magnitude)
+                ));
+            }
+
+            return result::error({0, parse_error_t::kind_t::overflow});
+        }
+    }
+
+    return detail::parse_with_from_chars<T>(text);
+}
+} // namespace kirho
@@ -0,0 +1,685 @@
+/**
+ * @file pipeline.hpp
+ * @brief Running items through several fallible steps, on several threads.
+ *
+ * Contains @ref kirho::pipeline_t, which chains stages of functions that
+ * return a @ref kirho::result_t, each running on its own threads, with
+ * bounded queues in between, so that a slow stage holds the ones before it
+ * back instead of letting its queue grow without end. Items that fail go to
+ * an error sink instead of on to the next stage. The queues are
+ * @ref kirho::bounded_queue_t, which can also be used on their own.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+namespace detail
+{
+// Waits for a queue to change, spinning at first, then giving the core up,
+// and finally sleeping, so that idle stages don't keep a core busy.
+class backoff_t
+{
+  public:
+    auto wait() noexcept -> void
+    {
+        if (m_step < 16)
+        {
+            m_step++;
+        }
+        else if (m_step < 64)
+        {
+            m_step++;
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds{50});
+        }
+    }
+
+  private:
+    int m_step = 0;
+};
+} // namespace detail
+
+/**
+ * @brief A bounded queue that any number of threads can push to and pop from
+ * at the same time, without locks.
+ *
+ * Every slot has a sequence number that says whether it's ready to be written
+ * or read, so pushing and popping each take one compare-and-swap on a shared
+ * index, and then only touch their own slot. The queue can also be closed,
+ * which tells the threads popping from it that nothing more is coming.
+ *
+ * @tparam T The type of the items, which has to be default constructible and
+ * movable.
+ */
+template <typename T>
+class bounded_queue_t
+{
+  public:
+    /**
+     * @brief Creates an empty queue.
+     *
+     * @param capacity The most items that the queue holds, which is rounded up
+     * to a power of two.
+     */
+    explicit bounded_queue_t(std::size_t capacity)
+    {
+        auto size = std::size_t{2};
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+
+        m_mask = size - 1;
+        m_cells = std::make_unique<cell_t[]>(size);
+        for (auto i = std::size_t{0}; i < size; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bounded_queue_t(const bounded_queue_t&) = delete;
+    bounded_queue_t& operator=(const bounded_queue_t&) = delete;
+
+    /**
+     * @brief Pushes the item, unless the queue is full.
+     *
+     * @return Whether the item was pushed. If it wasn't, it's left as it was.
+     */
+    auto try_push(T& item) -> bool
+    {
+        auto position = m_tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = m_cells[position & m_mask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) -
+                                    static_cast<std::intptr_t>(position);
+            if (difference == 0)
+            {
+                if (m_tail.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed
+                    ))
+                {
+                    cell.item = std::move(item);
+                    cell.sequence.store(
+                        position + 1, std::memory_order_release
+                    );
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Pops an item, unless the queue is empty.
+     *
+     * @return Whether an item was popped into `item`.
+     */
+    auto try_pop(T& item) -> bool
+    {
+        auto position = m_head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = m_cells[position & m_mask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) -
+                                    static_cast<std::intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (m_head.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed
+                    ))
+                {
+                    item = std::move(cell.item);
+                    cell.sequence.store(
+                        position + m_mask + 1, std::memory_order_release
+                    );
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Pushes the item, waiting for room if the queue is full.
+     */
+    auto push(T item) -> void
+    {
+        auto backoff = detail::backoff_t{};
+        while (!try_push(item))
+        {
+            backoff.wait();
+        }
+    }
+
+    /**
+     * @brief Pops an item, waiting for one if the queue is empty.
+     *
+     * @return Whether an item was popped, which is only false once the queue
+     * is closed and empty.
+     */
+    auto pop(T& item) -> bool
+    {
+        auto backoff = detail::backoff_t{};
+        while (!try_pop(item))
+        {
+            // Everything pushed before closing is visible once we see it
+            // closed, so one more try tells us whether it's really empty.
+            if (m_closed.load(std::memory_order_acquire))
+            {
+                return try_pop(item);
+            }
+
+            backoff.wait();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Says that nothing more is going to be pushed.
+     */
+    auto close() noexcept -> void
+    {
+        m_closed.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns about how many items are in the queue.
+     */
+    auto size() const noexcept -> std::size_t
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    /**
+     * @brief Returns the most items that the queue holds.
+     */
+    auto capacity() const noexcept -> std::size_t
+    {
+        return m_mask + 1;
+    }
+
+  private:
+    struct cell_t
+    {
+        std::atomic<std::size_t> sequence;
+        T item;
+    };
+
+    // The two ends are on their own cache lines, so that the threads pushing
+    // and the ones popping don't slow each other down.
+    alignas(64) std::atomic<std::size_t> m_tail = 0;
+    alignas(64) std::atomic<std::size_t> m_head = 0;
+    alignas(64) std::atomic<bool> m_closed = false;
+    std::size_t m_mask = 0;
+    std::unique_ptr<cell_t[]> m_cells;
+};
+
+/**
+ * @brief How a stage of a @ref pipeline_t runs.
+ */
+struct stage_options_t
+{
+    /**
+     * @brief The number of threads that run the stage.
+     */
+    std::size_t threads = 1;
+
+    /**
+     * @brief The most items that can wait in between the stage and the next
+     * one.
+     */
+    std::size_t capacity = 1024;
+};
+
+/**
+ * @brief What a stage of a @ref pipeline_t has been up to.
+ */
+struct stage_metrics_t
+{
+    /**
+     * @brief The name that the stage was given.
+     */
+    std::string name;
+
+    /**
+     * @brief The number of items that the stage dealt with successfully.
+     */
+    std::uint64_t processed = 0;
+
+    /**
+     * @brief The number of items that failed in the stage, and went to the
+     * error sink.
+     */
+    std::uint64_t failed = 0;
+
+    /**
+     * @brief About how many items are waiting in front of the stage.
+     */
+    std::size_t queue_depth = 0;
+
+    /**
+     * @brief The number of items that the stage has dealt with per second,
+     * since the pipeline started.
+     */
+    double throughput = 0.0;
+};
+
+namespace detail
+{
+class stage_base_t
+{
+  public:
+    virtual ~stage_base_t() = default;
+
+    virtual auto start() -> void = 0;
+    virtual auto join() -> void = 0;
+    virtual auto metrics(double seconds) const -> stage_metrics_t = 0;
+};
+
+// A stage that takes items of type I, and passes items of type O on, unless
+// it's the last stage, in which case O is void.
+template <typename I, typename O, typename E>
+class stage_t final : public stage_base_t
+{
+  public:
+    using output_t = std::conditional_t<std::is_void_v<O>, empty_t, O>;
+    using return_t =
+        std::conditional_t<std::is_void_v<O>, void, result_t<output_t, E>>;
+    using function_t = std::function<return_t(I)>;
+
+    stage_t(
+        std::string p_name,
+        function_t p_function,
+        std::size_t p_threads,
+        std::shared_ptr<bounded_queue_t<I>> p_input,
+        std::shared_ptr<bounded_queue_t<output_t>> p_output,
+        std::shared_ptr<std::function<void(E)>> p_errors
+    )
+        : m_name{std::move(p_name)},
+          m_function{std::move(p_function)},
+          m_input{std::move(p_input)},
+          m_output{std::move(p_output)},
+          m_errors{std::move(p_errors)},
+          m_counters(p_threads == 0 ? 1 : p_threads)
+    {
+    }
+
+    auto start() -> void override
+    {
+        m_running.store(m_counters.size(), std::memory_order_relaxed);
+        for (auto i = std::size_t{0}; i < m_counters.size(); i++)
+        {
+            m_threads.emplace_back([this, i]() { work(m_counters[i]); });
+        }
+    }
+
+    auto join() -> void override
+    {
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+        m_threads.clear();
+    }
+
+    auto metrics(double seconds) const -> stage_metrics_t override
+    {
+        auto metrics = stage_metrics_t{};
+        metrics.name = m_name;
+        for (const auto& counter : m_counters)
+        {
+            metrics.processed +=
+                counter.processed.load(std::memory_order_relaxed);
+            metrics.failed += counter.failed.load(std::memory_order_relaxed);
+        }
+
+        metrics.queue_depth = m_input->size();
+        metrics.throughput =
+            seconds > 0.0
+                ? static_cast<double>(metrics.processed + metrics.failed) /
+                      seconds
+                : 0.0;
+        return metrics;
+    }
+
+  private:
+    // Every thread counts in its own cache line, so counting is free.
+    struct alignas(64) counter_t
+    {
+        std::atomic<std::uint64_t> processed = 0;
+        std::atomic<std::uint64_t> failed = 0;
+    };
+
+    auto work(counter_t& counter) -> void
+    {
+        auto item = I{};
+        while (m_input->pop(item))
+        {
+            if constexpr (std::is_void_v<O>)
+            {
+                m_function(std::move(item));
+                counter.processed.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                auto outcome = m_function(std::move(item));
+                auto error = E{};
+                if (outcome.is_error(error))
+                {
+                    (*m_errors)(std::move(error));
+                    counter.failed.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                m_output->push(std::move(outcome).unwrap());
+                counter.processed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // The last thread out tells the next stage that nothing more is
+        // coming.
+        if (m_running.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+            m_output != nullptr)
+        {
+            m_output->close();
+        }
+    }
+
+  private:
+    std::string m_name;
+    function_t m_function;
+    std::shared_ptr<bounded_queue_t<I>> m_input;
+    std::shared_ptr<bounded_queue_t<output_t>> m_output;
+    std::shared_ptr<std::function<void(E)>> m_errors;
+    std::vector<counter_t> m_counters;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::size_t> m_running = 0;
+};
+} // namespace detail
+
+template <typename In, typename T, typename E>
+class pipeline_builder_t;
+
+template <typename In, typename E>
+auto make_pipeline(std::function<void(E)> errors, std::size_t capacity = 1024)
+    -> pipeline_builder_t<In, In, E>;
+
+/**
+ * @brief A running pipeline, which takes items of type `In`.
+ *
+ * Pipelines are put together with @ref make_pipeline, one stage at a time,
+ * and start running once the last stage is added. Every stage has its own
+ * threads, which pop items from the queue in front of it, run the function on
+ * them, and push the successes to the queue in front of the next stage. When
+ * a queue is full, the stage in front of it waits, and so on back to
+ * @ref push.
+ *
+ * The functions and the error sink are called from several threads at once,
+ * so they have to be thread safe, and they must not throw.
+ *
+ * @tparam In The type of the items that go in.
+ * @tparam E The type of the errors.
+ */
+template <typename In, typename E>
+class pipeline_t
+{
+  public:
+    pipeline_t(const pipeline_t&) = delete;
+    pipeline_t& operator=(const pipeline_t&) = delete;
+
+    /**
+     * @brief Lets the items that are already in finish, and stops the
+     * threads.
+     */
+    ~pipeline_t()
+    {
+        wait();
+    }
+
+    /**
+     * @brief Puts the item into the pipeline, waiting for room if the first
+     * stage is behind.
+     */
+    auto push(In item) -> void
+    {
+        m_input->push(std::move(item));
+    }
+
+    /**
+     * @brief Puts the item into the pipeline, unless the first stage is
+     * behind.
+     *
+     * @return Whether the item was put in. If it wasn't, it's left as it was.
+     */
+    auto try_push(In& item) -> bool
+    {
+        return m_input->try_push(item);
+    }
+
+    /**
+     * @brief Says that no more items are coming, waits for the ones that are
+     * already in to go all the way through, and stops the threads.
+     *
+     * Nothing can be pushed afterwards.
+     */
+    auto wait() -> void
+    {
+        if (m_finished)
+        {
+            return;
+        }
+
+        m_input->close();
+        for (auto& stage : m_stages)
+        {
+            stage->join();
+        }
+        m_finished = true;
+    }
+
+    /**
+     * @brief Returns what every stage has been up to, in order.
+     */
+    auto metrics() const -> std::vector<stage_metrics_t>
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        const auto seconds = std::chrono::duration<double>(elapsed).count();
+
+        auto metrics = std::vector<stage_metrics_t>{};
+        metrics.reserve(m_stages.size());
+        for (const auto& stage : m_stages)
+        {
+            metrics.push_back(stage->metrics(seconds));
+        }
+
+        return metrics;
+    }
+
+  private:
+    template <typename, typename, typename>
+    friend class pipeline_builder_t;
+
+    pipeline_t(
+        std::shared_ptr<bounded_queue_t<In>> p_input,
+        std::vector<std::unique_ptr<detail::stage_base_t>> p_stages
+    )
+        : m_input{std::move(p_input)},
+          m_stages{std::move(p_stages)},
+          m_start{std::chrono::steady_clock::now()}
+    {
+        for (auto& stage : m_stages)
+        {
+            stage->start();
+        }
+    }
+
+  private:
+    std::shared_ptr<bounded_queue_t<In>> m_input;
+    std::vector<std::unique_ptr<detail::stage_base_t>> m_stages;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_finished = false;
+};
+
+/**
+ * @brief A pipeline that's still being put together, whose last stage so
+ * far passes on items of type `T`.
+ */
+template <typename In, typename T, typename E>
+class pipeline_builder_t
+{
+  public:
+    /**
+     * @brief Adds a stage that turns each item into another one, or fails.
+     *
+     * @param name The name of the stage, for the metrics.
+     * @param f The function, which takes a `T` and returns a `result_t` of the
+     * item to pass on and `E`.
+     * @param options How the stage runs.
+     */
+    template <typename F>
+    auto then(std::string name, F f, stage_options_t options = {}) &&
+    {
+        using outcome_t = std::invoke_result_t<F&, T>;
+        using out_t = typename outcome_t::value_type;
+        static_assert(
+            std::is_same_v<typename outcome_t::error_type, E>,
+            "every stage has to fail with the same type of error"
+        );
+
+        auto output = std::make_shared<bounded_queue_t<out_t>>(
+            options.capacity
+        );
+        m_stages.push_back(std::make_unique<detail::stage_t<T, out_t, E>>(
+            std::move(name),
+            std::move(f),
+            options.threads,
+            m_output,
+            output,
+            m_errors
+        ));
+
+        return pipeline_builder_t<In, out_t, E>{
+            std::move(m_input),
+            std::move(output),
+            std::move(m_stages),
+            std::move(m_errors)
+        };
+    }
+
+    /**
+     * @brief Adds the last stage, which takes the items that made it all the
+     * way through, and starts the pipeline.
+     *
+     * @param name The name of the stage, for the metrics.
+     * @param f The function, which takes a `T` and returns nothing.
+     * @param options How the stage runs. The capacity doesn't matter, since
+     * nothing comes after it.
+     */
+    template <typename F>
+    auto sink(std::string name, F f, stage_options_t options = {}) &&
+        -> std::unique_ptr<pipeline_t<In, E>>
+    {
+        m_stages.push_back(std::make_unique<detail::stage_t<T, void, E>>(
+            std::move(name),
+            std::move(f),
+            options.threads,
+            m_output,
+            nullptr,
+            m_errors
+        ));
+
+        return std::unique_ptr<pipeline_t<In, E>>{
+            new pipeline_t<In, E>{std::move(m_input), std::move(m_stages)}
+        };
+    }
+
+  private:
+    template <typename, typename, typename>
+    friend class pipeline_builder_t;
+
+    template <typename I, typename Er>
+    friend auto make_pipeline(
+        std::function<void(Er)> errors,
+        std::size_t capacity
+    ) -> pipeline_builder_t<I, I, Er>;
+
+    pipeline_builder_t(
+        std::shared_ptr<bounded_queue_t<In>> p_input,
+        std::shared_ptr<bounded_queue_t<T>> p_output,
+        std::vector<std::unique_ptr<detail::stage_base_t>> p_stages,
+        std::shared_ptr<std::function<void(E)>> p_errors
+    )
+        : m_input{std::move(p_input)},
+          m_output{std::move(p_output)},
+          m_stages{std::move(p_stages)},
+          m_errors{std::move(p_errors)}
+    {
+    }
+
+  private:
+    std::shared_ptr<bounded_queue_t<In>> m_input;
+    std::shared_ptr<bounded_queue_t<T>> m_output;
+    std::vector<std::unique_ptr<detail::stage_base_t>> m_stages;
+    std::shared_ptr<std::function<void(E)>> m_errors;
+};
+
+/**
+ * @brief Starts putting a pipeline together.
+ *
+ * @tparam In The type of the items that go in.
+ * @tparam E The type of the errors.
+ *
+ * @param errors The error sink, which gets the errors of the items that fail
+ * in any of the stages.
+ * @param capacity The most items that can wait in front of the first stage.
+ */
+template <typename In, typename E>
+auto make_pipeline(std::function<void(E)> errors, std::size_t capacity)
+    -> pipeline_builder_t<In, In, E>
+{
+    auto input = std::make_shared<bounded_queue_t<In>>(capacity);
+    return pipeline_builder_t<In, In, E>{
+        input,
+        input,
+        {},
+        std::make_shared<std::function<void(E)>>(std::move(errors))
+    };
+}
+} // namespace kirho
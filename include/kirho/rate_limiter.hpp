@@ -0,0 +1,260 @@
+/**
+ * @file rate_limiter.hpp
+ * @brief Keeping the rate at which things happen in check.
+ *
+ * Contains @ref kirho::rate_limiter_t, a token bucket for admission control,
+ * whose whole state is a single 64-bit atomic, so that threads never wait for
+ * each other to take tokens out of it.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The error for when there aren't enough tokens in the bucket.
+ */
+struct rate_limited_t
+{
+    using duration_t = std::chrono::steady_clock::duration;
+
+    /**
+     * @brief How long until there will be enough tokens, if nobody else takes
+     * them first. This is the maximum duration if there never will be, since
+     * more tokens were asked for than the bucket can hold.
+     */
+    duration_t retry_after = duration_t::zero();
+
+    auto operator==(const rate_limited_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const rate_limited_t& error)
+    -> std::ostream&
+{
+    return stream << "rate limited, retry after "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(
+                         error.retry_after
+                     )
+                         .count()
+                  << "us";
+}
+
+/**
+ * @brief A token bucket that refills at a steady rate, up to a maximum.
+ *
+ * Rather than counting the tokens, the bucket keeps the point in time at
+ * which it will be full again, in nanoseconds since it was created, which is
+ * what the generic cell rate algorithm does. Taking tokens pushes that point
+ * further into the future, and the tokens are only there if it doesn't end up
+ * further away than the whole bucket takes to refill. That's one number, so it
+ * fits in an atomic, and taking tokens is a load and a compare-and-swap.
+ *
+ * Rates are rounded to a whole number of nanoseconds per token, so they
+ * aren't exact past a few million tokens a second.
+ */
+class rate_limiter_t
+{
+  public:
+    using clock_t = std::chrono::steady_clock;
+    using result = result_t<empty_t, rate_limited_t>;
+
+    /**
+     * @brief Creates a bucket that starts out full.
+     *
+     * @param p_rate How many tokens are added every second.
+     * @param p_burst How many tokens the bucket holds.
+     */
+    rate_limiter_t(double p_rate, std::uint64_t p_burst) noexcept
+        : m_interval{interval_of(p_rate)},
+          m_tolerance{m_interval * p_burst},
+          m_start{clock_t::now()}
+    {
+    }
+
+    rate_limiter_t(const rate_limiter_t&) = delete;
+    rate_limiter_t& operator=(const rate_limiter_t&) = delete;
+
+    /**
+     * @brief Takes tokens out of the bucket, if there are enough of them.
+     *
+     * Either all of them are taken, or none of them are.
+     *
+     * @param count The number of tokens to take.
+     *
+     * @return Nothing, or how long to wait until there will be enough tokens.
+     */
+    auto try_acquire(std::uint64_t count = 1) noexcept -> result
+    {
+        const auto now = elapsed();
+        const auto cost = count * m_interval;
+        if (count != 0 && cost / count != m_interval)
+        {
+            return result::error({rate_limited_t::duration_t::max()});
+        }
+
+        auto full_at = m_full_at.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            const auto start = full_at > now ? full_at : now;
+            const auto next = start + cost;
+            if (next - now > m_tolerance)
+            {
+                return result::error({retry_after(next - now, cost)});
+            }
+
+            if (m_full_at.compare_exchange_weak(
+                    full_at, next, std::memory_order_relaxed
+                ))
+            {
+                return result::success();
+            }
+        }
+    }
+
+    /**
+     * @brief Returns about how many tokens are in the bucket right now.
+     */
+    auto available() const noexcept -> std::uint64_t
+    {
+        // Someone else can take tokens between the load and reading the
+        // clock, which can push the point further away than the bucket
+        // allows, so what's used is never more than all of it.
+        const auto full_at = m_full_at.load(std::memory_order_relaxed);
+        const auto now = elapsed();
+        const auto used = full_at > now ? full_at - now : 0;
+        return (m_tolerance - (used < m_tolerance ? used : m_tolerance)) /
+               m_interval;
+    }
+
+    /**
+     * @brief A thread's own stash of tokens, taken out of a bucket in batches.
+     *
+     * Threads that take tokens very often can take them from a stash instead,
+     * which only goes to the shared bucket once it runs out, so there's only
+     * one atomic operation for every batch. The catch is that the tokens in
+     * stashes are gone from the bucket before they are used, so the limit is
+     * enforced in steps of a batch. Stashes aren't thread safe, so every
+     * thread needs its own.
+     */
+    class local_t
+    {
+      public:
+        /**
+         * @brief Creates an empty stash.
+         *
+         * @param p_limiter The bucket to take the tokens from.
+         * @param p_batch How many tokens to take at once.
+         */
+        local_t(rate_limiter_t& p_limiter, std::uint64_t p_batch) noexcept
+            : m_limiter{p_limiter}, m_batch{p_batch == 0 ? 1 : p_batch}
+        {
+        }
+
+        /**
+         * @brief Takes tokens out of the stash, refilling it from the bucket
+         * if there aren't enough of them.
+         */
+        auto try_acquire(std::uint64_t count = 1) noexcept -> result
+        {
+            if (count <= m_tokens)
+            {
+                m_tokens -= count;
+                return result::success();
+            }
+
+            // Take a whole batch if we can, but settle for just what's needed
+            // when the bucket is running low.
+            const auto needed = count - m_tokens;
+            const auto batch = needed > m_batch ? needed : m_batch;
+            auto error = rate_limited_t{};
+            if (m_limiter.try_acquire(batch).is_error(error))
+            {
+                if (batch == needed ||
+                    m_limiter.try_acquire(needed).is_error(error))
+                {
+                    return result::error(error);
+                }
+
+                m_tokens = 0;
+                return result::success();
+            }
+
+            m_tokens += batch - count;
+            return result::success();
+        }
+
+        /**
+         * @brief Returns the number of tokens in the stash.
+         */
+        auto tokens() const noexcept -> std::uint64_t
+        {
+            return m_tokens;
+        }
+
+      private:
+        rate_limiter_t& m_limiter;
+        std::uint64_t m_batch;
+        std::uint64_t m_tokens = 0;
+    };
+
+    /**
+     * @brief Creates a stash of tokens for the calling thread.
+     */
+    auto local(std::uint64_t batch) noexcept -> local_t
+    {
+        return local_t{*this, batch};
+    }
+
+  private:
+    static auto interval_of(double rate) noexcept -> std::uint64_t
+    {
+        if (!(rate > 0.0))
+        {
+            std::cerr << "kirho: rate limiters need a positive rate.\n";
+            std::terminate();
+        }
+
+        const auto interval = 1e9 / rate;
+        return interval < 1.0 ? 1 : static_cast<std::uint64_t>(interval);
+    }
+
+    auto elapsed() const noexcept -> std::uint64_t
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock_t::now() - m_start
+            )
+                .count()
+        );
+    }
+
+    auto retry_after(std::uint64_t ahead, std::uint64_t cost) const noexcept
+        -> rate_limited_t::duration_t
+    {
+        if (cost > m_tolerance)
+        {
+            return rate_limited_t::duration_t::max();
+        }
+
+        return std::chrono::duration_cast<rate_limited_t::duration_t>(
+            std::chrono::nanoseconds{ahead - m_tolerance}
+        );
+    }
+
+  private:
+    std::atomic<std::uint64_t> m_full_at = 0;
+    std::uint64_t m_interval;
+    std::uint64_t m_tolerance;
+    clock_t::time_point m_start;
+};
+} // namespace kirho
@@ -0,0 +1,325 @@
+/**
+ * @file retry.hpp
+ * @brief Trying fallible operations again until they work.
+ *
+ * Contains @ref kirho::retry, which calls a function that returns a
+ * @ref kirho::result_t over and over, with growing pauses in between, until
+ * it succeeds, fails in a way that isn't worth retrying, or runs out of
+ * attempts or time. There's a blocking version that sleeps on the calling
+ * thread, and @ref kirho::async_retry, which suspends a coroutine instead, so
+ * that no thread is held up while waiting.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief How to go about retrying an operation.
+ *
+ * The pauses in between attempts use decorrelated jitter: each one is picked
+ * at random between the base delay and three times the previous one, and
+ * capped at the maximum delay. That grows about as fast as doubling does, but
+ * clients that failed at the same time don't all come back at the same time.
+ *
+ * @tparam E The type of the error that the operation fails with.
+ */
+template <typename E>
+struct retry_policy_t
+{
+    using clock_t = std::chrono::steady_clock;
+    using duration_t = clock_t::duration;
+
+    /**
+     * @brief The most times that the operation is attempted, including the
+     * first time. It's always attempted at least once.
+     */
+    std::size_t max_attempts = 5;
+
+    /**
+     * @brief The shortest pause in between attempts.
+     */
+    duration_t base_delay = std::chrono::milliseconds{10};
+
+    /**
+     * @brief The longest pause in between attempts.
+     */
+    duration_t max_delay = std::chrono::seconds{1};
+
+    /**
+     * @brief When to give up. An attempt isn't started if the pause before it
+     * would go past this.
+     */
+    clock_t::time_point deadline = clock_t::time_point::max();
+
+    /**
+     * @brief Decides whether an error is worth retrying. Every error is by
+     * default.
+     */
+    std::function<bool(const E&)> retryable = [](const E&) { return true; };
+};
+
+namespace detail
+{
+// Keeps track of the attempts so far, and works out how long to pause before
+// the next one, if there should be one at all.
+template <typename E>
+class retry_schedule_t
+{
+  public:
+    using duration_t = typename retry_policy_t<E>::duration_t;
+
+    explicit retry_schedule_t(const retry_policy_t<E>& p_policy) noexcept
+        : m_policy{p_policy}, m_delay{p_policy.base_delay}
+    {
+    }
+
+    auto next_delay(const E& error) -> std::optional<duration_t>
+    {
+        using clock_t = typename retry_policy_t<E>::clock_t;
+
+        m_attempts++;
+        if (m_attempts >= m_policy.max_attempts || !m_policy.retryable(error))
+        {
+            return std::nullopt;
+        }
+
+        // Worked out so that huge delays can't overflow.
+        const auto base = std::max(m_policy.base_delay, duration_t::zero());
+        const auto cap = std::max(m_policy.max_delay, base);
+        const auto upper = m_delay > cap / 3 ? cap : m_delay * 3;
+        if (upper > base)
+        {
+            auto distribution =
+                std::uniform_int_distribution<typename duration_t::rep>{
+                    base.count(), upper.count()
+                };
+            m_delay = duration_t{distribution(generator())};
+        }
+        else
+        {
+            m_delay = base;
+        }
+
+        const auto now = clock_t::now();
+        if (m_policy.deadline <= now || m_delay >= m_policy.deadline - now)
+        {
+            return std::nullopt;
+        }
+
+        return m_delay;
+    }
+
+  private:
+    static auto generator() -> std::minstd_rand&
+    {
+        thread_local auto generator = std::minstd_rand{std::random_device{}()};
+        return generator;
+    }
+
+  private:
+    const retry_policy_t<E>& m_policy;
+    duration_t m_delay;
+    std::size_t m_attempts = 0;
+};
+
+// The coroutine that async_retry runs in the background while the coroutine
+// that awaits it is suspended. It starts right away and frees itself once it
+// finishes, and it never lets exceptions out.
+struct retry_task_t
+{
+    struct promise_type
+    {
+        auto get_return_object() noexcept -> retry_task_t
+        {
+            return {};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto return_void() noexcept -> void
+        {
+        }
+
+        auto unhandled_exception() noexcept -> void
+        {
+            std::terminate();
+        }
+    };
+};
+} // namespace detail
+
+/**
+ * @brief Calls the function until it succeeds, or until the policy says to
+ * give up, sleeping on the calling thread in between.
+ *
+ * @param policy How to go about retrying.
+ * @param f The function, which takes no arguments and returns a result.
+ *
+ * @return The first success, or the last error.
+ */
+template <typename F, typename R = std::invoke_result_t<F&>>
+auto retry(const retry_policy_t<typename R::error_type>& policy, F f) -> R
+{
+    using error_t = typename R::error_type;
+
+    auto schedule = detail::retry_schedule_t<error_t>{policy};
+    for (;;)
+    {
+        auto outcome = f();
+        auto error = error_t{};
+        if (!outcome.is_error(error))
+        {
+            return outcome;
+        }
+
+        const auto delay = schedule.next_delay(error);
+        if (!delay)
+        {
+            return outcome;
+        }
+
+        std::this_thread::sleep_for(*delay);
+    }
+}
+
+/**
+ * @brief What @ref async_retry returns. `co_await` it to get the first
+ * success, or the last error.
+ *
+ * The first attempt is made right away, and the coroutine is only suspended
+ * if that one fails. The awaitable can't be moved, since the pauses refer
+ * back to it, so `co_await` it where it's made.
+ */
+template <typename F, typename S>
+class retry_awaitable_t
+{
+  public:
+    using result_type = std::invoke_result_t<F&>;
+    using error_type = typename result_type::error_type;
+
+    retry_awaitable_t(retry_policy_t<error_type> p_policy, F p_f, S p_sleep)
+        : m_policy{std::move(p_policy)},
+          m_f{std::move(p_f)},
+          m_sleep{std::move(p_sleep)},
+          m_schedule{m_policy}
+    {
+    }
+
+    retry_awaitable_t(const retry_awaitable_t&) = delete;
+    retry_awaitable_t& operator=(const retry_awaitable_t&) = delete;
+
+    auto await_ready() -> bool
+    {
+        return attempt();
+    }
+
+    auto await_suspend(std::coroutine_handle<> p_handle) -> void
+    {
+        // This might resume the coroutine before it even returns, if the
+        // pauses don't suspend, which is fine as long as nothing here is
+        // touched afterwards.
+        run(this, p_handle);
+    }
+
+    auto await_resume() -> result_type
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+
+        return std::move(*m_outcome);
+    }
+
+  private:
+    // Makes an attempt, and returns true if there won't be another one.
+    auto attempt() -> bool
+    {
+        m_outcome.emplace(m_f());
+
+        auto error = error_type{};
+        if (!m_outcome->is_error(error))
+        {
+            return true;
+        }
+
+        m_delay = m_schedule.next_delay(error);
+        return !m_delay.has_value();
+    }
+
+    static auto run(retry_awaitable_t* self, std::coroutine_handle<> handle)
+        -> detail::retry_task_t
+    {
+        try
+        {
+            do
+            {
+                co_await self->m_sleep(*self->m_delay);
+            } while (!self->attempt());
+        }
+        catch (...)
+        {
+            self->m_exception = std::current_exception();
+        }
+
+        handle.resume();
+    }
+
+  private:
+    retry_policy_t<error_type> m_policy;
+    F m_f;
+    S m_sleep;
+    detail::retry_schedule_t<error_type> m_schedule;
+    std::optional<result_type> m_outcome;
+    std::optional<typename retry_policy_t<error_type>::duration_t> m_delay;
+    std::exception_ptr m_exception;
+};
+
+/**
+ * @brief Calls the function until it succeeds, or until the policy says to
+ * give up, suspending the coroutine that awaits it in between.
+ *
+ * The pauses are up to the `sleep` function, which takes a
+ * `std::chrono::steady_clock::duration` and returns something that can be
+ * awaited, so this works with whatever runs the coroutine. With an
+ * @ref event_loop_t, that's
+ *
+ *     co_await kirho::async_retry(policy, f, [&loop](auto delay) {
+ *         return loop.sleep_for(delay);
+ *     });
+ *
+ * @param policy How to go about retrying.
+ * @param f The function, which takes no arguments and returns a result.
+ * @param sleep The function that pauses the coroutine.
+ *
+ * @return The awaitable, which gives the first success, or the last error.
+ */
+template <typename F, typename S, typename R = std::invoke_result_t<F&>>
+auto async_retry(retry_policy_t<typename R::error_type> policy, F f, S sleep)
+    -> retry_awaitable_t<F, S>
+{
+    return {std::move(policy), std::move(f), std::move(sleep)};
+}
+} // namespace kirho
@@ -0,0 +1,347 @@
+/**
+ * @file small_vector.hpp
+ * @brief A vector that keeps its first few elements inside of itself.
+ *
+ * Contains @ref kirho::small_vector_t, for lists that are usually short, and
+ * that are made often enough that allocating for every one of them would
+ * show, such as the errors of a request that's mostly valid.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace kirho
+{
+/**
+ * @brief A vector that holds up to `N` elements without allocating, and only
+ * moves them to the heap once there are more of them.
+ *
+ * Apart from that, it works like a `std::vector`, as far as it goes, which is
+ * adding elements at the end, going over them, and clearing them. The
+ * elements are next to each other in memory either way, so it can be turned
+ * into a `std::span`.
+ *
+ * Since the elements live inside of the vector until it spills over, moving a
+ * vector that hasn't moves the elements one by one, rather than just handing
+ * over a pointer.
+ *
+ * @tparam T The type of the elements, which has to be movable without
+ * throwing.
+ * @tparam N The number of elements that fit inside of the vector.
+ */
+template <typename T, std::size_t N>
+class small_vector_t
+{
+    static_assert(N > 0, "a small vector has to hold at least one element");
+    static_assert(
+        std::is_nothrow_move_constructible_v<T>,
+        "the elements of a small vector are moved around when it grows"
+    );
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    small_vector_t() noexcept = default;
+
+    small_vector_t(std::initializer_list<T> p_values)
+    {
+        reserve(p_values.size());
+        for (const auto& value : p_values)
+        {
+            push_back(value);
+        }
+    }
+
+    small_vector_t(const small_vector_t& other)
+    {
+        reserve(other.m_size);
+        std::uninitialized_copy(other.begin(), other.end(), m_data);
+        m_size = other.m_size;
+    }
+
+    small_vector_t(small_vector_t&& other) noexcept
+    {
+        take(std::move(other));
+    }
+
+    small_vector_t& operator=(const small_vector_t& other)
+    {
+        if (this != &other)
+        {
+            auto copy = other;
+            *this = std::move(copy);
+        }
+
+        return *this;
+    }
+
+    small_vector_t& operator=(small_vector_t&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            take(std::move(other));
+        }
+
+        return *this;
+    }
+
+    ~small_vector_t()
+    {
+        release();
+    }
+
+    /**
+     * @brief Adds a copy of the value at the end.
+     */
+    auto push_back(const T& value) -> void
+    {
+        emplace_back(value);
+    }
+
+    /**
+     * @brief Moves the value to the end.
+     */
+    auto push_back(T&& value) -> void
+    {
+        emplace_back(std::move(value));
+    }
+
+    /**
+     * @brief Creates an element at the end, out of the arguments.
+     *
+     * @return The new element.
+     */
+    template <typename... Args>
+    auto emplace_back(Args&&... args) -> T&
+    {
+        if (m_size == m_capacity) [[unlikely]]
+        {
+            return grow_and_emplace(std::forward<Args>(args)...);
+        }
+
+        auto* element =
+            ::new (static_cast<void*>(m_data + m_size))
+                T(std::forward<Args>(args)...);
+        m_size++;
+        return *element;
+    }
+
+    /**
+     * @brief Removes the last element.
+     */
+    auto pop_back() noexcept -> void
+    {
+        m_size--;
+        std::destroy_at(m_data + m_size);
+    }
+
+    /**
+     * @brief Removes all of the elements, but keeps the memory.
+     */
+    auto clear() noexcept -> void
+    {
+        std::destroy(m_data, m_data + m_size);
+        m_size = 0;
+    }
+
+    /**
+     * @brief Makes room for at least `capacity` elements.
+     */
+    auto reserve(std::size_t capacity) -> void
+    {
+        if (capacity > m_capacity)
+        {
+            reallocate(capacity);
+        }
+    }
+
+    auto size() const noexcept -> std::size_t
+    {
+        return m_size;
+    }
+
+    auto capacity() const noexcept -> std::size_t
+    {
+        return m_capacity;
+    }
+
+    auto empty() const noexcept -> bool
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * @brief Checks if the elements are still inside of the vector, rather
+     * than on the heap.
+     */
+    auto is_inline() const noexcept -> bool
+    {
+        return m_data == inline_data();
+    }
+
+    auto operator[](std::size_t index) noexcept -> T&
+    {
+        return m_data[index];
+    }
+
+    auto operator[](std::size_t index) const noexcept -> const T&
+    {
+        return m_data[index];
+    }
+
+    auto front() noexcept -> T&
+    {
+        return m_data[0];
+    }
+
+    auto front() const noexcept -> const T&
+    {
+        return m_data[0];
+    }
+
+    auto back() noexcept -> T&
+    {
+        return m_data[m_size - 1];
+    }
+
+    auto back() const noexcept -> const T&
+    {
+        return m_data[m_size - 1];
+    }
+
+    auto data() noexcept -> T*
+    {
+        return m_data;
+    }
+
+    auto data() const noexcept -> const T*
+    {
+        return m_data;
+    }
+
+    auto begin() noexcept -> iterator
+    {
+        return m_data;
+    }
+
+    auto begin() const noexcept -> const_iterator
+    {
+        return m_data;
+    }
+
+    auto end() noexcept -> iterator
+    {
+        return m_data + m_size;
+    }
+
+    auto end() const noexcept -> const_iterator
+    {
+        return m_data + m_size;
+    }
+
+    friend auto operator==(const small_vector_t& a, const small_vector_t& b)
+        -> bool
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+  private:
+    auto inline_data() noexcept -> T*
+    {
+        return std::launder(reinterpret_cast<T*>(m_inline));
+    }
+
+    auto inline_data() const noexcept -> const T*
+    {
+        return std::launder(reinterpret_cast<const T*>(m_inline));
+    }
+
+    // The new element is made before the old ones are moved over, since the
+    // arguments might refer to one of them.
+    template <typename... Args>
+    auto grow_and_emplace(Args&&... args) -> T&
+    {
+        const auto capacity = m_capacity * 2;
+        auto* data = std::allocator<T>{}.allocate(capacity);
+        T* element = nullptr;
+        try
+        {
+            element = ::new (static_cast<void*>(data + m_size))
+                T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            std::allocator<T>{}.deallocate(data, capacity);
+            throw;
+        }
+
+        adopt(data, capacity);
+        m_size++;
+        return *element;
+    }
+
+    auto reallocate(std::size_t capacity) -> void
+    {
+        adopt(std::allocator<T>{}.allocate(capacity), capacity);
+    }
+
+    // Moves the elements over to the new memory, and frees the old one.
+    auto adopt(T* data, std::size_t capacity) noexcept -> void
+    {
+        std::uninitialized_move(m_data, m_data + m_size, data);
+        std::destroy(m_data, m_data + m_size);
+        if (!is_inline())
+        {
+            std::allocator<T>{}.deallocate(m_data, m_capacity);
+        }
+
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    auto take(small_vector_t&& other) noexcept -> void
+    {
+        if (!other.is_inline())
+        {
+            m_data = std::exchange(other.m_data, other.inline_data());
+            m_capacity = std::exchange(other.m_capacity, N);
+            m_size = std::exchange(other.m_size, 0);
+            return;
+        }
+
+        m_data = inline_data();
+        m_capacity = N;
+        std::uninitialized_move(other.begin(), other.end(), m_data);
+        m_size = other.m_size;
+        other.clear();
+    }
+
+    auto release() noexcept -> void
+    {
+        clear();
+        if (!is_inline())
+        {
+            std::allocator<T>{}.deallocate(m_data, m_capacity);
+        }
+
+        m_data = inline_data();
+        m_capacity = N;
+    }
+
+  private:
+    alignas(T) std::byte m_inline[sizeof(T) * N];
+    T* m_data = inline_data();
+    std::size_t m_size = 0;
+    std::size_t m_capacity = N;
+};
+} // namespace kirho
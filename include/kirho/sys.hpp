@@ -0,0 +1,418 @@
+/**
+ * @file sys.hpp
+ * @brief Operating system errors and system call wrappers.
+ *
+ * This file contains the error type that all of the kirho features which talk
+ * to the operating system use, along with some thin wrappers around the system
+ * calls that are used the most. It is POSIX only for the time being, since that
+ * is the only place where I need these things.
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief An error that was reported by the operating system.
+ *
+ * This is nothing more than a wrapper around an `errno` value, so that it can
+ * be passed around inside of a @ref result_t instead of being fished out of a
+ * global variable right after the call that failed.
+ */
+struct sys_error_t
+{
+    /**
+     * @brief The `errno` value that was reported.
+     */
+    int code = 0;
+
+    /**
+     * @brief Creates an error out of the current value of `errno`.
+     *
+     * Make sure to call this right after the call that failed, as pretty much
+     * anything else can overwrite `errno`.
+     */
+    static auto from_errno() noexcept -> sys_error_t
+    {
+        return sys_error_t{errno};
+    }
+
+    /**
+     * @brief Returns a human readable description of the error.
+     */
+    auto message() const noexcept -> const char*
+    {
+        return std::strerror(code);
+    }
+
+    auto operator==(const sys_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const sys_error_t& error)
+    -> std::ostream&
+{
+    return stream << error.message() << " (errno " << error.code << ')';
+}
+
+/**
+ * @brief Thin wrappers around POSIX system calls.
+ *
+ * None of these allocate or throw. They report failures through a
+ * @ref result_t, and calls that get interrupted by a signal are simply retried,
+ * so you never have to deal with `EINTR` yourself.
+ */
+namespace sys
+{
+/**
+ * @brief An owned file descriptor.
+ *
+ * Closes the descriptor in the destructor, the same way a @ref defer_t would
+ * at the end of the scope. It can be moved, but not copied, since only one
+ * object can own the descriptor. If you care about the error from `close`, use
+ * @ref sys::close instead of letting the destructor do it.
+ */
+class fd_t
+{
+  public:
+    fd_t() noexcept = default;
+
+    /**
+     * @brief Takes ownership of an existing file descriptor.
+     */
+    explicit fd_t(int p_fd) noexcept : m_fd{p_fd}
+    {
+    }
+
+    fd_t(const fd_t&) = delete;
+    fd_t& operator=(const fd_t&) = delete;
+
+    fd_t(fd_t&& other) noexcept : m_fd{other.release()}
+    {
+    }
+
+    fd_t& operator=(fd_t&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset(other.release());
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Closes the file descriptor, if there is one.
+     */
+    ~fd_t() noexcept
+    {
+        reset();
+    }
+
+    /**
+     * @brief Returns the raw file descriptor, without giving up ownership.
+     */
+    auto get() const noexcept -> int
+    {
+        return m_fd;
+    }
+
+    /**
+     * @brief Checks if there is a file descriptor owned by this object.
+     */
+    auto is_open() const noexcept -> bool
+    {
+        return m_fd >= 0;
+    }
+
+    /**
+     * @brief Gives up ownership of the file descriptor and returns it.
+     */
+    auto release() noexcept -> int
+    {
+        return std::exchange(m_fd, -1);
+    }
+
+    /**
+     * @brief Closes the current file descriptor and takes ownership of a new
+     * one.
+     */
+    auto reset(int p_fd = -1) noexcept -> void
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+
+        m_fd = p_fd;
+    }
+
+  private:
+    int m_fd = -1;
+};
+
+/**
+ * @brief Keeps calling the specified function for as long as it fails with
+ * `EINTR`.
+ *
+ * The function is expected to behave like a system call, which means it
+ * returns a negative value and sets `errno` when it fails.
+ *
+ * @return The result of the last call.
+ */
+template <typename F>
+auto retry_on_eintr(F call) noexcept
+{
+    auto result = call();
+    while (result < 0 && errno == EINTR)
+    {
+        result = call();
+    }
+
+    return result;
+}
+
+/**
+ * @brief Puts the file descriptor into non-blocking mode.
+ */
+inline auto set_nonblocking(const fd_t& fd) noexcept
+    -> result_t<empty_t, sys_error_t>
+{
+    using result = result_t<empty_t, sys_error_t>;
+
+    const auto flags = ::fcntl(fd.get(), F_GETFL);
+    if (flags < 0 || ::fcntl(fd.get(), F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success();
+}
+
+/**
+ * @brief Opens the file at the specified path.
+ *
+ * `O_CLOEXEC` is always added to the flags, as leaking descriptors into child
+ * processes is almost never what you want.
+ *
+ * @param path The path to the file.
+ * @param flags The flags to pass to `open`, such as `O_RDONLY`.
+ * @param mode The permissions for the file, if it gets created.
+ *
+ * @return The opened file descriptor.
+ */
+inline auto open(const char* path, int flags, mode_t mode = 0644) noexcept
+    -> result_t<fd_t, sys_error_t>
+{
+    using result = result_t<fd_t, sys_error_t>;
+
+    const auto fd = retry_on_eintr([&]() noexcept {
+        return ::open(path, flags | O_CLOEXEC, mode);
+    });
+    if (fd < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success(fd_t{fd});
+}
+
+/**
+ * @brief Reads as much as it can into the buffer, up to its size.
+ *
+ * Like `read`, this may return less than the size of the buffer, and returns
+ * zero at the end of the file.
+ *
+ * @return The number of bytes that were read.
+ */
+inline auto read(const fd_t& fd, std::span<std::byte> buffer) noexcept
+    -> result_t<std::size_t, sys_error_t>
+{
+    using result = result_t<std::size_t, sys_error_t>;
+
+    const auto count = retry_on_eintr([&]() noexcept {
+        return ::read(fd.get(), buffer.data(), buffer.size());
+    });
+    if (count < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success(static_cast<std::size_t>(count));
+}
+
+/**
+ * @brief Writes as much of the buffer as it can.
+ *
+ * Like `write`, this may write less than the whole buffer.
+ *
+ * @return The number of bytes that were written.
+ */
+inline auto write(const fd_t& fd, std::span<const std::byte> buffer) noexcept
+    -> result_t<std::size_t, sys_error_t>
+{
+    using result = result_t<std::size_t, sys_error_t>;
+
+    const auto count = retry_on_eintr([&]() noexcept {
+        return ::write(fd.get(), buffer.data(), buffer.size());
+    });
+    if (count < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success(static_cast<std::size_t>(count));
+}
+
+/**
+ * @brief Reads into the buffer from the specified offset in the file, without
+ * moving the file position.
+ *
+ * @return The number of bytes that were read.
+ */
+inline auto pread(
+    const fd_t& fd,
+    std::span<std::byte> buffer,
+    off_t offset
+) noexcept -> result_t<std::size_t, sys_error_t>
+{
+    using result = result_t<std::size_t, sys_error_t>;
+
+    const auto count = retry_on_eintr([&]() noexcept {
+        return ::pread(fd.get(), buffer.data(), buffer.size(), offset);
+    });
+    if (count < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success(static_cast<std::size_t>(count));
+}
+
+/**
+ * @brief Writes the buffer at the specified offset in the file, without moving
+ * the file position.
+ *
+ * @return The number of bytes that were written.
+ */
+inline auto pwrite(
+    const fd_t& fd,
+    std::span<const std::byte> buffer,
+    off_t offset
+) noexcept -> result_t<std::size_t, sys_error_t>
+{
+    using result = result_t<std::size_t, sys_error_t>;
+
+    const auto count = retry_on_eintr([&]() noexcept {
+        return ::pwrite(fd.get(), buffer.data(), buffer.size(), offset);
+    });
+    if (count < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success(static_cast<std::size_t>(count));
+}
+
+/**
+ * @brief Reads into several buffers at once.
+ *
+ * The buffers are filled in order, and like `readv`, this may return less than
+ * their combined size.
+ *
+ * @return The number of bytes that were read.
+ */
+inline auto readv(const fd_t& fd, std::span<const iovec> buffers) noexcept
+    -> result_t<std::size_t, sys_error_t>
+{
+    using result = result_t<std::size_t, sys_error_t>;
+
+    const auto count = retry_on_eintr([&]() noexcept {
+        return ::readv(
+            fd.get(), buffers.data(), static_cast<int>(buffers.size())
+        );
+    });
+    if (count < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success(static_cast<std::size_t>(count));
+}
+
+/**
+ * @brief Writes several buffers at once.
+ *
+ * Like `writev`, this may write less than all of them.
+ *
+ * @return The number of bytes that were written.
+ */
+inline auto writev(const fd_t& fd, std::span<const iovec> buffers) noexcept
+    -> result_t<std::size_t, sys_error_t>
+{
+    using result = result_t<std::size_t, sys_error_t>;
+
+    const auto count = retry_on_eintr([&]() noexcept {
+        return ::writev(
+            fd.get(), buffers.data(), static_cast<int>(buffers.size())
+        );
+    });
+    if (count < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success(static_cast<std::size_t>(count));
+}
+
+/**
+ * @brief Flushes the file to the disk.
+ */
+inline auto fsync(const fd_t& fd) noexcept -> result_t<empty_t, sys_error_t>
+{
+    using result = result_t<empty_t, sys_error_t>;
+
+    if (retry_on_eintr([&]() noexcept { return ::fsync(fd.get()); }) < 0)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success();
+}
+
+/**
+ * @brief Closes the file descriptor and reports the error, if there was one.
+ *
+ * Unlike the other calls, this one is not retried on `EINTR`, because on Linux
+ * the descriptor is gone by then regardless, and closing it again could close
+ * a descriptor that another thread has just opened. Either way, the object no
+ * longer owns a descriptor afterwards.
+ */
+inline auto close(fd_t& fd) noexcept -> result_t<empty_t, sys_error_t>
+{
+    using result = result_t<empty_t, sys_error_t>;
+
+    if (::close(fd.release()) < 0 && errno != EINTR)
+    {
+        return result::error(sys_error_t::from_errno());
+    }
+
+    return result::success();
+}
+} // namespace sys
+} // namespace kirho
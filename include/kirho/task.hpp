@@ -0,0 +1,558 @@
+/**
+ * @file task.hpp
+ * @brief Coroutines that can be awaited, and whose outcome is a result.
+ *
+ * Contains @ref kirho::task_t, a coroutine that reports how it went through a
+ * @ref kirho::result_t instead of an exception, along with
+ * @ref kirho::schedule, which moves a coroutine over to a
+ * @ref kirho::thread_pool_t, @ref kirho::when_all and @ref kirho::when_any,
+ * which run several tasks on a pool at once, and @ref kirho::sync_wait, which
+ * blocks until a task is done.
+ */
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "kirho.hpp"
+#include "thread_pool.hpp"
+
+namespace kirho
+{
+/**
+ * @brief A coroutine that doesn't start until it's awaited, and that gives
+ * the coroutine awaiting it a result once it's done.
+ *
+ * The task is started by `co_await`ing it, which suspends the awaiting
+ * coroutine and jumps straight into the task, and once the task is done, it
+ * jumps straight back, so awaiting a task that never suspends doesn't go
+ * through anything but the two jumps, and chains of tasks don't grow the
+ * stack, as long as the compiler makes the jumps into tail calls, which GCC
+ * only does with optimizations on. The task runs on whichever thread resumes
+ * it, which is the awaiting one until it awaits something that moves it
+ * somewhere else, such as @ref schedule.
+ *
+ * Errors are meant to be returned, with `co_return result::error(...)`.
+ * Exceptions still work, and come out of the `co_await`, but they are for
+ * things that went wrong in the program, not for errors.
+ *
+ * @tparam T The type of the value.
+ * @tparam E The type of the error.
+ */
+template <typename T, typename E>
+class [[nodiscard]] task_t
+{
+  public:
+    using result_type = result_t<T, E>;
+
+    struct promise_type
+    {
+        // Jumps back to whoever awaited the task, if anyone did.
+        struct final_awaiter_t
+        {
+            auto await_ready() noexcept -> bool
+            {
+                return false;
+            }
+
+            auto await_suspend(std::coroutine_handle<promise_type> p_handle)
+                noexcept -> std::coroutine_handle<>
+            {
+                const auto continuation = p_handle.promise().m_continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            auto await_resume() noexcept -> void
+            {
+            }
+        };
+
+        auto get_return_object() noexcept -> task_t
+        {
+            return task_t{handle_t::from_promise(*this)};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_always
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> final_awaiter_t
+        {
+            return {};
+        }
+
+        auto return_value(result_type result) noexcept -> void
+        {
+            m_result.emplace(std::move(result));
+        }
+
+        auto unhandled_exception() noexcept -> void
+        {
+            m_exception = std::current_exception();
+        }
+
+        std::coroutine_handle<> m_continuation;
+        std::optional<result_type> m_result;
+        std::exception_ptr m_exception;
+    };
+
+    using handle_t = std::coroutine_handle<promise_type>;
+
+    /**
+     * @brief What `co_await`ing a task goes through.
+     */
+    class awaiter_t
+    {
+      public:
+        auto await_ready() const noexcept -> bool
+        {
+            return false;
+        }
+
+        auto await_suspend(std::coroutine_handle<> p_continuation) noexcept
+            -> std::coroutine_handle<>
+        {
+            m_handle.promise().m_continuation = p_continuation;
+            return m_handle;
+        }
+
+        auto await_resume() -> result_type
+        {
+            auto& promise = m_handle.promise();
+            if (promise.m_exception)
+            {
+                std::rethrow_exception(promise.m_exception);
+            }
+
+            return std::move(*promise.m_result);
+        }
+
+      private:
+        friend class task_t;
+
+        explicit awaiter_t(handle_t p_handle) noexcept : m_handle{p_handle}
+        {
+        }
+
+      private:
+        handle_t m_handle;
+    };
+
+    task_t(task_t&& other) noexcept
+        : m_handle{std::exchange(other.m_handle, nullptr)}
+    {
+    }
+
+    task_t& operator=(task_t&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    task_t(const task_t&) = delete;
+    task_t& operator=(const task_t&) = delete;
+
+    /**
+     * @brief Frees the coroutine frame. Tasks must not be destroyed while
+     * they are running.
+     */
+    ~task_t()
+    {
+        destroy();
+    }
+
+    /**
+     * @brief Starts the task, and suspends the awaiting coroutine until it's
+     * done. A task can only be awaited once.
+     */
+    auto operator co_await() noexcept -> awaiter_t
+    {
+        return awaiter_t{m_handle};
+    }
+
+  private:
+    explicit task_t(handle_t p_handle) noexcept : m_handle{p_handle}
+    {
+    }
+
+    auto destroy() noexcept -> void
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+  private:
+    handle_t m_handle;
+};
+
+namespace detail
+{
+// Runs a task from outside of any coroutine. It starts right away, frees
+// itself once it finishes, and never lets exceptions out.
+struct task_driver_t
+{
+    struct promise_type
+    {
+        auto get_return_object() noexcept -> task_driver_t
+        {
+            return {};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto return_void() noexcept -> void
+        {
+        }
+
+        auto unhandled_exception() noexcept -> void
+        {
+            std::terminate();
+        }
+    };
+};
+} // namespace detail
+
+/**
+ * @brief What @ref schedule returns. `co_await` it to carry on on the pool.
+ */
+class schedule_awaitable_t
+{
+  public:
+    explicit schedule_awaitable_t(thread_pool_t& p_pool) noexcept
+        : m_pool{p_pool}
+    {
+    }
+
+    auto await_ready() const noexcept -> bool
+    {
+        return false;
+    }
+
+    auto await_suspend(std::coroutine_handle<> p_handle) -> void
+    {
+        m_pool.post([p_handle]() { p_handle.resume(); });
+    }
+
+    auto await_resume() const noexcept -> void
+    {
+    }
+
+  private:
+    thread_pool_t& m_pool;
+};
+
+/**
+ * @brief Moves the awaiting coroutine over to one of the threads of the pool.
+ *
+ *     co_await kirho::schedule(pool);
+ *     // Now on one of the pool's threads.
+ */
+inline auto schedule(thread_pool_t& pool) noexcept -> schedule_awaitable_t
+{
+    return schedule_awaitable_t{pool};
+}
+
+/**
+ * @brief Runs the task on the calling thread, and blocks until it's done.
+ *
+ * The task only runs on the calling thread until it first moves somewhere
+ * else, after which the calling thread just waits.
+ *
+ * @return The result of the task.
+ */
+template <typename T, typename E>
+auto sync_wait(task_t<T, E> task) -> result_t<T, E>
+{
+    auto promise = std::promise<result_t<T, E>>{};
+    auto future = promise.get_future();
+
+    [](task_t<T, E> task,
+       std::promise<result_t<T, E>> promise) -> detail::task_driver_t {
+        try
+        {
+            promise.set_value(co_await task);
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    }(std::move(task), std::move(promise));
+
+    return future.get();
+}
+
+namespace detail
+{
+// What the tasks of when_all and when_any share. The first task to finish
+// the whole thing, which is the first error for either of them, the first
+// success for when_any, and the last success for when_all, resumes the
+// coroutine that's waiting. The tasks that are still running after that
+// keep this alive, and their results are dropped.
+template <typename T, typename E>
+class race_t
+{
+  public:
+    race_t(std::size_t p_count, bool p_any)
+        : m_values(p_count), m_remaining{p_count}, m_any{p_any}
+    {
+    }
+
+    // Starts all of the tasks on the pool. Once the first of them is
+    // started, the waiting coroutine can be resumed at any moment, which is
+    // why everything that's needed here is passed in, rather than kept in
+    // the awaitable.
+    static auto start(
+        std::shared_ptr<race_t> race,
+        thread_pool_t& pool,
+        std::vector<task_t<T, E>> tasks,
+        std::coroutine_handle<> waiting
+    ) -> void
+    {
+        race->m_waiting = waiting;
+        for (auto i = std::size_t{0}; i < tasks.size(); i++)
+        {
+            run(race, pool, i, std::move(tasks[i]));
+        }
+    }
+
+    // Hands out the error, or rethrows the exception, that finished the
+    // race, if that's how it was finished.
+    auto is_error(E& error) const -> bool
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+
+        if (!m_error)
+        {
+            return false;
+        }
+
+        error = *m_error;
+        return true;
+    }
+
+    // Only for when_all, once every task is done.
+    auto take_all() -> std::vector<T>
+    {
+        auto values = std::vector<T>{};
+        values.reserve(m_values.size());
+        for (auto& value : m_values)
+        {
+            values.push_back(std::move(*value));
+        }
+
+        return values;
+    }
+
+    // Only for when_any. The tasks that lost might still be filling in their
+    // own slots, so only the winner's is touched.
+    auto take_winner() -> std::pair<std::size_t, T>
+    {
+        return {m_index, std::move(*m_values[m_index])};
+    }
+
+  private:
+    static auto run(
+        std::shared_ptr<race_t> race,
+        thread_pool_t& pool,
+        std::size_t index,
+        task_t<T, E> task
+    ) -> task_driver_t
+    {
+        co_await schedule(pool);
+        if (race->m_finished.load(std::memory_order_relaxed))
+        {
+            // Somebody else already finished it, so don't bother.
+            co_return;
+        }
+
+        try
+        {
+            auto outcome = co_await task;
+            race->finish(index, std::move(outcome));
+        }
+        catch (...)
+        {
+            race->fail(std::current_exception());
+        }
+    }
+
+    auto finish(std::size_t index, result_t<T, E> outcome) -> void
+    {
+        auto error = E{};
+        if (outcome.is_error(error))
+        {
+            if (!m_finished.exchange(true, std::memory_order_acq_rel))
+            {
+                m_error.emplace(std::move(error));
+                m_waiting.resume();
+            }
+            return;
+        }
+
+        // Every task has its own slot, so they don't get in each other's
+        // way, and the last one sees all of them through the counter.
+        m_values[index].emplace(std::move(outcome).unwrap());
+        const auto last =
+            m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        if ((m_any || last) &&
+            !m_finished.exchange(true, std::memory_order_acq_rel))
+        {
+            m_index = index;
+            m_waiting.resume();
+        }
+    }
+
+    auto fail(std::exception_ptr exception) -> void
+    {
+        if (!m_finished.exchange(true, std::memory_order_acq_rel))
+        {
+            m_exception = std::move(exception);
+            m_waiting.resume();
+        }
+    }
+
+  private:
+    std::vector<std::optional<T>> m_values;
+    std::atomic<std::size_t> m_remaining;
+    std::atomic<bool> m_finished = false;
+    bool m_any;
+    std::coroutine_handle<> m_waiting;
+    std::size_t m_index = 0;
+    std::optional<E> m_error;
+    std::exception_ptr m_exception;
+};
+
+// Suspends the coroutine of when_all or when_any until the race is over.
+template <typename T, typename E>
+class race_awaitable_t
+{
+  public:
+    race_awaitable_t(
+        std::shared_ptr<race_t<T, E>> p_race,
+        thread_pool_t& p_pool,
+        std::vector<task_t<T, E>> p_tasks
+    )
+        : m_race{std::move(p_race)},
+          m_pool{p_pool},
+          m_tasks{std::move(p_tasks)}
+    {
+    }
+
+    auto await_ready() const noexcept -> bool
+    {
+        return false;
+    }
+
+    auto await_suspend(std::coroutine_handle<> p_handle) -> void
+    {
+        race_t<T, E>::start(m_race, m_pool, std::move(m_tasks), p_handle);
+    }
+
+    auto await_resume() const noexcept -> void
+    {
+    }
+
+  private:
+    std::shared_ptr<race_t<T, E>> m_race;
+    thread_pool_t& m_pool;
+    std::vector<task_t<T, E>> m_tasks;
+};
+} // namespace detail
+
+/**
+ * @brief Runs all of the tasks on the pool at once, and waits for all of them
+ * to succeed, or for one of them to fail.
+ *
+ * As soon as one of them fails, the awaiting coroutine gets its error, without
+ * waiting for the rest. Those that haven't been started yet aren't, but those
+ * that are already running carry on in the background, and their results are
+ * dropped, so they must not refer to anything that the awaiting coroutine
+ * might destroy in the meantime.
+ *
+ * @return The values of all of the tasks, in the same order as the tasks, or
+ * the first error.
+ */
+template <typename T, typename E>
+auto when_all(thread_pool_t& pool, std::vector<task_t<T, E>> tasks)
+    -> task_t<std::vector<T>, E>
+{
+    using result = result_t<std::vector<T>, E>;
+
+    if (tasks.empty())
+    {
+        co_return result::success();
+    }
+
+    auto race = std::make_shared<detail::race_t<T, E>>(tasks.size(), false);
+    co_await detail::race_awaitable_t<T, E>{race, pool, std::move(tasks)};
+
+    auto error = E{};
+    if (race->is_error(error))
+    {
+        co_return result::error(std::move(error));
+    }
+
+    co_return result::success(race->take_all());
+}
+
+/**
+ * @brief Runs all of the tasks on the pool at once, and waits for the first
+ * one of them to finish, whether it succeeds or fails.
+ *
+ * The tasks that are still running afterwards carry on in the background,
+ * just like with @ref when_all.
+ *
+ * @return The index of the task that finished first, along with its value,
+ * or its error.
+ */
+template <typename T, typename E>
+auto when_any(thread_pool_t& pool, std::vector<task_t<T, E>> tasks)
+    -> task_t<std::pair<std::size_t, T>, E>
+{
+    using result = result_t<std::pair<std::size_t, T>, E>;
+
+    if (tasks.empty())
+    {
+        std::cerr << "kirho: when_any needs at least one task.\n";
+        std::terminate();
+    }
+
+    auto race = std::make_shared<detail::race_t<T, E>>(tasks.size(), true);
+    co_await detail::race_awaitable_t<T, E>{race, pool, std::move(tasks)};
+
+    auto error = E{};
+    if (race->is_error(error))
+    {
+        co_return result::error(std::move(error));
+    }
+
+    co_return result::success(race->take_winner());
+}
+} // namespace kirho
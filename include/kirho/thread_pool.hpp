@@ -0,0 +1,213 @@
+/**
+ * @file thread_pool.hpp
+ * @brief A fixed size pool of worker threads.
+ *
+ * Contains @ref kirho::thread_pool_t, which is where the features of kirho that
+ * need to run things in the background run them.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "cancel.hpp"
+#include "kirho.hpp"
+
+namespace kirho
+{
+namespace detail
+{
+// What a cancellable job returns, which can't be void, since it goes into a
+// result_t.
+template <typename F>
+using cancellable_return_t = std::conditional_t<
+    std::is_void_v<std::invoke_result_t<F&>>,
+    empty_t,
+    std::invoke_result_t<F&>>;
+} // namespace detail
+
+/**
+ * @brief A pool of threads that runs the jobs that are submitted to it.
+ *
+ * Jobs are run in the order in which they were submitted, by whichever thread
+ * gets to them first. The destructor finishes all of the jobs that are still
+ * queued up before it joins the threads, so nothing that was submitted is ever
+ * dropped.
+ */
+class thread_pool_t
+{
+  public:
+    /**
+     * @brief Starts the specified number of threads.
+     *
+     * @param thread_count The number of threads. Zero means one thread for
+     * every core.
+     */
+    explicit thread_pool_t(std::size_t thread_count = 0)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::thread::hardware_concurrency();
+        }
+        if (thread_count == 0)
+        {
+            thread_count = 1;
+        }
+
+        m_threads.reserve(thread_count);
+        for (auto i = std::size_t{0}; i < thread_count; i++)
+        {
+            m_threads.emplace_back([this]() { work(); });
+        }
+    }
+
+    thread_pool_t(const thread_pool_t&) = delete;
+    thread_pool_t& operator=(const thread_pool_t&) = delete;
+
+    /**
+     * @brief Finishes the remaining jobs and joins the threads.
+     */
+    ~thread_pool_t()
+    {
+        {
+            const auto lock = std::lock_guard{m_mutex};
+            m_stopping = true;
+        }
+        m_condition.notify_all();
+
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Queues up the function to be run on one of the threads.
+     *
+     * @param f The function to run. It has to take no arguments.
+     *
+     * @return A future that gets the return value of the function.
+     */
+    template <typename F>
+    auto submit(F f) -> std::future<std::invoke_result_t<F>>
+    {
+        // std::function needs to be able to copy what it holds, which is why
+        // the task has to be shared.
+        using return_t = std::invoke_result_t<F>;
+        auto task =
+            std::make_shared<std::packaged_task<return_t()>>(std::move(f));
+        auto future = task->get_future();
+        post([task]() { (*task)(); });
+
+        return future;
+    }
+
+    /**
+     * @brief Queues up the function to be run on one of the threads, unless
+     * it's cancelled or its deadline passes before a thread gets to it.
+     *
+     * This is for shedding work that nobody is waiting for anymore, such as
+     * requests that have already timed out while the pool was busy. Once the
+     * function has started, it's up to the function to check the token and
+     * the deadline.
+     *
+     * @param token The token that cancels the function.
+     * @param deadline The deadline for starting the function.
+     * @param f The function to run. It has to take no arguments.
+     *
+     * @return A future that gets the return value of the function, or
+     * @ref empty_t if it doesn't return anything, or the reason why it
+     * didn't run.
+     */
+    template <typename F>
+    auto submit(stop_token_t token, deadline_t deadline, F f)
+        -> std::future<
+            result_t<detail::cancellable_return_t<F>, cancel_error_t>>
+    {
+        using result =
+            result_t<detail::cancellable_return_t<F>, cancel_error_t>;
+
+        auto job = [token = std::move(token), deadline, f = std::move(f)](
+                   ) mutable -> result {
+            auto error = cancel_error_t{};
+            if (check_cancelled(token, deadline).is_error(error))
+            {
+                return result::error(error);
+            }
+
+            if constexpr (std::is_void_v<std::invoke_result_t<F&>>)
+            {
+                f();
+                return result::success();
+            }
+            else
+            {
+                return result::success(f());
+            }
+        };
+
+        return submit(std::move(job));
+    }
+
+    /**
+     * @brief Queues up the function to be run on one of the threads, without
+     * a way to find out when it's done.
+     */
+    auto post(std::function<void()> job) -> void
+    {
+        {
+            const auto lock = std::lock_guard{m_mutex};
+            m_jobs.push_back(std::move(job));
+        }
+        m_condition.notify_one();
+    }
+
+    /**
+     * @brief Returns the number of threads in the pool.
+     */
+    auto thread_count() const noexcept -> std::size_t
+    {
+        return m_threads.size();
+    }
+
+  private:
+    auto work() -> void
+    {
+        while (true)
+        {
+            auto job = std::function<void()>{};
+            {
+                auto lock = std::unique_lock{m_mutex};
+                m_condition.wait(lock, [this]() {
+                    return m_stopping || !m_jobs.empty();
+                });
+
+                if (m_jobs.empty())
+                {
+                    return;
+                }
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::function<void()>> m_jobs;
+    bool m_stopping = false;
+    std::vector<std::thread> m_threads;
+};
+} // namespace kirho
@@ -0,0 +1,602 @@
+/**
+ * @file uring.hpp
+ * @brief Batched file reads and writes on top of io_uring.
+ *
+ * Contains @ref kirho::uring_t, which queues up a bunch of positional reads and
+ * writes and hands all of them to the kernel with a single system call. When
+ * io_uring is not available, either because the kernel is too old, it has been
+ * turned off, or we were built without the headers for it, the operations run
+ * on a @ref kirho::thread_pool_t instead.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define KIRHO_HAS_IO_URING 1
+#else
+#define KIRHO_HAS_IO_URING 0
+#endif
+
+#include "kirho.hpp"
+#include "sys.hpp"
+#include "thread_pool.hpp"
+
+namespace kirho
+{
+/**
+ * @brief Runs positional reads and writes in batches.
+ *
+ * Operations are queued up by @ref pread and @ref pwrite, and are handed to the
+ * kernel all at once by @ref submit. Each of them gives you a future, which
+ * gets its result once the operation is done. Completions are collected by a
+ * thread that the object owns, so you don't have to poll for them.
+ *
+ * The buffers have to stay alive until the operation is complete, and so does
+ * the file descriptor. All of the functions can be called from any thread.
+ */
+class uring_t
+{
+  public:
+    /**
+     * @brief The way in which the operations are carried out.
+     */
+    enum class backend_t
+    {
+        /// Use io_uring if the kernel supports it, and the thread pool if not.
+        automatic,
+        /// Use io_uring, and fail if the kernel doesn't support it.
+        io_uring,
+        /// Run the operations as plain system calls on a thread pool.
+        thread_pool,
+    };
+
+    /**
+     * @brief The future that you get for every operation.
+     */
+    using future_t = std::future<result_t<std::size_t, sys_error_t>>;
+
+    /**
+     * @brief Sets up the backend.
+     *
+     * @param entries The maximum number of operations that can be queued up
+     * before they have to be submitted.
+     * @param backend The backend to use.
+     * @param thread_count The number of threads, in case the thread pool ends
+     * up being used. Zero means one for every core.
+     *
+     * @return The object, or the error if the requested backend could not be
+     * set up.
+     */
+    static auto create(
+        unsigned entries = 256,
+        backend_t backend = backend_t::automatic,
+        std::size_t thread_count = 0
+    ) -> result_t<uring_t, sys_error_t>
+    {
+        using result = result_t<uring_t, sys_error_t>;
+
+        if (backend != backend_t::thread_pool)
+        {
+            auto ring = std::make_unique<ring_t>();
+            const auto error = ring->setup(entries);
+            if (error == 0)
+            {
+                return result::success(uring_t{std::move(ring)});
+            }
+
+            if (backend == backend_t::io_uring)
+            {
+                return result::error(sys_error_t{error});
+            }
+        }
+
+        return result::success(
+            uring_t{std::make_unique<thread_pool_t>(thread_count)}
+        );
+    }
+
+    uring_t(uring_t&&) noexcept = default;
+    uring_t& operator=(uring_t&&) noexcept = default;
+
+    /**
+     * @brief Submits whatever is still queued up, and waits for everything to
+     * complete.
+     */
+    ~uring_t() = default;
+
+    /**
+     * @brief Returns the backend that ended up being used.
+     *
+     * This is never @ref backend_t::automatic.
+     */
+    auto backend() const noexcept -> backend_t
+    {
+        return m_ring != nullptr ? backend_t::io_uring : backend_t::thread_pool;
+    }
+
+    /**
+     * @brief Queues up a read into the buffer from the specified offset.
+     *
+     * If the queue is full, everything that's in it is submitted first.
+     *
+     * @return The future for the number of bytes that were read.
+     */
+    auto pread(
+        const sys::fd_t& fd,
+        std::span<std::byte> buffer,
+        off_t offset
+    ) -> future_t
+    {
+        if (m_ring == nullptr)
+        {
+            return m_pool->submit([fd = fd.get(), buffer, offset]() noexcept {
+                return complete(sys::retry_on_eintr([&]() noexcept {
+                    return ::pread(fd, buffer.data(), buffer.size(), offset);
+                }));
+            });
+        }
+
+#if KIRHO_HAS_IO_URING
+        return m_ring->queue(
+            IORING_OP_READ, fd.get(), buffer.data(), buffer.size(), offset
+        );
+#else
+        return {};
+#endif
+    }
+
+    /**
+     * @brief Queues up a write of the buffer to the specified offset.
+     *
+     * If the queue is full, everything that's in it is submitted first.
+     *
+     * @return The future for the number of bytes that were written.
+     */
+    auto pwrite(
+        const sys::fd_t& fd,
+        std::span<const std::byte> buffer,
+        off_t offset
+    ) -> future_t
+    {
+        if (m_ring == nullptr)
+        {
+            return m_pool->submit([fd = fd.get(), buffer, offset]() noexcept {
+                return complete(sys::retry_on_eintr([&]() noexcept {
+                    return ::pwrite(fd, buffer.data(), buffer.size(), offset);
+                }));
+            });
+        }
+
+#if KIRHO_HAS_IO_URING
+        return m_ring->queue(
+            IORING_OP_WRITE, fd.get(), buffer.data(), buffer.size(), offset
+        );
+#else
+        return {};
+#endif
+    }
+
+    /**
+     * @brief Hands everything that is queued up to the kernel, with a single
+     * system call.
+     *
+     * With the thread pool, operations start as soon as they are queued, so
+     * this does nothing.
+     *
+     * @return The number of operations that were submitted.
+     */
+    auto submit() noexcept -> result_t<std::size_t, sys_error_t>
+    {
+        using result = result_t<std::size_t, sys_error_t>;
+
+        if (m_ring == nullptr)
+        {
+            return result::success(0);
+        }
+
+        const auto lock = std::lock_guard{m_ring->mutex};
+        return m_ring->submit();
+    }
+
+  private:
+    static auto complete(long count) noexcept
+        -> result_t<std::size_t, sys_error_t>
+    {
+        using result = result_t<std::size_t, sys_error_t>;
+
+        if (count < 0)
+        {
+            return result::error(sys_error_t::from_errno());
+        }
+
+        return result::success(static_cast<std::size_t>(count));
+    }
+
+#if KIRHO_HAS_IO_URING
+    // Everything that has to do with the ring itself. It's kept on the heap,
+    // since the thread that reaps the completions needs it to stay put.
+    struct ring_t
+    {
+        using promise_t = std::promise<result_t<std::size_t, sys_error_t>>;
+
+        ~ring_t()
+        {
+            if (!reaper.joinable())
+            {
+                return;
+            }
+
+            // A no-op with no promise attached tells the reaper to stop once
+            // everything else has completed.
+            {
+                const auto lock = std::lock_guard{mutex};
+                while (!push(IORING_OP_NOP, -1, nullptr, 0, 0, nullptr))
+                {
+                    make_room().except("failed to shut down io_uring");
+                }
+                submit().except("failed to shut down io_uring");
+            }
+            reaper.join();
+
+            ::munmap(sqes, sqes_size);
+            if (cq_ptr != sq_ptr)
+            {
+                ::munmap(cq_ptr, cq_size);
+            }
+            ::munmap(sq_ptr, sq_size);
+        }
+
+        // Returns zero, or the errno value if something went wrong.
+        auto setup(unsigned entries) -> int
+        {
+            auto params = io_uring_params{};
+            const auto ring_fd =
+                ::syscall(__NR_io_uring_setup, entries, &params);
+            if (ring_fd < 0)
+            {
+                return errno;
+            }
+            fd.reset(static_cast<int>(ring_fd));
+
+            // IORING_OP_READ and IORING_OP_WRITE came with the same kernel
+            // version as this feature flag, and there is no other cheap way to
+            // find out if they are there.
+            if ((params.features & IORING_FEAT_RW_CUR_POS) == 0)
+            {
+                return ENOSYS;
+            }
+
+            sq_size =
+                params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_size = params.cq_off.cqes +
+                      params.cq_entries * sizeof(io_uring_cqe);
+            if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+            {
+                sq_size = sq_size > cq_size ? sq_size : cq_size;
+            }
+
+            sq_ptr = map(sq_size, IORING_OFF_SQ_RING);
+            if (sq_ptr == MAP_FAILED)
+            {
+                sq_ptr = nullptr;
+                return errno;
+            }
+
+            cq_ptr = sq_ptr;
+            if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0)
+            {
+                cq_ptr = map(cq_size, IORING_OFF_CQ_RING);
+                if (cq_ptr == MAP_FAILED)
+                {
+                    const auto error = errno;
+                    ::munmap(sq_ptr, sq_size);
+                    sq_ptr = nullptr;
+                    return error;
+                }
+            }
+
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            const auto mapped_sqes = map(sqes_size, IORING_OFF_SQES);
+            if (mapped_sqes == MAP_FAILED)
+            {
+                const auto error = errno;
+                if (cq_ptr != sq_ptr)
+                {
+                    ::munmap(cq_ptr, cq_size);
+                }
+                ::munmap(sq_ptr, sq_size);
+                sq_ptr = nullptr;
+                return error;
+            }
+            sqes = static_cast<io_uring_sqe*>(mapped_sqes);
+
+            const auto sq = static_cast<char*>(sq_ptr);
+            sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask =
+                *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+            const auto cq = static_cast<char*>(cq_ptr);
+            cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask =
+                *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            sq_entries = params.sq_entries;
+            cq_entries = params.cq_entries;
+            local_tail = *sq_tail;
+
+            reaper = std::thread{[this]() { reap(); }};
+            return 0;
+        }
+
+        auto map(std::size_t size, off_t offset) const noexcept -> void*
+        {
+            return ::mmap(
+                nullptr,
+                size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE,
+                fd.get(),
+                offset
+            );
+        }
+
+        auto queue(
+            std::uint8_t opcode,
+            int file,
+            const void* data,
+            std::size_t size,
+            off_t offset
+        ) -> future_t
+        {
+            auto promise = std::make_unique<promise_t>();
+            auto future = promise->get_future();
+
+            const auto lock = std::lock_guard{mutex};
+            while (!push(opcode, file, data, size, offset, promise.get()))
+            {
+                auto error = sys_error_t{};
+                if (make_room().is_error(error))
+                {
+                    promise->set_value(
+                        result_t<std::size_t, sys_error_t>::error(error)
+                    );
+                    return future;
+                }
+            }
+
+            promise.release();
+            return future;
+        }
+
+        // Writes a submission into the ring, without telling the kernel about
+        // it yet. Returns false if there's no room for it.
+        auto push(
+            std::uint8_t opcode,
+            int file,
+            const void* data,
+            std::size_t size,
+            off_t offset,
+            promise_t* promise
+        ) noexcept -> bool
+        {
+            if (queued == sq_entries ||
+                in_flight.load(std::memory_order_relaxed) + queued >=
+                    cq_entries)
+            {
+                return false;
+            }
+
+            const auto index = local_tail & sq_mask;
+            auto& sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = opcode;
+            sqe.fd = file;
+            sqe.addr = reinterpret_cast<std::uint64_t>(data);
+            sqe.len = static_cast<std::uint32_t>(size);
+            sqe.off = static_cast<std::uint64_t>(offset);
+            sqe.user_data = reinterpret_cast<std::uint64_t>(promise);
+            sq_array[index] = index;
+
+            local_tail++;
+            queued++;
+            std::atomic_ref{*sq_tail}.store(
+                local_tail, std::memory_order_release
+            );
+            return true;
+        }
+
+        // Either the queue is full, or the kernel has as many operations as
+        // the completion queue can hold, so submit what's there and wait for
+        // some of it to complete.
+        auto make_room() noexcept -> result_t<empty_t, sys_error_t>
+        {
+            using result = result_t<empty_t, sys_error_t>;
+
+            auto error = sys_error_t{};
+            if (submit().is_error(error))
+            {
+                return result::error(error);
+            }
+
+            auto current = in_flight.load(std::memory_order_acquire);
+            while (current >= cq_entries)
+            {
+                in_flight.wait(current, std::memory_order_acquire);
+                current = in_flight.load(std::memory_order_acquire);
+            }
+
+            return result::success();
+        }
+
+        auto submit() noexcept -> result_t<std::size_t, sys_error_t>
+        {
+            using result = result_t<std::size_t, sys_error_t>;
+
+            auto submitted = std::size_t{0};
+            while (queued > 0)
+            {
+                // The operations are counted before they are submitted, since
+                // they could complete before the system call even returns.
+                in_flight.fetch_add(queued, std::memory_order_release);
+                const auto count = ::syscall(
+                    __NR_io_uring_enter, fd.get(), queued, 0, 0, nullptr, 0
+                );
+                const auto accepted =
+                    count > 0 ? static_cast<unsigned>(count) : 0u;
+                in_flight.fetch_sub(
+                    queued - accepted, std::memory_order_release
+                );
+                queued -= accepted;
+                submitted += accepted;
+
+                if (count < 0 && errno != EINTR)
+                {
+                    return result::error(sys_error_t::from_errno());
+                }
+                if (count == 0)
+                {
+                    return result::error(sys_error_t{EAGAIN});
+                }
+            }
+
+            return result::success(submitted);
+        }
+
+        auto reap() noexcept -> void
+        {
+            auto stopping = false;
+            while (!stopping || in_flight.load(std::memory_order_acquire) > 0)
+            {
+                const auto waited = ::syscall(
+                    __NR_io_uring_enter,
+                    fd.get(),
+                    0,
+                    1,
+                    IORING_ENTER_GETEVENTS,
+                    nullptr,
+                    0
+                );
+                if (waited < 0 && errno != EINTR && errno != EAGAIN &&
+                    errno != EBUSY)
+                {
+                    std::cerr << "io_uring_enter failed while waiting for "
+                                 "completions: "
+                              << sys_error_t::from_errno() << '\n';
+                    std::terminate();
+                }
+
+                auto head = *cq_head;
+                const auto tail =
+                    std::atomic_ref{*cq_tail}.load(std::memory_order_acquire);
+                auto completed = 0u;
+                for (; head != tail; head++)
+                {
+                    const auto& cqe = cqes[head & cq_mask];
+                    const auto promise =
+                        reinterpret_cast<promise_t*>(cqe.user_data);
+                    completed++;
+
+                    if (promise == nullptr)
+                    {
+                        stopping = true;
+                        continue;
+                    }
+
+                    using result = result_t<std::size_t, sys_error_t>;
+                    promise->set_value(
+                        cqe.res < 0
+                            ? result::error(sys_error_t{-cqe.res})
+                            : result::success(static_cast<std::size_t>(cqe.res))
+                    );
+                    delete promise;
+                }
+
+                std::atomic_ref{*cq_head}.store(
+                    head, std::memory_order_release
+                );
+                if (completed > 0)
+                {
+                    in_flight.fetch_sub(completed, std::memory_order_release);
+                    in_flight.notify_all();
+                }
+            }
+        }
+
+        sys::fd_t fd;
+        void* sq_ptr = nullptr;
+        void* cq_ptr = nullptr;
+        std::size_t sq_size = 0;
+        std::size_t cq_size = 0;
+        io_uring_sqe* sqes = nullptr;
+        std::size_t sqes_size = 0;
+
+        unsigned* sq_tail = nullptr;
+        unsigned* sq_array = nullptr;
+        unsigned sq_mask = 0;
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        io_uring_cqe* cqes = nullptr;
+        unsigned cq_mask = 0;
+
+        unsigned sq_entries = 0;
+        unsigned cq_entries = 0;
+        unsigned local_tail = 0;
+        unsigned queued = 0;
+        std::atomic<unsigned> in_flight = 0;
+
+        std::mutex mutex;
+        std::thread reaper;
+    };
+#else
+    // Without the headers there's nothing to set up, so the ring never gets
+    // created and everything goes to the thread pool.
+    struct ring_t
+    {
+        std::mutex mutex;
+
+        auto setup(unsigned) noexcept -> int
+        {
+            return ENOSYS;
+        }
+
+        auto submit() noexcept -> result_t<std::size_t, sys_error_t>
+        {
+            return result_t<std::size_t, sys_error_t>::success(0);
+        }
+    };
+#endif
+
+    explicit uring_t(std::unique_ptr<ring_t> p_ring) noexcept
+        : m_ring{std::move(p_ring)}
+    {
+    }
+
+    explicit uring_t(std::unique_ptr<thread_pool_t> p_pool) noexcept
+        : m_pool{std::move(p_pool)}
+    {
+    }
+
+  private:
+    // Only one of these is ever set.
+    std::unique_ptr<ring_t> m_ring;
+    std::unique_ptr<thread_pool_t> m_pool;
+};
+} // namespace kirho
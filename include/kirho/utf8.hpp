@@ -0,0 +1,554 @@
+/**
+ * @file utf8.hpp
+ * @brief UTF-8 validation.
+ *
+ * Contains @ref kirho::validate_utf8, which checks that text is valid UTF-8,
+ * and tells you where it isn't. On x86-64 processors, it checks 16 or 32 bytes
+ * at a time, depending on what the processor supports.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+// Whether we can use x86 vector instructions that the compiler wasn't told to
+// use, and check for them at runtime instead. Define it to 0 to always use the
+// scalar code.
+#ifndef KIRHO_X86_SIMD
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KIRHO_X86_SIMD 1
+#else
+#define KIRHO_X86_SIMD 0
+#endif
+#endif
+
+#if KIRHO_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "kirho.hpp"
+
+namespace kirho
+{
+/**
+ * @brief The reason why some text is not valid UTF-8.
+ */
+struct utf8_error_t
+{
+    /**
+     * @brief The kinds of things that can be wrong with UTF-8.
+     */
+    enum class kind_t
+    {
+        /// A byte that can never appear in UTF-8.
+        invalid_byte,
+        /// A continuation byte without a lead byte in front of it.
+        unexpected_continuation,
+        /// A lead byte that isn't followed by enough continuation bytes.
+        truncated,
+        /// A character that is encoded with more bytes than it needs.
+        overlong,
+        /// A UTF-16 surrogate, which aren't allowed in UTF-8.
+        surrogate,
+        /// A character that is larger than U+10FFFF.
+        too_large,
+    };
+
+    /**
+     * @brief The offset of the first byte of the invalid character.
+     */
+    std::size_t offset = 0;
+
+    /**
+     * @brief What is wrong with the character.
+     */
+    kind_t kind = kind_t::invalid_byte;
+
+    auto operator==(const utf8_error_t&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief Prints the error, so that it can be used with result_t::except.
+ */
+inline auto operator<<(std::ostream& stream, const utf8_error_t& error)
+    -> std::ostream&
+{
+    stream << "invalid UTF-8 at offset " << error.offset << ": ";
+    switch (error.kind)
+    {
+    case utf8_error_t::kind_t::invalid_byte:
+        return stream << "invalid byte";
+    case utf8_error_t::kind_t::unexpected_continuation:
+        return stream << "unexpected continuation byte";
+    case utf8_error_t::kind_t::truncated:
+        return stream << "truncated character";
+    case utf8_error_t::kind_t::overlong:
+        return stream << "overlong encoding";
+    case utf8_error_t::kind_t::surrogate:
+        return stream << "surrogate";
+    case utf8_error_t::kind_t::too_large:
+        return stream << "character above U+10FFFF";
+    }
+
+    return stream;
+}
+
+namespace detail
+{
+// Returned by the vectorized kernels when they didn't find anything wrong.
+inline constexpr auto utf8_valid = ~std::size_t{0};
+
+// Checks one character at a time, starting from a character boundary. This is
+// what finds out where exactly the error is, once a kernel has found that
+// there is one.
+inline auto validate_utf8_scalar(
+    const unsigned char* data,
+    std::size_t size,
+    std::size_t position
+) noexcept -> result_t<empty_t, utf8_error_t>
+{
+    using result = result_t<empty_t, utf8_error_t>;
+    using kind_t = utf8_error_t::kind_t;
+
+    while (position < size)
+    {
+        // Skip over ASCII eight bytes at a time, since that's most of the
+        // text, most of the time.
+        if (size - position >= 8)
+        {
+            auto chunk = std::uint64_t{0};
+            std::memcpy(&chunk, data + position, sizeof(chunk));
+            if ((chunk & 0x8080808080808080) == 0)
+            {
+                position += 8;
+                continue;
+            }
+        }
+
+        const auto lead = data[position];
+        auto length = std::size_t{0};
+        if (lead < 0x80)
+        {
+            position++;
+            continue;
+        }
+        else if (lead < 0xC0)
+        {
+            return result::error({position, kind_t::unexpected_continuation});
+        }
+        else if (lead < 0xC2)
+        {
+            return result::error({position, kind_t::overlong});
+        }
+        else if (lead < 0xE0)
+        {
+            length = 2;
+        }
+        else if (lead < 0xF0)
+        {
+            length = 3;
+        }
+        else if (lead < 0xF5)
+        {
+            length = 4;
+        }
+        else
+        {
+            return result::error({position, kind_t::invalid_byte});
+        }
+
+        if (size - position < length)
+        {
+            return result::error({position, kind_t::truncated});
+        }
+
+        for (auto i = std::size_t{1}; i < length; i++)
+        {
+            if ((data[position + i] & 0xC0) != 0x80)
+            {
+                return result::error({position, kind_t::truncated});
+            }
+        }
+
+        const auto second = data[position + 1];
+        if ((lead == 0xE0 && second < 0xA0) || (lead == 0xF0 && second < 0x90))
+        {
+            return result::error({position, kind_t::overlong});
+        }
+        if (lead == 0xED && second >= 0xA0)
+        {
+            return result::error({position, kind_t::surrogate});
+        }
+        if (lead == 0xF4 && second >= 0x90)
+        {
+            return result::error({position, kind_t::too_large});
+        }
+
+        position += length;
+    }
+
+    return result::success();
+}
+
+#if KIRHO_X86_SIMD
+// The lookup tables from "Validating UTF-8 In Less Than One Instruction Per
+// Byte" by John Keiser and Daniel Lemire. Every byte is looked up together
+// with the byte before it, and each bit in the tables stands for one kind of
+// error. A pair of bytes is invalid when the same bit is set in all three of
+// the lookups.
+inline constexpr std::uint8_t utf8_too_short = 1 << 0;
+inline constexpr std::uint8_t utf8_too_long = 1 << 1;
+inline constexpr std::uint8_t utf8_overlong_3 = 1 << 2;
+inline constexpr std::uint8_t utf8_too_large = 1 << 3;
+inline constexpr std::uint8_t utf8_surrogate = 1 << 4;
+inline constexpr std::uint8_t utf8_overlong_2 = 1 << 5;
+inline constexpr std::uint8_t utf8_too_large_1000 = 1 << 6;
+inline constexpr std::uint8_t utf8_overlong_4 = 1 << 6;
+inline constexpr std::uint8_t utf8_two_continuations = 1 << 7;
+inline constexpr std::uint8_t utf8_carry =
+    utf8_too_short | utf8_too_long | utf8_two_continuations;
+
+// Indexed by the high nibble of the first byte.
+alignas(16) inline constexpr std::uint8_t utf8_byte_1_high[16] = {
+    utf8_too_long,
+    utf8_too_long,
+    utf8_too_long,
+    utf8_too_long,
+    utf8_too_long,
+    utf8_too_long,
+    utf8_too_long,
+    utf8_too_long,
+    utf8_two_continuations,
+    utf8_two_continuations,
+    utf8_two_continuations,
+    utf8_two_continuations,
+    utf8_too_short | utf8_overlong_2,
+    utf8_too_short,
+    utf8_too_short | utf8_overlong_3 | utf8_surrogate,
+    utf8_too_short | utf8_too_large | utf8_too_large_1000 | utf8_overlong_4,
+};
+
+// Indexed by the low nibble of the first byte.
+alignas(16) inline constexpr std::uint8_t utf8_byte_1_low[16] = {
+    utf8_carry | utf8_overlong_3 | utf8_overlong_2 | utf8_overlong_4,
+    utf8_carry | utf8_overlong_2,
+    utf8_carry,
+    utf8_carry,
+    utf8_carry | utf8_too_large,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000 | utf8_surrogate,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+};
+
+// Indexed by the high nibble of the second byte.
+alignas(16) inline constexpr std::uint8_t utf8_byte_2_high[16] = {
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_long | utf8_overlong_2 | utf8_two_continuations | utf8_overlong_3 |
+        utf8_too_large_1000 | utf8_overlong_4,
+    utf8_too_long | utf8_overlong_2 | utf8_two_continuations | utf8_overlong_3 |
+        utf8_too_large,
+    utf8_too_long | utf8_overlong_2 | utf8_two_continuations | utf8_surrogate |
+        utf8_too_large,
+    utf8_too_long | utf8_overlong_2 | utf8_two_continuations | utf8_surrogate |
+        utf8_too_large,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+    utf8_too_short,
+};
+
+// The largest values that the last three bytes of a block can have without
+// starting a character that continues into the next block.
+alignas(32) inline constexpr std::uint8_t utf8_max_tail[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF,
+};
+
+// Returns the offset of the first block of 16 bytes that has an error in it,
+// or utf8_valid if there aren't any.
+__attribute__((target("ssse3"))) inline auto validate_utf8_ssse3(
+    const unsigned char* data,
+    std::size_t size
+) noexcept -> std::size_t
+{
+    const auto byte_1_high =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_high));
+    const auto byte_1_low =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_low));
+    const auto byte_2_high =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(utf8_byte_2_high));
+    const auto max_tail =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(utf8_max_tail + 16));
+    const auto nibble = _mm_set1_epi8(0x0F);
+    const auto zero = _mm_setzero_si128();
+
+    auto previous = zero;
+    auto previous_incomplete = zero;
+    auto position = std::size_t{0};
+    for (; position < size; position += 16)
+    {
+        auto input = zero;
+        if (size - position >= 16)
+        {
+            input = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(data + position)
+            );
+        }
+        else
+        {
+            alignas(16) unsigned char tail[16] = {};
+            std::memcpy(tail, data + position, size - position);
+            input = _mm_load_si128(reinterpret_cast<const __m128i*>(tail));
+        }
+
+        auto error = previous_incomplete;
+        if (_mm_movemask_epi8(input) != 0)
+        {
+            const auto prev1 = _mm_alignr_epi8(input, previous, 15);
+            const auto prev2 = _mm_alignr_epi8(input, previous, 14);
+            const auto prev3 = _mm_alignr_epi8(input, previous, 13);
+
+            const auto special_cases = _mm_and_si128(
+                _mm_and_si128(
+                    _mm_shuffle_epi8(
+                        byte_1_high,
+                        _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)
+                    ),
+                    _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))
+                ),
+                _mm_shuffle_epi8(
+                    byte_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)
+                )
+            );
+
+            // Bytes that come two or three after a three or four byte lead
+            // have to be continuations, which the lookups can't see.
+            const auto must_continue = _mm_and_si128(
+                _mm_or_si128(
+                    _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+                    _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80))
+                ),
+                _mm_set1_epi8(static_cast<char>(0x80))
+            );
+
+            error = _mm_xor_si128(must_continue, special_cases);
+            previous_incomplete = _mm_subs_epu8(input, max_tail);
+        }
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF)
+        {
+            return position;
+        }
+
+        previous = input;
+    }
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(previous_incomplete, zero)) != 0xFFFF)
+    {
+        return position - 16;
+    }
+
+    return utf8_valid;
+}
+
+// The same as above, but with blocks of 32 bytes.
+__attribute__((target("avx2"))) inline auto validate_utf8_avx2(
+    const unsigned char* data,
+    std::size_t size
+) noexcept -> std::size_t
+{
+    // Lambdas don't get the target attribute, so the tables have to be loaded
+    // by hand.
+    const auto byte_1_high = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_high))
+    );
+    const auto byte_1_low = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(utf8_byte_1_low))
+    );
+    const auto byte_2_high = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(utf8_byte_2_high))
+    );
+    const auto max_tail =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(utf8_max_tail));
+    const auto nibble = _mm256_set1_epi8(0x0F);
+    const auto zero = _mm256_setzero_si256();
+
+    auto previous = zero;
+    auto previous_incomplete = zero;
+    auto position = std::size_t{0};
+    for (; position < size; position += 32)
+    {
+        auto input = zero;
+        if (size - position >= 32)
+        {
+            input = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(data + position)
+            );
+        }
+        else
+        {
+            alignas(32) unsigned char tail[32] = {};
+            std::memcpy(tail, data + position, size - position);
+            input = _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+        }
+
+        auto error = previous_incomplete;
+        if (_mm256_movemask_epi8(input) != 0)
+        {
+            // The shifts only work within the 128 bit lanes, so the lanes have
+            // to be lined up with the previous ones first.
+            const auto shifted =
+                _mm256_permute2x128_si256(previous, input, 0x21);
+            const auto prev1 = _mm256_alignr_epi8(input, shifted, 15);
+            const auto prev2 = _mm256_alignr_epi8(input, shifted, 14);
+            const auto prev3 = _mm256_alignr_epi8(input, shifted, 13);
+
+            const auto special_cases = _mm256_and_si256(
+                _mm256_and_si256(
+                    _mm256_shuffle_epi8(
+                        byte_1_high,
+                        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)
+                    ),
+                    _mm256_shuffle_epi8(
+                        byte_1_low, _mm256_and_si256(prev1, nibble)
+                    )
+                ),
+                _mm256_shuffle_epi8(
+                    byte_2_high,
+                    _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)
+                )
+            );
+
+            const auto must_continue = _mm256_and_si256(
+                _mm256_or_si256(
+                    _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)),
+                    _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80))
+                ),
+                _mm256_set1_epi8(static_cast<char>(0x80))
+            );
+
+            error = _mm256_xor_si256(must_continue, special_cases);
+            previous_incomplete = _mm256_subs_epu8(input, max_tail);
+        }
+
+        if (!_mm256_testz_si256(error, error))
+        {
+            return position;
+        }
+
+        previous = input;
+    }
+
+    if (!_mm256_testz_si256(previous_incomplete, previous_incomplete))
+    {
+        return position - 32;
+    }
+
+    return utf8_valid;
+}
+#endif
+
+// The kernels look at the text in blocks, and return the offset of the first
+// block that has an error in it.
+using utf8_kernel_t = std::size_t (*)(const unsigned char*, std::size_t);
+
+// Picks the widest kernel that the processor supports. The scalar fallback
+// has nothing to narrow things down with, so it just reports the start.
+inline auto select_utf8_kernel() noexcept -> utf8_kernel_t
+{
+#if KIRHO_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return validate_utf8_avx2;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return validate_utf8_ssse3;
+    }
+#endif
+
+    return [](const unsigned char*, std::size_t) -> std::size_t { return 0; };
+}
+
+inline auto validate_utf8_with(
+    utf8_kernel_t kernel,
+    const unsigned char* data,
+    std::size_t size
+) noexcept -> result_t<empty_t, utf8_error_t>
+{
+    const auto block = kernel(data, size);
+    if (block == utf8_valid)
+    {
+        return result_t<empty_t, utf8_error_t>::success();
+    }
+
+    // The error might have been caused by a character that started in the
+    // previous block, so start a bit before this one. Everything before the
+    // block was valid, so skipping continuation bytes from there gets us to
+    // the start of a character.
+    auto start = block >= 4 ? block - 4 : 0;
+    while (start > 0 && start < block && (data[start] & 0xC0) == 0x80)
+    {
+        start++;
+    }
+
+    return validate_utf8_scalar(data, size, start);
+}
+} // namespace detail
+
+/**
+ * @brief Checks that the text is valid UTF-8.
+ *
+ * The text is checked in large blocks with whatever vector instructions the
+ * processor has, which is picked the first time this gets called. Once a block
+ * with an error in it is found, that part is checked again one character at a
+ * time to find out what and where the error is.
+ *
+ * @param text The text to check.
+ *
+ * @return Nothing, or the first thing that is wrong with the text.
+ */
+inline auto validate_utf8(std::span<const char8_t> text) noexcept
+    -> result_t<empty_t, utf8_error_t>
+{
+    static const auto kernel = detail::select_utf8_kernel();
+
+    return detail::validate_utf8_with(
+        kernel,
+        reinterpret_cast<const unsigned char*>(text.data()),
+        text.size()
+    );
+}
+
+/**
+ * @brief Checks that the text is valid UTF-8.
+ */
+inline auto validate_utf8(std::string_view text) noexcept
+    -> result_t<empty_t, utf8_error_t>
+{
+    return validate_utf8(std::span{
+        reinterpret_cast<const char8_t*>(text.data()), text.size()
+    });
+}
+} // namespace kirho
@@ -0,0 +1,256 @@
+/**
+ * @file validation.hpp
+ * @brief Checking many things at once, and reporting everything that's wrong.
+ *
+ * Contains @ref kirho::validation_t, which is like a @ref kirho::result_t,
+ * except that it holds every error instead of just one, and
+ * @ref kirho::validate, which puts the outcomes of checks that don't depend
+ * on each other together. This way, a request with three invalid fields gets
+ * told about all three of them at once, rather than one at a time.
+ */
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "kirho.hpp"
+#include "small_vector.hpp"
+
+namespace kirho
+{
+/**
+ * @brief Either a value, or one or more errors.
+ *
+ * The errors are kept in a @ref small_vector_t, so up to `N` of them don't
+ * need an allocation, and a valid value needs none at all.
+ *
+ * @tparam T The type of the value.
+ * @tparam E The type of the errors.
+ * @tparam N The number of errors that fit without allocating.
+ */
+template <typename T, typename E, std::size_t N = 4>
+class validation_t
+{
+  public:
+    using value_type = T;
+    using error_type = E;
+    using errors_t = small_vector_t<E, N>;
+
+    /**
+     * @brief Creates a valid value.
+     */
+    static auto success(T value = T{}) noexcept -> validation_t
+    {
+        return validation_t{
+            std::variant<T, errors_t>{std::in_place_index<0>, std::move(value)}
+        };
+    }
+
+    /**
+     * @brief Creates a validation that failed with a single error.
+     */
+    static auto error(E error) -> validation_t
+    {
+        auto errors = errors_t{};
+        errors.push_back(std::move(error));
+        return failure(std::move(errors));
+    }
+
+    /**
+     * @brief Creates a validation that failed with all of the errors, of
+     * which there has to be at least one.
+     */
+    static auto failure(errors_t errors) -> validation_t
+    {
+        if (errors.empty())
+        {
+            std::cerr << "kirho: a failed validation needs at least one "
+                         "error.\n";
+            std::terminate();
+        }
+
+        return validation_t{
+            std::variant<T, errors_t>{std::in_place_index<1>, std::move(errors)}
+        };
+    }
+
+    /**
+     * @brief Turns a result into a validation, with its error as the only
+     * one.
+     */
+    static auto from(result_t<T, E> result) -> validation_t
+    {
+        auto error = E{};
+        if (result.is_error(error))
+        {
+            return validation_t::error(std::move(error));
+        }
+
+        return success(std::move(result).unwrap());
+    }
+
+    /**
+     * @brief Checks if the value is valid.
+     */
+    auto is_valid() const noexcept -> bool
+    {
+        return m_union.index() == 0;
+    }
+
+    /**
+     * @brief Checks if the value is valid, and returns it through the
+     * reference if it is.
+     */
+    auto is_success(T& value) const noexcept -> bool
+    {
+        if (!is_valid())
+        {
+            return false;
+        }
+
+        value = std::get<0>(m_union);
+        return true;
+    }
+
+    /**
+     * @brief Returns the errors, of which there are none if the value is
+     * valid.
+     */
+    auto errors() const noexcept -> std::span<const E>
+    {
+        if (is_valid())
+        {
+            return {};
+        }
+
+        const auto& errors = std::get<1>(m_union);
+        return {errors.data(), errors.size()};
+    }
+
+    /**
+     * @brief Moves the value out, or panics if there were errors.
+     */
+    auto unwrap() && noexcept -> T
+    {
+        if (!is_valid())
+        {
+            std::cerr << "validation_t::unwrap called on "
+                      << std::get<1>(m_union).size() << " errors.\n";
+            std::terminate();
+        }
+
+        return std::get<0>(std::move(m_union));
+    }
+
+    /**
+     * @brief Turns the validation into a result, whose error is all of the
+     * errors.
+     */
+    auto to_result() && -> result_t<T, errors_t>
+    {
+        using result = result_t<T, errors_t>;
+
+        if (!is_valid())
+        {
+            return result::error(std::get<1>(std::move(m_union)));
+        }
+
+        return result::success(std::get<0>(std::move(m_union)));
+    }
+
+    validation_t(const validation_t&) = delete;
+    validation_t& operator=(const validation_t&) = delete;
+
+    validation_t(validation_t&&) noexcept = default;
+    validation_t& operator=(validation_t&&) noexcept = default;
+
+  private:
+    explicit validation_t(std::variant<T, errors_t> p_union)
+        : m_union{std::move(p_union)}
+    {
+    }
+
+  private:
+    std::variant<T, errors_t> m_union;
+};
+
+namespace detail
+{
+template <typename T, typename E, std::size_t N>
+auto collect_errors(
+    const result_t<T, E>& result, small_vector_t<E, N>& errors
+) -> void
+{
+    auto error = E{};
+    if (result.is_error(error))
+    {
+        errors.push_back(std::move(error));
+    }
+}
+
+template <typename T, typename E, std::size_t M, std::size_t N>
+auto collect_errors(
+    const validation_t<T, E, M>& validation, small_vector_t<E, N>& errors
+) -> void
+{
+    for (const auto& error : validation.errors())
+    {
+        errors.push_back(error);
+    }
+}
+
+// The type of error of the first check, which every other one has to match.
+template <typename... Rs>
+using first_error_t =
+    typename std::tuple_element_t<0, std::tuple<Rs...>>::error_type;
+} // namespace detail
+
+/**
+ * @brief Puts the outcomes of several independent checks together, keeping
+ * the errors of all of them.
+ *
+ * Every argument is either a @ref result_t or a @ref validation_t, and they
+ * all have to have the same type of error. If none of them failed, the values
+ * come out together in a tuple, in the same order, which makes for
+ *
+ *     auto checked = kirho::validate(check_name(name), check_age(age));
+ *     if (checked.is_valid())
+ *     {
+ *         auto [valid_name, valid_age] = std::move(checked).unwrap();
+ *     }
+ *
+ * Otherwise, the errors of all of the arguments come out, in the same order.
+ *
+ * @tparam N The number of errors that fit without allocating.
+ */
+template <std::size_t N = 4, typename... Rs>
+auto validate(Rs... results) -> validation_t<
+    std::tuple<typename Rs::value_type...>,
+    detail::first_error_t<Rs...>,
+    N>
+{
+    using error_t = detail::first_error_t<Rs...>;
+    static_assert(
+        (std::is_same_v<typename Rs::error_type, error_t> && ...),
+        "every check has to fail with the same type of error"
+    );
+
+    using validation =
+        validation_t<std::tuple<typename Rs::value_type...>, error_t, N>;
+
+    auto errors = typename validation::errors_t{};
+    (detail::collect_errors(results, errors), ...);
+    if (!errors.empty())
+    {
+        return validation::failure(std::move(errors));
+    }
+
+    return validation::success({std::move(results).unwrap()...});
+}
+} // namespace kirho
@@ -0,0 +1,60 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <kirho/arena.hpp>
+
+struct point_t
+{
+    double x;
+    double y;
+};
+
+auto main() -> int
+{
+    auto arena = kirho::arena_t{1024};
+    assert(arena.used() == 0 && arena.capacity() == 0);
+
+    // Objects come out aligned, one after the other.
+    [[maybe_unused]] auto* first = arena.make<point_t>(1.0, 2.0);
+    [[maybe_unused]] auto* second = arena.make<point_t>(3.0, 4.0);
+    assert(first->x == 1.0 && second->y == 4.0);
+    assert(reinterpret_cast<std::uintptr_t>(first) % alignof(point_t) == 0);
+    assert(second == first + 1);
+    assert(arena.used() == 2 * sizeof(point_t));
+
+    [[maybe_unused]] auto* wide = arena.allocate(16, 64);
+    assert(reinterpret_cast<std::uintptr_t>(wide) % 64 == 0);
+
+    // Allocations that are bigger than a block get one of their own.
+    auto* big = static_cast<std::byte*>(arena.allocate(4096, 8));
+    big[4095] = std::byte{1};
+    assert(arena.capacity() >= 1024 + 4096);
+
+    // Resetting starts over, and keeps the blocks.
+    [[maybe_unused]] const auto capacity = arena.capacity();
+    arena.reset();
+    assert(arena.used() == 0);
+    [[maybe_unused]] auto* again = arena.make<point_t>(5.0, 6.0);
+    assert(again == first);
+    for (auto i = 0; i < 100; i++)
+    {
+        [[maybe_unused]] auto* small = arena.allocate(32, 8);
+        assert(small != nullptr);
+    }
+    assert(arena.capacity() == capacity);
+
+    // The pmr containers can use it.
+    arena.reset();
+    {
+        auto words = std::pmr::vector<std::pmr::string>{&arena};
+        for (auto i = 0; i < 100; i++)
+        {
+            words.emplace_back("a string that's too long to be stored inline");
+        }
+        assert(words.size() == 100);
+    }
+}
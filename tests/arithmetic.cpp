@@ -0,0 +1,146 @@
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <kirho/arithmetic.hpp>
+
+using kirho::arith_error_t;
+using kind_t = kirho::arith_error_t::kind_t;
+
+template <typename T>
+auto error_of(const kirho::result_t<T, arith_error_t>& outcome)
+    -> arith_error_t
+{
+    auto error = arith_error_t{};
+    [[maybe_unused]] const auto failed = outcome.is_error(error);
+    assert(failed);
+    return error;
+}
+
+// The array versions have to agree with the one at a time versions, with
+// overflows dropped in at random places.
+template <typename T>
+auto check_batches(std::mt19937_64& random) -> void
+{
+    constexpr auto max = std::numeric_limits<T>::max();
+    constexpr auto min = std::numeric_limits<T>::min();
+
+    for (auto round = 0; round < 300; round++)
+    {
+        const auto size = random() % 300;
+        auto lhs = std::vector<T>(size);
+        auto rhs = std::vector<T>(size);
+        for (auto i = std::size_t{0}; i < size; i++)
+        {
+            lhs[i] = static_cast<T>(random() % 1000);
+            rhs[i] = static_cast<T>(random() % 1000);
+            if (random() % 200 == 0)
+            {
+                lhs[i] = random() % 2 == 0 ? max : min;
+            }
+        }
+
+        for (auto op = 0; op < 3; op++)
+        {
+            auto expected_index = size;
+            auto expected = std::vector<T>(size);
+            for (auto i = std::size_t{0}; i < size; i++)
+            {
+                const auto outcome =
+                    op == 0   ? kirho::checked_add(lhs[i], rhs[i])
+                    : op == 1 ? kirho::checked_sub(lhs[i], rhs[i])
+                              : kirho::checked_mul(lhs[i], rhs[i]);
+                if (!outcome.is_success(expected[i]))
+                {
+                    expected_index = i;
+                    break;
+                }
+            }
+
+            auto output = std::vector<T>(size);
+            [[maybe_unused]] const auto outcome =
+                op == 0   ? kirho::checked_add<T>(lhs, rhs, output)
+                : op == 1 ? kirho::checked_sub<T>(lhs, rhs, output)
+                          : kirho::checked_mul<T>(lhs, rhs, output);
+
+            [[maybe_unused]] auto error = arith_error_t{};
+            assert(outcome.is_error(error) == (expected_index != size));
+            assert(expected_index == size || error.index == expected_index);
+            for (auto i = std::size_t{0}; i < expected_index; i++)
+            {
+                assert(output[i] == expected[i]);
+            }
+        }
+
+        [[maybe_unused]] auto expected_index = size;
+        auto total = T{0};
+        for (auto i = std::size_t{0}; i < size; i++)
+        {
+            if (!kirho::checked_add(total, lhs[i]).is_success(total))
+            {
+                expected_index = i;
+                break;
+            }
+        }
+
+        [[maybe_unused]] auto error = arith_error_t{};
+        [[maybe_unused]] const auto sum = kirho::checked_sum<T>(lhs);
+        assert(sum.is_error(error) == (expected_index != size));
+        assert(expected_index == size || error.index == expected_index);
+        assert(expected_index != size || sum.unwrap() == total);
+    }
+}
+
+auto main() -> int
+{
+    constexpr auto max = std::numeric_limits<std::int64_t>::max();
+    [[maybe_unused]] constexpr auto min =
+        std::numeric_limits<std::int64_t>::min();
+
+    assert(kirho::checked_add(std::int64_t{2}, 3).unwrap() == 5);
+    assert(error_of(kirho::checked_add(max, 1)).kind == kind_t::overflow);
+    assert(error_of(kirho::checked_sub(min, 1)).kind == kind_t::overflow);
+    assert(error_of(kirho::checked_sub(0u, 1u)).kind == kind_t::overflow);
+    assert(kirho::checked_mul(-4, 5).unwrap() == -20);
+    assert(error_of(kirho::checked_mul(max, 2)).kind == kind_t::overflow);
+    assert(kirho::checked_div(7, -2).unwrap() == -3);
+    assert(
+        error_of(kirho::checked_div(1, 0)).kind == kind_t::division_by_zero
+    );
+    assert(error_of(kirho::checked_div(min, -1)).kind == kind_t::overflow);
+
+    assert(kirho::narrow_cast<std::uint8_t>(255).unwrap() == 255);
+    assert(
+        error_of(kirho::narrow_cast<std::uint8_t>(256)).kind ==
+        kind_t::out_of_range
+    );
+    assert(
+        error_of(kirho::narrow_cast<std::uint32_t>(-1)).kind ==
+        kind_t::out_of_range
+    );
+    assert(kirho::narrow_cast<std::int32_t>(std::uint64_t{42}).unwrap() == 42);
+
+    // Overflowing halfway through, then coming back into range, still counts.
+    const auto values = std::vector<std::int64_t>{max, 1, -1};
+    assert((error_of(kirho::checked_sum<std::int64_t>(values)) ==
+            arith_error_t{kind_t::overflow, 1}));
+
+    // The output can be one of the inputs, even when a whole block overflows.
+    auto in_place = std::vector<int>(64, 0);
+    const auto ones = std::vector<int>(64, 1);
+    in_place[5] = std::numeric_limits<int>::max();
+    [[maybe_unused]] const auto in_place_outcome =
+        kirho::checked_add<int>(in_place, ones, in_place);
+    assert((error_of(in_place_outcome) == arith_error_t{kind_t::overflow, 5}));
+    assert(in_place[4] == 1);
+
+    auto random = std::mt19937_64{42};
+    check_batches<std::int64_t>(random);
+    check_batches<std::uint64_t>(random);
+    check_batches<std::int32_t>(random);
+    check_batches<std::uint16_t>(random);
+    check_batches<std::int8_t>(random);
+}
@@ -0,0 +1,133 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kirho/batcher.hpp>
+
+using namespace std::chrono_literals;
+using batcher_t = kirho::batcher_t<int, int, std::string>;
+using result_t = batcher_t::result;
+
+// Squares the even numbers, and fails on the odd ones.
+auto square_evens(std::span<const int> items) -> std::vector<result_t>
+{
+    auto results = std::vector<result_t>{};
+    results.reserve(items.size());
+    for (const auto item : items)
+    {
+        results.push_back(
+            item % 2 == 0 ? result_t::success(item * item)
+                          : result_t::error("odd " + std::to_string(item))
+        );
+    }
+
+    return results;
+}
+
+auto main() -> int
+{
+    // Every item gets its own result, even when they come from many threads.
+    auto sizes = std::vector<std::size_t>{};
+    auto options = kirho::batcher_options_t{};
+    options.max_size = 32;
+    options.max_delay = 5ms;
+    {
+        auto batcher = batcher_t{
+            [&sizes](std::span<const int> items) {
+                sizes.push_back(items.size());
+                return square_evens(items);
+            },
+            options
+        };
+
+        auto threads = std::vector<std::thread>{};
+        for (auto t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&batcher, t]() {
+                auto futures = std::vector<std::future<result_t>>{};
+                for (auto i = 0; i < 1000; i++)
+                {
+                    futures.push_back(batcher.submit(t * 1000 + i));
+                }
+
+                auto error = std::string{};
+                for (auto i = 0; i < 1000; i++)
+                {
+                    const auto item = t * 1000 + i;
+                    auto outcome = futures[static_cast<std::size_t>(i)].get();
+                    if (item % 2 == 0)
+                    {
+                        assert(outcome.unwrap() == item * item);
+                    }
+                    else
+                    {
+                        assert(outcome.is_error(error));
+                        assert(error == "odd " + std::to_string(item));
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        // The items were actually batched, and never more than allowed.
+        auto total = std::size_t{0};
+        for (const auto size : sizes)
+        {
+            assert(size <= 32);
+            total += size;
+        }
+        assert(total == 4000);
+        assert(batcher.batch_count() == sizes.size());
+        assert(sizes.size() < 4000);
+    }
+
+    // A lone item is handed over once it has waited long enough.
+    {
+        auto batcher = batcher_t{square_evens, options};
+        [[maybe_unused]] const auto start = std::chrono::steady_clock::now();
+        [[maybe_unused]] const auto squared = batcher.submit(4).get().unwrap();
+        assert(squared == 16);
+        assert(std::chrono::steady_clock::now() - start >= 5ms);
+    }
+
+    // Whatever is left is handed over when the batcher goes away.
+    auto leftover = std::future<result_t>{};
+    {
+        auto slow = options;
+        slow.max_delay = 1h;
+        auto batcher = batcher_t{square_evens, slow};
+        leftover = batcher.submit(6);
+    }
+    [[maybe_unused]] const auto handed_over = leftover.get().unwrap();
+    assert(handed_over == 36);
+
+    // When the function throws, every item in the batch gets the exception.
+    {
+        auto batcher = batcher_t{
+            [](std::span<const int>) -> std::vector<result_t> { throw 7; },
+            options
+        };
+        auto first = batcher.submit(1);
+        auto second = batcher.submit(2);
+        for (auto* future : {&first, &second})
+        {
+            try
+            {
+                future->get();
+                assert(false);
+            }
+            catch (int value)
+            {
+                assert(value == 7);
+            }
+        }
+    }
+}
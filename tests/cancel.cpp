@@ -0,0 +1,85 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <kirho/cancel.hpp>
+#include <kirho/thread_pool.hpp>
+
+using kind_t = kirho::cancel_error_t::kind_t;
+
+auto main() -> int
+{
+    // Tokens see the requests made through their source, and tokens that
+    // don't have one never stop.
+    auto source = kirho::stop_source_t{};
+    const auto token = source.token();
+    assert(!token.stop_requested());
+    assert(!kirho::stop_token_t{}.stop_requested());
+    assert(kirho::check_cancelled(token).to_optional().has_value());
+
+    source.request_stop();
+    assert(token.stop_requested());
+    assert(source.stop_requested());
+
+    [[maybe_unused]] auto error = kirho::cancel_error_t{};
+    assert(kirho::check_cancelled(token).is_error(error));
+    assert(error.kind == kind_t::cancelled);
+
+    // Deadlines pass, unless they're never.
+    const auto never = kirho::deadline_t::never();
+    assert(never.is_never() && !never.expired());
+    assert(kirho::deadline_t::after(std::chrono::hours::max()).is_never());
+
+    [[maybe_unused]] const auto soon =
+        kirho::deadline_t::after(std::chrono::milliseconds{10});
+    assert(!soon.expired());
+    assert(soon.remaining() > std::chrono::milliseconds{0});
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    assert(soon.expired());
+    assert(soon.remaining() == std::chrono::milliseconds{0});
+    assert(kirho::check_cancelled({}, soon).is_error(error));
+    assert(error.kind == kind_t::timed_out);
+
+    // The pool doesn't start jobs that nobody is waiting for anymore.
+    auto ran = std::atomic<int>{0};
+    {
+        auto pool = kirho::thread_pool_t{1};
+
+        // Keeps the only thread busy, so that the deadlines pass while the
+        // jobs are queued up.
+        auto gate = std::promise<void>{};
+        pool.post([future = gate.get_future().share()]() { future.wait(); });
+
+        auto requests = kirho::stop_source_t{};
+        auto cancelled = pool.submit(requests.token(), never, [&ran]() {
+            ran++;
+        });
+        auto late = pool.submit(
+            kirho::stop_token_t{},
+            kirho::deadline_t::after(std::chrono::milliseconds{5}),
+            [&ran]() {
+                ran++;
+                return 1;
+            }
+        );
+        auto fine = pool.submit(kirho::stop_token_t{}, never, [&ran]() {
+            ran++;
+            return 2;
+        });
+
+        requests.request_stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        gate.set_value();
+
+        [[maybe_unused]] const auto stopped = cancelled.get().is_error(error);
+        assert(stopped && error.kind == kind_t::cancelled);
+        [[maybe_unused]] const auto expired = late.get().is_error(error);
+        assert(expired && error.kind == kind_t::timed_out);
+        [[maybe_unused]] const auto value = fine.get().unwrap();
+        assert(value == 2);
+    }
+    assert(ran == 1);
+}
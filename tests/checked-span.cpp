@@ -0,0 +1,51 @@
+#include <array>
+#include <cassert>
+#include <vector>
+
+#include <kirho/checked_span.hpp>
+
+using kirho::out_of_bounds_t;
+
+auto sum(kirho::checked_span_t<const int> values) -> int
+{
+    auto total = 0;
+    for (auto i = std::size_t{0}; i < values.size(); i++)
+    {
+        total += values.at(i).unwrap();
+    }
+    return total;
+}
+
+auto main() -> int
+{
+    auto values = std::vector<int>{1, 2, 3, 4};
+    auto span = kirho::checked_span_t{values};
+    static_assert(std::is_same_v<decltype(span), kirho::checked_span_t<int>>);
+
+    span.at(1).unwrap().get() = 20;
+    assert(values[1] == 20);
+    span[2] = 30;
+    assert(values[2] == 30);
+    assert(sum(values) == 55);
+
+    [[maybe_unused]] auto error = out_of_bounds_t{};
+    assert(span.at(4).is_error(error));
+    assert((error == out_of_bounds_t{4, 4}));
+
+    [[maybe_unused]] const auto middle = span.subspan_checked(1, 2).unwrap();
+    assert(middle.size() == 2 && middle[0] == 20 && middle[1] == 30);
+    assert(span.subspan_checked(4).unwrap().empty());
+    assert(span.subspan_checked(1).unwrap().size() == 3);
+    assert(span.subspan_checked(5).is_error(error));
+    assert((error == out_of_bounds_t{5, 4}));
+    assert(span.subspan_checked(2, 3).is_error(error));
+    assert((error == out_of_bounds_t{5, 4}));
+    assert(span.subspan_checked(1, std::size_t(-2)).is_error(error));
+
+    // Without checks, the same code still works for indices in bounds.
+    const auto array = std::array<int, 3>{5, 6, 7};
+    [[maybe_unused]] auto unchecked =
+        kirho::checked_span_t<const int, kirho::assumed_bounds_t>{array};
+    assert(unchecked.at(2).unwrap() == 7);
+    assert(unchecked.subspan_checked(1).unwrap()[1] == 7);
+}
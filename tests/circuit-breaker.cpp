@@ -0,0 +1,125 @@
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <kirho/circuit_breaker.hpp>
+
+using namespace std::chrono_literals;
+using result_t = kirho::result_t<int, std::string>;
+using state_t = kirho::circuit_breaker_t::state_t;
+
+auto main() -> int
+{
+    auto options = kirho::circuit_breaker_options_t{};
+    options.minimum_calls = 10;
+    options.failure_ratio = 0.5;
+    options.window = 1s;
+    options.open_duration = 20ms;
+    options.probes = 2;
+    auto breaker = kirho::circuit_breaker_t{options};
+
+    auto healthy = true;
+    auto calls = 0;
+    const auto dependency = [&]() {
+        calls++;
+        return healthy ? result_t::success(calls) : result_t::error("down");
+    };
+
+    // Calls go through, and their results come back as they are.
+    [[maybe_unused]] auto value = 0;
+    for (auto i = 0; i < 10; i++)
+    {
+        value = breaker.call(dependency).unwrap().unwrap();
+        assert(value == calls);
+    }
+    assert(breaker.state() == state_t::closed);
+
+    // A few failures aren't enough to open the circuit, but half of the
+    // calls failing is.
+    healthy = false;
+    auto error = std::string{};
+    [[maybe_unused]] auto failed = false;
+    for (auto i = 0; i < 9; i++)
+    {
+        failed = breaker.call(dependency).unwrap().is_error(error);
+        assert(failed);
+        assert(breaker.state() == state_t::closed);
+    }
+    failed = breaker.call(dependency).unwrap().is_error(error);
+    assert(failed);
+    assert(breaker.state() == state_t::open);
+
+    // Once it's open, calls fail right away, without being made.
+    [[maybe_unused]] const auto made = calls;
+    [[maybe_unused]] auto open = kirho::circuit_open_t{};
+    [[maybe_unused]] auto refused = breaker.call(dependency).is_error(open);
+    assert(refused);
+    assert(open.retry_after > 0ms && open.retry_after <= 20ms);
+    assert(calls == made);
+
+    // After a while, a probe goes through, and opens it again if it fails.
+    std::this_thread::sleep_for(25ms);
+    failed = breaker.call(dependency).unwrap().is_error(error);
+    assert(failed);
+    assert(calls == made + 1);
+    assert(breaker.state() == state_t::open);
+    refused = breaker.call(dependency).is_error(open);
+    assert(refused);
+
+    // Enough probes in a row that work close it again, with a clean window.
+    std::this_thread::sleep_for(25ms);
+    healthy = true;
+    value = breaker.call(dependency).unwrap().unwrap();
+    assert(value == made + 2);
+    assert(breaker.state() == state_t::half_open);
+    value = breaker.call(dependency).unwrap().unwrap();
+    assert(value == made + 3);
+    assert(breaker.state() == state_t::closed);
+
+    healthy = false;
+    failed = breaker.call(dependency).unwrap().is_error(error);
+    assert(failed);
+    assert(breaker.state() == state_t::closed);
+
+    // Exceptions count as failures, and are let through.
+    auto thrower = kirho::circuit_breaker_t{options};
+    for (auto i = 0; i < 10; i++)
+    {
+        try
+        {
+            thrower.call([]() -> result_t { throw 1; });
+            assert(false);
+        }
+        catch (int)
+        {
+        }
+    }
+    assert(thrower.state() == state_t::open);
+
+    // A call that was let through while the circuit was closed, and only
+    // fails after it has opened, doesn't push back when it reopens.
+    options.open_duration = 200ms;
+    auto late = kirho::circuit_breaker_t{options};
+    [[maybe_unused]] auto opened = kirho::circuit_open_t{};
+    auto slow = late.call([&]() {
+        for (auto i = 0; i < 10; i++)
+        {
+            failed = late.call(dependency).unwrap().is_error(error);
+            assert(failed);
+        }
+
+        refused = late.call(dependency).is_error(opened);
+        assert(refused);
+        std::this_thread::sleep_for(10ms);
+        return result_t::error("timed out");
+    });
+    failed = std::move(slow).unwrap().is_error(error);
+    assert(failed);
+    assert(late.state() == state_t::open);
+
+    [[maybe_unused]] auto reopening = kirho::circuit_open_t{};
+    refused = late.call(dependency).is_error(reopening);
+    assert(refused);
+    assert(reopening.retry_after <= opened.retry_after - 10ms);
+}
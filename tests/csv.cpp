@@ -0,0 +1,163 @@
+#include <cassert>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <kirho/csv.hpp>
+
+using kirho::csv_error_t;
+using kind_t = kirho::csv_error_t::kind_t;
+using rows_t = std::vector<std::vector<std::string>>;
+
+auto read_all(kirho::csv_reader_t& reader, rows_t& rows) -> void
+{
+    for (;;)
+    {
+        const auto row = reader.read_row().unwrap();
+        if (row.empty())
+        {
+            return;
+        }
+
+        rows.emplace_back(row.begin(), row.end());
+    }
+}
+
+auto read_all(std::string_view text) -> rows_t
+{
+    auto reader = kirho::csv_reader_t{text};
+    auto rows = rows_t{};
+    read_all(reader, rows);
+    return rows;
+}
+
+auto error_of(std::string_view text) -> csv_error_t
+{
+    auto reader = kirho::csv_reader_t{text};
+    auto error = csv_error_t{};
+    for (;;)
+    {
+        const auto outcome = reader.read_row();
+        if (outcome.is_error(error))
+        {
+            return error;
+        }
+        assert(!outcome.unwrap().empty());
+    }
+}
+
+auto main() -> int
+{
+    assert(read_all("").empty());
+    assert((read_all("a,b,c") == rows_t{{"a", "b", "c"}}));
+    assert((read_all("a,b\n1,2\n") == rows_t{{"a", "b"}, {"1", "2"}}));
+    assert((read_all("a,b\r\n1,\r\n") == rows_t{{"a", "b"}, {"1", ""}}));
+    assert((read_all(",\n\n") == rows_t{{"", ""}, {""}}));
+    assert(
+        (read_all("\"a,b\",\"say \"\"hi\"\"\"\n\"x\ny\"\r\n") ==
+         rows_t{{"a,b", "say \"\"hi\"\""}, {"x\ny"}})
+    );
+    assert(kirho::csv_unescape("say \"\"hi\"\"") == "say \"hi\"");
+
+    auto tabs = kirho::csv_reader_t{"a\tb,c\n", '\t'};
+    auto rows = rows_t{};
+    read_all(tabs, rows);
+    assert((rows == rows_t{{"a", "b,c"}}));
+
+    // Quoted newlines still count towards the line numbers.
+    assert(
+        (error_of("a\n\"b\nc\",d\"e") ==
+         csv_error_t{3, 5, kind_t::unexpected_quote})
+    );
+    assert(
+        (error_of("a,\"b\"c\n") ==
+         csv_error_t{1, 6, kind_t::text_after_quote})
+    );
+    assert(
+        (error_of("a\nb,\"c") ==
+         csv_error_t{2, 3, kind_t::unterminated_quote})
+    );
+
+    // Errors that are far into the text have to be found in the same place by
+    // the bitmasks as by the slow path.
+    auto long_text = std::string(100, 'x') + ",y\"z\n";
+    assert(
+        (error_of(long_text) ==
+         csv_error_t{1, 103, kind_t::unexpected_quote})
+    );
+
+    // Every kernel has to find the same characters as the scalar one.
+    auto random = std::mt19937{42};
+    for (auto round = 0; round < 1000; round++)
+    {
+        char block[64];
+        for (auto& byte : block)
+        {
+            byte = "ab,\"\n\r;"[random() % 7];
+        }
+
+        [[maybe_unused]] const auto expected =
+            kirho::detail::csv_masks_scalar(block, ';');
+        [[maybe_unused]] const auto actual =
+            kirho::detail::select_csv_kernel()(block, ';');
+        assert(actual.quotes == expected.quotes);
+        assert(actual.delimiters == expected.delimiters);
+        assert(actual.newlines == expected.newlines);
+#if KIRHO_X86_SIMD
+        [[maybe_unused]] const auto sse2 =
+            kirho::detail::csv_masks_sse2(block, ';');
+        assert(sse2.quotes == expected.quotes);
+        assert(sse2.delimiters == expected.delimiters);
+        assert(sse2.newlines == expected.newlines);
+#endif
+    }
+
+    // Random files have to come out the same, whether they're read in one go
+    // or in chunks of any size.
+    const auto pieces = std::vector<std::string>{
+        "plain", "", "\"quoted\"", "\"with,comma\"", "\"with\nnewline\"",
+        "\"with \"\"quotes\"\"\"", std::string(70, 'z')
+    };
+
+    for (auto round = 0; round < 2000; round++)
+    {
+        auto text = std::string{};
+        auto expected = rows_t{};
+        const auto row_count = random() % 20;
+        for (auto i = 0u; i < row_count; i++)
+        {
+            auto& row = expected.emplace_back();
+            const auto field_count = 1 + random() % 5;
+            for (auto j = 0u; j < field_count; j++)
+            {
+                const auto& piece = pieces[random() % pieces.size()];
+                text += (j == 0 ? "" : ",") + piece;
+                row.push_back(
+                    piece.starts_with('"')
+                        ? piece.substr(1, piece.size() - 2)
+                        : piece
+                );
+            }
+            text += random() % 2 == 0 ? "\n" : "\r\n";
+        }
+
+        assert(read_all(text) == expected);
+
+        auto chunked = rows_t{};
+        auto reader = kirho::csv_reader_t{};
+        auto buffer = std::string{};
+        for (auto position = std::size_t{0}; position < text.size();)
+        {
+            const auto size = 1 + random() % 100;
+            buffer += text.substr(position, size);
+            position += size;
+
+            reader.reset(buffer, position >= text.size());
+            read_all(reader, chunked);
+            buffer.erase(0, reader.consumed());
+        }
+
+        assert(chunked == expected);
+    }
+}
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <kirho/encoding.hpp>
+
+using kirho::decode_error_t;
+using kind_t = kirho::decode_error_t::kind_t;
+
+auto bytes_of(std::string_view text) -> std::span<const std::byte>
+{
+    return std::as_bytes(std::span{text.data(), text.size()});
+}
+
+auto base64(std::string_view text) -> std::string
+{
+    auto encoded = std::string(kirho::base64::encoded_size(text.size()), '\0');
+    kirho::base64::encode(bytes_of(text), encoded);
+    return encoded;
+}
+
+auto unbase64(std::string_view text) -> std::string
+{
+    auto decoded = std::string(kirho::base64::decoded_size(text.size()), '\0');
+    const auto size =
+        kirho::base64::decode(text, std::as_writable_bytes(std::span{decoded}))
+            .unwrap();
+    decoded.resize(size);
+    return decoded;
+}
+
+auto base64_error(std::string_view text) -> decode_error_t
+{
+    auto buffer =
+        std::vector<std::byte>(kirho::base64::decoded_size(text.size()));
+    auto error = decode_error_t{};
+    [[maybe_unused]] const auto failed =
+        kirho::base64::decode(text, buffer).is_error(error);
+    assert(failed);
+    return error;
+}
+
+auto hex_error(std::string_view text) -> decode_error_t
+{
+    auto buffer = std::vector<std::byte>(kirho::hex::decoded_size(text.size()));
+    auto error = decode_error_t{};
+    [[maybe_unused]] const auto failed =
+        kirho::hex::decode(text, buffer).is_error(error);
+    assert(failed);
+    return error;
+}
+
+struct kernels_t
+{
+    kirho::detail::encode_kernel_t encode;
+    kirho::detail::decode_kernel_t decode;
+};
+
+// Every kernel has to agree with the scalar code on random data, with errors
+// dropped in at random places.
+auto check_kernels(
+    const std::vector<kernels_t>& kernels,
+    auto encode_with,
+    auto decode_with,
+    auto encoded_size,
+    auto decoded_size
+) -> void
+{
+    const auto scalar = kernels_t{
+        kirho::detail::scalar_encode_kernel,
+        kirho::detail::scalar_decode_kernel,
+    };
+
+    auto random = std::mt19937{42};
+    for (auto round = 0; round < 5000; round++)
+    {
+        auto data = std::vector<std::byte>(random() % 200);
+        for (auto& byte : data)
+        {
+            byte = static_cast<std::byte>(random());
+        }
+
+        auto expected = std::string(encoded_size(data.size()), '\0');
+        encode_with(scalar.encode, data, expected);
+        if (!expected.empty() && random() % 2 == 0)
+        {
+            expected[random() % expected.size()] = static_cast<char>(random());
+        }
+
+        auto expected_bytes =
+            std::vector<std::byte>(decoded_size(data.size() * 2));
+        auto expected_error = decode_error_t{};
+        const auto expected_result =
+            decode_with(scalar.decode, expected, expected_bytes);
+        const auto failed = expected_result.is_error(expected_error);
+
+        for (const auto& kernel : kernels)
+        {
+            auto encoded = std::string(encoded_size(data.size()), '\0');
+            encode_with(kernel.encode, data, encoded);
+            auto clean = std::string(encoded_size(data.size()), '\0');
+            encode_with(scalar.encode, data, clean);
+            assert(encoded == clean);
+
+            // Anything past the decoded data has to be left alone, even
+            // when there's plenty of room for the kernels to scribble on.
+            auto bytes = std::vector<std::byte>(
+                decoded_size(data.size() * 2) + 64, std::byte{0xA5}
+            );
+            [[maybe_unused]] auto error = decode_error_t{};
+            [[maybe_unused]] const auto result =
+                decode_with(kernel.decode, expected, bytes);
+            assert(result.is_error(error) == failed);
+            if (failed)
+            {
+                assert(error == expected_error);
+            }
+            else
+            {
+                [[maybe_unused]] const auto size =
+                    static_cast<std::ptrdiff_t>(expected_result.unwrap());
+                assert(result.unwrap() == expected_result.unwrap());
+                assert(std::equal(
+                    expected_bytes.begin(),
+                    expected_bytes.begin() + size,
+                    bytes.begin()
+                ));
+                assert(std::all_of(
+                    bytes.begin() + size,
+                    bytes.end(),
+                    [](std::byte byte) { return byte == std::byte{0xA5}; }
+                ));
+            }
+        }
+    }
+}
+
+auto main() -> int
+{
+    assert(base64("") == "");
+    assert(base64("f") == "Zg==");
+    assert(base64("fo") == "Zm8=");
+    assert(base64("foo") == "Zm9v");
+    assert(base64("foobar") == "Zm9vYmFy");
+
+    assert(unbase64("") == "");
+    assert(unbase64("Zg==") == "f");
+    assert(unbase64("Zg") == "f");
+    assert(unbase64("Zm8=") == "fo");
+    assert(unbase64("Zm9vYmFy") == "foobar");
+    assert(unbase64("+/+/") == "\xFB\xFF\xBF");
+
+    assert(
+        (base64_error("Zm9v!mFy") ==
+         decode_error_t{4, kind_t::invalid_character})
+    );
+    assert(
+        (base64_error("Zm9vY") == decode_error_t{5, kind_t::invalid_length})
+    );
+    assert(
+        (base64_error("Z=9v") == decode_error_t{1, kind_t::invalid_character})
+    );
+    assert(
+        (base64_error("Zg===") == decode_error_t{5, kind_t::invalid_length})
+    );
+
+    auto small = std::array<std::byte, 2>{};
+    [[maybe_unused]] auto error = decode_error_t{};
+    [[maybe_unused]] const auto overflowed =
+        kirho::base64::decode("Zm9v", small).is_error(error);
+    assert(overflowed && error.kind == kind_t::output_too_small);
+
+    auto hex = std::string(kirho::hex::encoded_size(4), '\0');
+    kirho::hex::encode(bytes_of("\x01\xAB\xFF\x10"), hex);
+    assert(hex == "01abff10");
+
+    auto decoded = std::array<std::byte, 2>{};
+    [[maybe_unused]] const auto size =
+        kirho::hex::decode("aBfF", decoded).unwrap();
+    assert(size == 2);
+    assert(decoded[0] == std::byte{0xAB} && decoded[1] == std::byte{0xFF});
+    assert((hex_error("abc") == decode_error_t{3, kind_t::invalid_length}));
+    assert((hex_error("0g") == decode_error_t{1, kind_t::invalid_character}));
+
+    auto base64_kernels = std::vector<kernels_t>{};
+    auto hex_kernels = std::vector<kernels_t>{};
+#if KIRHO_X86_SIMD
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        base64_kernels.push_back(
+            {kirho::detail::base64_encode_ssse3,
+             kirho::detail::base64_decode_ssse3}
+        );
+        hex_kernels.push_back(
+            {kirho::detail::hex_encode_ssse3, kirho::detail::hex_decode_ssse3}
+        );
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        base64_kernels.push_back(
+            {kirho::detail::base64_encode_avx2,
+             kirho::detail::base64_decode_avx2}
+        );
+        hex_kernels.push_back(
+            {kirho::detail::hex_encode_avx2, kirho::detail::hex_decode_avx2}
+        );
+    }
+#endif
+
+    check_kernels(
+        base64_kernels,
+        kirho::detail::base64_encode_with,
+        kirho::detail::base64_decode_with,
+        kirho::base64::encoded_size,
+        kirho::base64::decoded_size
+    );
+    check_kernels(
+        hex_kernels,
+        kirho::detail::hex_encode_with,
+        kirho::detail::hex_decode_with,
+        kirho::hex::encoded_size,
+        kirho::hex::decoded_size
+    );
+}
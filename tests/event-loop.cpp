@@ -0,0 +1,284 @@
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <kirho/event_loop.hpp>
+
+using kirho::detached_task_t;
+using kirho::event_loop_t;
+namespace sys = kirho::sys;
+
+constexpr auto round_trips = 10000;
+constexpr auto message_size = std::size_t{64};
+
+// Whether epoll should refuse to wait on anything more, which is hard to make
+// it do for real. Stopping waits still works.
+auto refuse_arming = false;
+
+extern "C" auto epoll_ctl(int epoll, int op, int fd, epoll_event* event)
+    noexcept -> int
+{
+    if (refuse_arming && op != EPOLL_CTL_DEL)
+    {
+        errno = ENOSPC;
+        return -1;
+    }
+
+    return static_cast<int>(::syscall(SYS_epoll_ctl, epoll, op, fd, event));
+}
+
+auto echo_server(event_loop_t& loop, const sys::fd_t& listener, int& served)
+    -> detached_task_t
+{
+    auto connection = (co_await loop.async_accept(listener)).unwrap();
+
+    auto buffer = std::array<std::byte, 256>{};
+    while (true)
+    {
+        const auto count = (co_await loop.async_read(connection, buffer))
+                               .except("echo server failed to read");
+        if (count == 0)
+        {
+            break;
+        }
+
+        auto written = std::size_t{0};
+        while (written < count)
+        {
+            written += (co_await loop.async_write(
+                            connection,
+                            std::span{buffer}.subspan(written, count - written)
+                        ))
+                           .except("echo server failed to write");
+        }
+
+        served += static_cast<int>(count);
+    }
+}
+
+auto echo_client(event_loop_t& loop, sys::fd_t socket, int& completed)
+    -> detached_task_t
+{
+    auto message = std::array<std::byte, message_size>{};
+    std::memset(message.data(), 'k', message.size());
+
+    for (auto i = 0; i < round_trips; i++)
+    {
+        (co_await loop.async_write(socket, message)).unwrap();
+
+        auto reply = std::array<std::byte, message_size>{};
+        auto received = std::size_t{0};
+        while (received < reply.size())
+        {
+            received += (co_await loop.async_read(
+                             socket, std::span{reply}.subspan(received)
+                         ))
+                            .unwrap();
+        }
+
+        assert(reply == message);
+        completed++;
+    }
+}
+
+auto sleeper(
+    event_loop_t& loop,
+    std::chrono::milliseconds duration,
+    std::chrono::milliseconds& slept
+) -> detached_task_t
+{
+    const auto start = std::chrono::steady_clock::now();
+    co_await loop.sleep_for(duration);
+    slept = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start
+    );
+}
+
+auto timed_reader(
+    event_loop_t& loop,
+    const sys::fd_t& fd,
+    kirho::deadline_t deadline,
+    kirho::stop_token_t token,
+    int& error
+) -> detached_task_t
+{
+    auto buffer = std::array<std::byte, 16>{};
+    auto failure = kirho::sys_error_t{};
+    if ((co_await loop.async_read(fd, buffer, deadline, std::move(token)))
+            .is_error(failure))
+    {
+        error = failure.code;
+    }
+}
+
+auto late_writer(event_loop_t& loop, const sys::fd_t& fd) -> detached_task_t
+{
+    co_await loop.sleep_for(std::chrono::milliseconds{5});
+    const auto byte = std::array<std::byte, 1>{std::byte{'k'}};
+    (co_await loop.async_write(fd, byte)).unwrap();
+}
+
+auto late_stopper(event_loop_t& loop, kirho::stop_source_t& source)
+    -> detached_task_t
+{
+    co_await loop.sleep_for(std::chrono::milliseconds{5});
+    source.request_stop();
+}
+
+// Reads a byte, and once it has one, stops anyone else that was woken up for
+// the same byte from going back to waiting.
+auto racing_reader(
+    event_loop_t& loop,
+    const sys::fd_t& fd,
+    int& read,
+    int& error
+) -> detached_task_t
+{
+    auto buffer = std::array<std::byte, 1>{};
+    auto failure = kirho::sys_error_t{};
+    if ((co_await loop.async_read(fd, buffer)).is_error(failure))
+    {
+        error = failure.code;
+        co_return;
+    }
+
+    read++;
+    refuse_arming = true;
+}
+
+auto make_pipe() -> std::array<sys::fd_t, 2>
+{
+    auto fds = std::array<int, 2>{};
+    [[maybe_unused]] const auto created = pipe(fds.data());
+    assert(created == 0);
+
+    auto ends = std::array<sys::fd_t, 2>{sys::fd_t{fds[0]}, sys::fd_t{fds[1]}};
+    sys::set_nonblocking(ends[0]).unwrap();
+    sys::set_nonblocking(ends[1]).unwrap();
+    return ends;
+}
+
+auto main() -> int
+{
+    auto loop = event_loop_t::create().except("failed to create the loop");
+
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    std::snprintf(
+        address.sun_path,
+        sizeof(address.sun_path),
+        "/tmp/kirho-event-loop-%d",
+        static_cast<int>(getpid())
+    );
+    unlink(address.sun_path);
+    defer(address, unlink(address.sun_path));
+
+    const auto listener = sys::fd_t{socket(AF_UNIX, SOCK_STREAM, 0)};
+    const auto generic_address = reinterpret_cast<const sockaddr*>(&address);
+    [[maybe_unused]] const auto bound =
+        bind(listener.get(), generic_address, sizeof(address));
+    assert(bound == 0);
+    [[maybe_unused]] const auto listening = listen(listener.get(), 1);
+    assert(listening == 0);
+    sys::set_nonblocking(listener).unwrap();
+
+    auto client = sys::fd_t{socket(AF_UNIX, SOCK_STREAM, 0)};
+    [[maybe_unused]] const auto connected =
+        connect(client.get(), generic_address, sizeof(address));
+    assert(connected == 0);
+    sys::set_nonblocking(client).unwrap();
+
+    auto served = 0;
+    auto completed = 0;
+    auto sleeps = std::array<std::chrono::milliseconds, 100>{};
+
+    echo_server(loop, listener, served);
+    echo_client(loop, std::move(client), completed);
+    for (auto i = std::size_t{0}; i < sleeps.size(); i++)
+    {
+        sleeper(loop, std::chrono::milliseconds{i * 3}, sleeps[i]);
+    }
+    loop.run().except("the event loop failed");
+
+    assert(completed == round_trips);
+    assert(served == round_trips * static_cast<int>(message_size));
+    for (auto i = std::size_t{0}; i < sleeps.size(); i++)
+    {
+        assert(sleeps[i] >= std::chrono::milliseconds{i * 3});
+    }
+
+    // Reads that take too long are given up on, and the ones that don't are
+    // left alone, without their timers keeping the loop around.
+    const auto quiet = make_pipe();
+    const auto busy = make_pipe();
+    auto timed_out = 0;
+    auto on_time = 0;
+    auto cancelled = 0;
+    auto source = kirho::stop_source_t{};
+    source.request_stop();
+
+    [[maybe_unused]] const auto start = std::chrono::steady_clock::now();
+    timed_reader(
+        loop,
+        quiet[0],
+        kirho::deadline_t::after(std::chrono::milliseconds{20}),
+        {},
+        timed_out
+    );
+    timed_reader(
+        loop,
+        busy[0],
+        kirho::deadline_t::after(std::chrono::seconds{10}),
+        {},
+        on_time
+    );
+    late_writer(loop, busy[1]);
+    timed_reader(
+        loop, quiet[0], kirho::deadline_t::never(), source.token(), cancelled
+    );
+    loop.run().except("the event loop failed");
+
+    assert(timed_out == ETIMEDOUT);
+    assert(on_time == 0);
+    assert(cancelled == ECANCELED);
+    assert(std::chrono::steady_clock::now() - start >=
+           std::chrono::milliseconds{20});
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds{5});
+
+    // Reads that are already waiting notice when they are asked to stop,
+    // even though nothing else would wake the loop up.
+    auto stopped = 0;
+    auto later = kirho::stop_source_t{};
+    timed_reader(
+        loop, quiet[0], kirho::deadline_t::never(), later.token(), stopped
+    );
+    late_stopper(loop, later);
+    loop.run().except("the event loop failed");
+    assert(stopped == ECANCELED);
+
+    // Two reads are woken up for the same byte, and the one that misses out
+    // can't wait again, so it gets the reason why.
+    const auto contested = make_pipe();
+    const auto duplicate = sys::fd_t{dup(contested[0].get())};
+    auto read = 0;
+    auto failed = -1;
+    racing_reader(loop, contested[0], read, failed);
+    racing_reader(loop, duplicate, read, failed);
+    const auto byte = char{'k'};
+    [[maybe_unused]] const auto written = write(contested[1].get(), &byte, 1);
+    assert(written == 1);
+    loop.run().except("the event loop failed");
+    refuse_arming = false;
+    assert(read == 1);
+    assert(failed == ENOSPC);
+}
@@ -0,0 +1,229 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <kirho/generator.hpp>
+#include <kirho/parse.hpp>
+
+using number_t = kirho::result_t<int, kirho::parse_error_t>;
+using count_t = kirho::result_t<std::uint64_t, int>;
+
+// Parses one number per line, as the lines are asked for.
+auto numbers(std::string_view text) -> kirho::generator_t<number_t>
+{
+    while (!text.empty())
+    {
+        const auto end = text.find('\n');
+        co_yield kirho::parse<int>(text.substr(0, end));
+        text = end == std::string_view::npos ? "" : text.substr(end + 1);
+    }
+}
+
+auto count_to(std::uint64_t limit, int& produced)
+    -> kirho::generator_t<count_t>
+{
+    for (auto i = std::uint64_t{0}; i < limit; i++)
+    {
+        produced++;
+        co_yield count_t::success(i);
+    }
+}
+
+// Hands out the address of the item that it yields, so that we can tell
+// whether it was copied.
+auto in_place(const count_t*& address) -> kirho::generator_t<count_t>
+{
+    auto item = count_t::success(7);
+    address = &item;
+    co_yield item;
+}
+
+auto throwing() -> kirho::generator_t<count_t>
+{
+    co_yield count_t::success(1);
+    throw std::runtime_error{"broken"};
+}
+
+// Counts how many frames it hands out, and how many are given back.
+template <typename T>
+struct counting_allocator_t
+{
+    using value_type = T;
+
+    explicit counting_allocator_t(int& p_live) noexcept : live{&p_live}
+    {
+    }
+
+    template <typename U>
+    counting_allocator_t(const counting_allocator_t<U>& other) noexcept
+        : live{other.live}
+    {
+    }
+
+    auto allocate(std::size_t n) -> T*
+    {
+        (*live)++;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    auto deallocate(T* pointer, std::size_t n) noexcept -> void
+    {
+        (*live)--;
+        std::allocator<T>{}.deallocate(pointer, n);
+    }
+
+    auto operator==(const counting_allocator_t&) const noexcept
+        -> bool = default;
+
+    int* live;
+};
+
+using allocated_t =
+    kirho::generator_t<count_t, counting_allocator_t<std::byte>>;
+
+// Older versions of GCC don't see that a templated operator new goes with the
+// usual operator delete, which is what every coroutine frame is freed with.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 14
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+auto allocated(std::allocator_arg_t, counting_allocator_t<std::byte>, int n)
+    -> allocated_t
+{
+    for (auto i = 0; i < n; i++)
+    {
+        co_yield count_t::success(static_cast<std::uint64_t>(i));
+    }
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 14
+#pragma GCC diagnostic pop
+#endif
+
+auto main() -> int
+{
+    // Every line comes out as its own result, errors included.
+    {
+        auto values = std::vector<int>{};
+        auto errors = 0;
+        for (auto& number : numbers("1\n22\nx\n333"))
+        {
+            auto value = 0;
+            if (number.is_success(value))
+            {
+                values.push_back(value);
+            }
+            else
+            {
+                errors++;
+            }
+        }
+        assert((values == std::vector<int>{1, 22, 333}));
+        assert(errors == 1);
+    }
+
+    // Or the iteration stops at the first error, which is the last item.
+    {
+        auto values = std::vector<int>{};
+        [[maybe_unused]] auto last = kirho::parse_error_t{};
+        for (auto& number : numbers("1\n22\nx\n333").stop_at_error())
+        {
+            auto value = 0;
+            if (number.is_success(value))
+            {
+                values.push_back(value);
+            }
+            else
+            {
+                [[maybe_unused]] const auto failed = number.is_error(last);
+                assert(failed);
+            }
+        }
+        assert((values == std::vector<int>{1, 22}));
+        assert(last.kind == kirho::parse_error_t::kind_t::invalid_character);
+    }
+
+    // Nothing is produced before it's asked for, or after the iteration
+    // stops.
+    {
+        auto produced = 0;
+        auto generator = count_to(1000, produced);
+        assert(produced == 0);
+        for (auto& item : generator)
+        {
+            if (item.unwrap() == 4)
+            {
+                break;
+            }
+        }
+        assert(produced == 5);
+    }
+
+    // Items are handed out right where they were yielded.
+    {
+        const count_t* address = nullptr;
+        auto generator = in_place(address);
+        auto it = generator.begin();
+        assert(it != generator.end());
+        assert(&*it == address);
+        assert(it->unwrap() == 7);
+        ++it;
+        assert(it == generator.end());
+    }
+
+    // Exceptions come out of the iterator.
+    {
+        auto generator = throwing();
+        auto it = generator.begin();
+        [[maybe_unused]] auto threw = false;
+        try
+        {
+            ++it;
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+        assert(it == generator.end());
+    }
+
+    // Frames come from the allocator, and go back to it, even when the
+    // coroutine is left unfinished.
+    {
+        auto live = 0;
+        {
+            auto generator = allocated(
+                std::allocator_arg, counting_allocator_t<std::byte>{live}, 10
+            );
+            assert(live == 1);
+            auto sum = std::uint64_t{0};
+            for (auto& item : generator)
+            {
+                sum += item.unwrap();
+                if (sum > 10)
+                {
+                    break;
+                }
+            }
+            assert(sum == 15);
+        }
+        assert(live == 0);
+    }
+
+    // Generators can be moved around before they are iterated over.
+    {
+        auto produced = 0;
+        auto generator = count_to(3, produced);
+        auto moved = std::move(generator);
+        auto sum = std::uint64_t{0};
+        for (auto& item : moved)
+        {
+            sum += item.unwrap();
+        }
+        assert(sum == 3 && produced == 3);
+    }
+}
@@ -0,0 +1,75 @@
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <kirho/iovec_builder.hpp>
+
+namespace sys = kirho::sys;
+
+auto main() -> int
+{
+    auto ends = std::array<int, 2>{};
+    [[maybe_unused]] const auto created = pipe(ends.data());
+    assert(created == 0);
+    auto reader = sys::fd_t{ends[0]};
+    auto writer = sys::fd_t{ends[1]};
+
+    // Way more than a pipe can hold, so that writev has to stop partway
+    // through a buffer at least once.
+    const auto header = std::string_view{"HTTP/1.1 200 OK\r\n\r\n"};
+    const auto body = std::vector<std::byte>(1 << 20, std::byte{'k'});
+    const auto footer = std::string{"\r\nthe end"};
+
+    // Empty buffers are skipped, and anything past the fourth one doesn't
+    // fit.
+    auto builder = kirho::iovec_builder_t<4>{};
+    [[maybe_unused]] const auto added = std::array{
+        builder.add(header),
+        builder.add(std::string_view{}),
+        builder.add(body),
+        builder.add(footer),
+        builder.add(header),
+        builder.add(footer),
+    };
+    assert((added == std::array{true, true, true, true, true, false}));
+    assert(builder.buffers().size() == 4);
+
+    [[maybe_unused]] const auto expected_size =
+        2 * header.size() + body.size() + footer.size();
+    assert(builder.size() == expected_size);
+
+    auto received = std::string{};
+    auto consumer = std::thread{[&]() {
+        auto chunk = std::array<std::byte, 4096>{};
+        while (true)
+        {
+            const auto count = sys::read(reader, chunk).unwrap();
+            if (count == 0)
+            {
+                break;
+            }
+
+            received.append(reinterpret_cast<const char*>(chunk.data()), count);
+        }
+    }};
+
+    [[maybe_unused]] const auto written =
+        builder.write_to(writer).except("writev failed");
+    assert(written == expected_size);
+    assert(builder.size() == 0);
+    assert(builder.buffers().empty());
+
+    sys::close(writer).unwrap();
+    consumer.join();
+
+    const auto expected = std::string{header} +
+                          std::string(body.size(), 'k') + footer +
+                          std::string{header};
+    assert(received == expected);
+}
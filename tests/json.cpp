@@ -0,0 +1,174 @@
+#include <cassert>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <kirho/json.hpp>
+
+using kirho::json_document_t;
+using kirho::json_error_t;
+using kind_t = kirho::json_error_t::kind_t;
+
+auto error_of(std::string_view text) -> json_error_t
+{
+    auto error = json_error_t{};
+    [[maybe_unused]] const auto failed =
+        json_document_t::parse(text).is_error(error);
+    assert(failed);
+    return error;
+}
+
+auto parses(std::string_view text) -> bool
+{
+    auto error = json_error_t{};
+    return !json_document_t::parse(text).is_error(error);
+}
+
+auto main() -> int
+{
+    const auto text = std::string_view{R"({
+        "name": "sensor \"A\"",
+        "id": 12345678901,
+        "ratio": -1.5e3,
+        "on": true,
+        "off": false,
+        "nothing": null,
+        "tags": ["a", "b\u00e9\ud83d\ude00", []],
+        "nested": {"deep": {"value": 7}},
+        "big": 18446744073709551615
+    })"};
+
+    const auto document = json_document_t::parse(text).unwrap();
+    const auto root = document.root();
+    assert(root.type() == kirho::json_type_t::object);
+    assert(root.get_object().unwrap().size() == 9);
+
+    assert(
+        root.find_field("name").unwrap().get_string().unwrap() ==
+        "sensor \"A\""
+    );
+    assert(root.find_field("id").unwrap().get_int64().unwrap() == 12345678901);
+    assert(root.find_field("ratio").unwrap().get_double().unwrap() == -1500.0);
+    assert(root.find_field("on").unwrap().get_bool().unwrap());
+    assert(!root.find_field("off").unwrap().get_bool().unwrap());
+    assert(root.find_field("nothing").unwrap().is_null());
+    assert(
+        root.find_field("nested").unwrap().find_field("deep").unwrap().raw() ==
+        R"({"value": 7})"
+    );
+    assert(
+        root.find_field("big").unwrap().get_uint64().unwrap() ==
+        18446744073709551615u
+    );
+
+    // Strings without escapes point straight into the text.
+    const auto tags = root.find_field("tags").unwrap().get_array().unwrap();
+    assert(tags.size() == 3);
+    [[maybe_unused]] const auto a = tags.at(0).unwrap().get_string().unwrap();
+    assert(a == "a" && a.data() > text.data() && a.data() < text.end());
+    assert(tags.at(1).unwrap().get_string().unwrap() == "bé\U0001F600");
+    assert(tags.at(2).unwrap().get_array().unwrap().size() == 0);
+
+    [[maybe_unused]] auto error = json_error_t{};
+    assert(root.find_field("missing").is_error(error));
+    assert(error.kind == kind_t::no_such_field);
+    assert(tags.at(3).is_error(error));
+    assert(error.kind == kind_t::index_out_of_range);
+    assert(root.find_field("name").unwrap().get_int64().is_error(error));
+    assert(error.kind == kind_t::incorrect_type);
+    assert(root.find_field("ratio").unwrap().get_int64().is_error(error));
+    assert(error.kind == kind_t::incorrect_type);
+    assert(root.find_field("big").unwrap().get_int64().is_error(error));
+    assert(error.kind == kind_t::number_out_of_range);
+
+    const auto numbers = json_document_t::parse("[01, 1., -, 1e, 2]").unwrap();
+    for (const auto number : numbers.root().get_array().unwrap())
+    {
+        [[maybe_unused]] const auto outcome = number.get_double();
+        assert(outcome.is_error(error) == (number.raw() != "2"));
+        assert(number.raw() == "2" || error.kind == kind_t::invalid_number);
+    }
+
+    const auto escapes = json_document_t::parse(R"(["\x", "\ud800"])").unwrap();
+    const auto escape_array = escapes.root().get_array().unwrap();
+    for ([[maybe_unused]] const auto escape : escape_array)
+    {
+        assert(escape.get_string().is_error(error));
+        assert(error.kind == kind_t::invalid_escape);
+    }
+
+    [[maybe_unused]] constexpr auto unexpected = kind_t::unexpected_character;
+    assert(parses("0"));
+    assert(parses(" \"\\\\\" "));
+    assert(parses("[[], {}, [{}]]"));
+    assert((error_of("") == json_error_t{0, kind_t::unexpected_end}));
+    assert((error_of("[1, 2") == json_error_t{5, kind_t::unexpected_end}));
+    assert((error_of("[1 2]") == json_error_t{3, unexpected}));
+    assert((error_of("[1,]") == json_error_t{3, unexpected}));
+    assert((error_of("{\"a\" 1}") == json_error_t{5, unexpected}));
+    assert((error_of("{1: 2}") == json_error_t{1, unexpected}));
+    assert((error_of("[}") == json_error_t{1, unexpected}));
+    assert((error_of("\"a\"b") == json_error_t{3, unexpected}));
+    assert((error_of("[tru]") == json_error_t{1, unexpected}));
+    assert((error_of("{} {}") == json_error_t{3, unexpected}));
+    assert(
+        (error_of("[\"a\\\"]") ==
+         json_error_t{1, kind_t::unterminated_string})
+    );
+
+    // Control characters have to be escaped inside of strings, but are fine
+    // as whitespace outside of them, even past the first block.
+    [[maybe_unused]] const auto control = kind_t::control_character;
+    assert(parses("[\n\"a\\n\\u0000\"\t]"));
+    assert((error_of("[\"a\nb\"]") == json_error_t{3, control}));
+    assert((error_of("\"\t\"") == json_error_t{1, control}));
+    assert(
+        (error_of(std::string_view{"[\"\0\"]", 5}) == json_error_t{2, control})
+    );
+    const auto late = std::string(70, ' ') + "\"ok\x1f\"";
+    assert((error_of(late) == json_error_t{73, control}));
+
+    // Every kernel has to find the same characters as the scalar one.
+    auto random = std::mt19937{42};
+    for (auto round = 0; round < 1000; round++)
+    {
+        char block[64];
+        for (auto& byte : block)
+        {
+            byte = "a \"\\{}[]:,\n\t\rZ\x01\xe9"[random() % 16];
+        }
+
+        [[maybe_unused]] const auto expected =
+            kirho::detail::json_masks_scalar(block);
+        auto kernels = std::vector<kirho::detail::json_kernel_t>{
+            kirho::detail::select_json_kernel()
+        };
+#if KIRHO_X86_SIMD
+        kernels.push_back(kirho::detail::json_masks_sse2);
+#endif
+        for (const auto kernel : kernels)
+        {
+            [[maybe_unused]] const auto actual = kernel(block);
+            assert(actual.quotes == expected.quotes);
+            assert(actual.backslashes == expected.backslashes);
+            assert(actual.whitespace == expected.whitespace);
+            assert(actual.operators == expected.operators);
+            assert(actual.controls == expected.controls);
+        }
+    }
+
+    // Escapes that run across the edges of blocks.
+    for (auto padding = 0; padding < 70; padding++)
+    {
+        auto escaped = std::string{"["};
+        escaped.append(padding, ' ');
+        escaped += R"("\\\"\\", "x\\\\", 1])";
+        const auto document = json_document_t::parse(escaped).unwrap();
+        [[maybe_unused]] const auto array =
+            document.root().get_array().unwrap();
+        assert(array.at(0).unwrap().get_string().unwrap() == "\\\"\\");
+        assert(array.at(1).unwrap().get_string().unwrap() == "x\\\\");
+        assert(array.at(2).unwrap().get_int64().unwrap() == 1);
+    }
+}
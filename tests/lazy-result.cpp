@@ -0,0 +1,101 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kirho/lazy_result.hpp>
+
+using lazy_t = kirho::lazy_result_t<std::string, int>;
+using result_t = kirho::result_t<std::string, int>;
+
+auto main() -> int
+{
+    // However many threads ask at once, the function only runs once, and they
+    // all see the same value.
+    auto calls = std::atomic<int>{0};
+    auto lazy = lazy_t{[&calls]() {
+        calls++;
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        return result_t::success("configured");
+    }};
+    assert(!lazy.is_ready());
+
+    auto threads = std::vector<std::thread>{};
+    auto seen = std::atomic<int>{0};
+    for (auto i = 0; i < 8; i++)
+    {
+        threads.emplace_back([&]() {
+            const auto& value = lazy.get().unwrap().get();
+            if (value == "configured")
+            {
+                seen++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    assert(calls == 1);
+    assert(seen == 8);
+    assert(lazy.is_ready());
+    assert(&lazy.get().unwrap().get() == &lazy.get().unwrap().get());
+
+    // Errors are kept by default.
+    auto failures = 0;
+    auto cached = lazy_t{[&failures]() {
+        failures++;
+        return result_t::error(42);
+    }};
+    [[maybe_unused]] auto error = 0;
+    for (auto i = 0; i < 2; i++)
+    {
+        [[maybe_unused]] const auto failed = cached.get().is_error(error);
+        assert(failed && error == 42);
+    }
+    assert(failures == 1);
+
+    // Or the function can be run again after it fails.
+    auto attempts = 0;
+    auto retried = lazy_t{
+        [&attempts]() {
+            attempts++;
+            return attempts < 3 ? result_t::error(attempts)
+                                : result_t::success("third time");
+        },
+        lazy_t::error_policy_t::retry
+    };
+    for (auto i = 1; i < 3; i++)
+    {
+        [[maybe_unused]] const auto failed = retried.get().is_error(error);
+        assert(failed && error == i);
+    }
+    [[maybe_unused]] const auto& third = retried.get().unwrap().get();
+    assert(third == "third time");
+    assert(&retried.get().unwrap().get() == &third);
+    assert(attempts == 3);
+
+    // A function that throws leaves the cell as it was.
+    auto throws = true;
+    auto thrower = lazy_t{[&throws]() {
+        if (throws)
+        {
+            throw 1;
+        }
+        return result_t::success("fine");
+    }};
+    try
+    {
+        thrower.get();
+        assert(false);
+    }
+    catch (int)
+    {
+    }
+    throws = false;
+    [[maybe_unused]] const auto& fine = thrower.get().unwrap().get();
+    assert(fine == "fine");
+}
@@ -0,0 +1,39 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+#include <unistd.h>
+
+#include <kirho/mapped_file.hpp>
+
+using kirho::mapped_file_t;
+using kirho::sys_error_t;
+
+auto main() -> int
+{
+    char path[] = "/tmp/kirho-mapped-file-XXXXXX";
+    const auto fd = mkstemp(path);
+    assert(fd >= 0);
+    defer(path, unlink(path));
+
+    const auto contents = std::string_view{"hello from the page cache"};
+    [[maybe_unused]] const auto written =
+        write(fd, contents.data(), contents.size());
+    assert(written == static_cast<ssize_t>(contents.size()));
+    close(fd);
+
+    auto file = mapped_file_t::open(path).except("failed to map the file");
+    assert(file.view() == contents);
+    assert(file.bytes().size() == contents.size());
+
+    file.advise(mapped_file_t::advice_t::sequential).except("madvise failed");
+
+    auto moved = std::move(file);
+    assert(file.size() == 0);
+    assert(moved.view() == contents);
+
+    [[maybe_unused]] auto error = sys_error_t{};
+    assert(mapped_file_t::open("/this/does/not/exist").is_error(error));
+    assert(error.code == ENOENT);
+}
@@ -0,0 +1,141 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kirho/memoize.hpp>
+
+using result_t = kirho::result_t<int, std::string>;
+
+auto main() -> int
+{
+    // Calling it again with the same arguments doesn't call the function.
+    auto calls = 0;
+    auto square = kirho::memoize([&calls](int x) {
+        calls++;
+        return x < 0 ? result_t::error("negative") : result_t::success(x * x);
+    });
+    assert(square(3).unwrap() == 9);
+    assert(square(3).unwrap() == 9);
+    assert(square(4).unwrap() == 16);
+    assert(calls == 2);
+    assert(square.size() == 2);
+
+    // Errors aren't kept by default.
+    auto error = std::string{};
+    assert(square(-1).is_error(error) && error == "negative");
+    assert(square(-1).is_error(error) && error == "negative");
+    assert(calls == 4);
+
+    // But they can be.
+    auto negative = kirho::memoize_options_t{};
+    negative.error_ttl = std::chrono::hours{1};
+    auto errors = 0;
+    auto checked = kirho::memoize(
+        [&errors](int x) {
+            errors++;
+            return result_t::error("no " + std::to_string(x));
+        },
+        negative
+    );
+    assert(checked(7).is_error(error) && error == "no 7");
+    assert(checked(7).is_error(error) && error == "no 7");
+    assert(errors == 1);
+
+    // Results expire.
+    auto short_lived = kirho::memoize_options_t{};
+    short_lived.success_ttl = std::chrono::milliseconds{20};
+    auto expiring_calls = 0;
+    auto expiring = kirho::memoize(
+        [&expiring_calls](int x) {
+            expiring_calls++;
+            return result_t::success(x);
+        },
+        short_lived
+    );
+    assert(expiring(1).unwrap() == 1);
+    assert(expiring(1).unwrap() == 1);
+    assert(expiring_calls == 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds{40});
+    assert(expiring(1).unwrap() == 1);
+    assert(expiring_calls == 2);
+
+    // It never holds more than it was told to, and the results that keep
+    // being used stay in it.
+    auto small = kirho::memoize_options_t{};
+    small.capacity = 4;
+    small.shards = 1;
+    auto bounded_calls = 0;
+    auto bounded = kirho::memoize(
+        [&bounded_calls](int x) {
+            bounded_calls++;
+            return result_t::success(x + 1);
+        },
+        small
+    );
+    for (auto i = 0; i < 100; i++)
+    {
+        assert(bounded(0).unwrap() == 1);
+        assert(bounded(i + 1).unwrap() == i + 2);
+        assert(bounded.size() <= 4);
+    }
+    assert(bounded_calls == 101);
+
+    // The arguments can be anything that can be hashed.
+    auto lengths = kirho::memoize([](const std::string& text, int times) {
+        return result_t::success(static_cast<int>(text.size()) * times);
+    });
+    assert(lengths(std::string{"abc"}, 2).unwrap() == 6);
+    assert(lengths(std::string{"abcd"}, 2).unwrap() == 8);
+
+    // When many threads miss on the same key at once, the function only runs
+    // once.
+    auto slow_calls = std::atomic<int>{0};
+    auto slow = kirho::memoize([&slow_calls](int x) {
+        slow_calls++;
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        return result_t::success(x * 2);
+    });
+    auto threads = std::vector<std::thread>{};
+    auto seen = std::atomic<int>{0};
+    for (auto i = 0; i < 8; i++)
+    {
+        threads.emplace_back([&]() {
+            if (slow(21).unwrap() == 42)
+            {
+                seen++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    assert(slow_calls == 1);
+    assert(seen == 8);
+
+    // A function that throws doesn't leave anything behind.
+    auto throws = true;
+    auto thrower = kirho::memoize([&throws](int x) {
+        if (throws)
+        {
+            throw 1;
+        }
+        return result_t::success(x);
+    });
+    try
+    {
+        thrower(5);
+        assert(false);
+    }
+    catch (int)
+    {
+    }
+    throws = false;
+    assert(thrower(5).unwrap() == 5);
+
+    square.clear();
+    assert(square.size() == 0);
+}
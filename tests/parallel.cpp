@@ -0,0 +1,191 @@
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kirho/parallel.hpp>
+
+using sum_t = kirho::result_t<std::uint64_t, std::string>;
+using real_t = kirho::result_t<double, std::string>;
+using status_t = kirho::status_t<std::string>;
+
+auto main() -> int
+{
+    auto pool = kirho::thread_pool_t{4};
+
+    auto numbers = std::vector<std::uint64_t>(1000000);
+    std::iota(numbers.begin(), numbers.end(), std::uint64_t{1});
+    const auto add = [](std::uint64_t sum, std::uint64_t value) {
+        return sum_t::success(sum + value);
+    };
+
+    // Everything is added up, however the range is split.
+    for (const auto size : {std::size_t{0}, std::size_t{1}, std::size_t{7},
+                            std::size_t{1000}, numbers.size()})
+    {
+        const auto part = std::vector<std::uint64_t>(
+            numbers.begin(), numbers.begin() + static_cast<long>(size)
+        );
+        const auto sum =
+            kirho::parallel_try_reduce(pool, part, std::uint64_t{0}, add);
+        assert(sum.unwrap() == size * (size + 1) / 2);
+    }
+
+    // The chunks are always combined in the same order, so even floating
+    // point sums come out the same every time.
+    {
+        auto reals = std::vector<double>(100000);
+        for (auto i = std::size_t{0}; i < reals.size(); i++)
+        {
+            reals[i] = 1.0 / static_cast<double>(i + 1);
+        }
+
+        const auto add_real = [](double sum, double value) {
+            return real_t::success(sum + value);
+        };
+        [[maybe_unused]] const auto first =
+            kirho::parallel_try_reduce(pool, reals, 0.0, add_real).unwrap();
+        for (auto i = 0; i < 20; i++)
+        {
+            [[maybe_unused]] const auto again =
+                kirho::parallel_try_reduce(pool, reals, 0.0, add_real)
+                    .unwrap();
+            assert(again == first);
+        }
+    }
+
+    // The accumulator doesn't have to be the same type as the elements, as
+    // long as there's a way to combine two of them.
+    {
+        const auto words = std::vector<std::string>{"a", "bb", "ccc", "dddd"};
+        const auto length = kirho::parallel_try_reduce(
+            pool,
+            words,
+            std::uint64_t{0},
+            [](std::uint64_t total, const std::string& word) {
+                return sum_t::success(total + word.size());
+            },
+            add
+        );
+        assert(length.unwrap() == 10);
+    }
+
+    // The first error stops everything, and comes back out.
+    {
+        auto visited = std::atomic<std::uint64_t>{0};
+        const auto checked = [&visited](std::uint64_t sum, std::uint64_t n) {
+            visited.fetch_add(1, std::memory_order_relaxed);
+            if (n == 1000)
+            {
+                return sum_t::error("bad record " + std::to_string(n));
+            }
+
+            return sum_t::success(sum + n);
+        };
+
+        auto error = std::string{};
+        const auto sum = kirho::parallel_try_reduce(
+            pool, numbers, std::uint64_t{0}, checked
+        );
+        assert(sum.is_error(error));
+        assert(error == "bad record 1000");
+        assert(visited < numbers.size());
+    }
+
+    // A failing combination counts as well.
+    {
+        const auto sum = kirho::parallel_try_reduce(
+            pool,
+            numbers,
+            std::uint64_t{0},
+            add,
+            [](std::uint64_t, std::uint64_t) {
+                return sum_t::error("can't combine");
+            }
+        );
+        auto error = std::string{};
+        assert(sum.is_error(error) && error == "can't combine");
+    }
+
+    // parallel_for finds every failure, not just the first one.
+    {
+        auto visited = std::vector<std::atomic<int>>(100000);
+        const auto outcome = kirho::parallel_for(
+            pool,
+            visited.size(),
+            1000,
+            [&visited](std::size_t i) {
+                visited[i]++;
+                if (i % 7919 == 0)
+                {
+                    return status_t::error("bad " + std::to_string(i));
+                }
+
+                return status_t::success();
+            }
+        );
+
+        auto errors = std::vector<std::pair<std::size_t, std::string>>{};
+        [[maybe_unused]] const auto failed = outcome.is_error(errors);
+        assert(failed && errors.size() == 13);
+        for (auto i = std::size_t{0}; i < errors.size(); i++)
+        {
+            assert(errors[i].first == i * 7919);
+            assert(errors[i].second == "bad " + std::to_string(i * 7919));
+        }
+        for ([[maybe_unused]] const auto& count : visited)
+        {
+            assert(count == 1);
+        }
+    }
+
+    // Up to a point, after which it stops.
+    {
+        auto calls = std::atomic<std::size_t>{0};
+        auto errors = std::vector<std::pair<std::size_t, std::string>>{};
+        const auto outcome = kirho::parallel_for(
+            pool,
+            1000000,
+            100,
+            [&calls](std::size_t) {
+                calls++;
+                return status_t::error("bad");
+            },
+            10
+        );
+        [[maybe_unused]] const auto failed = outcome.is_error(errors);
+        assert(failed && errors.size() == 10);
+        assert(calls < 1000000);
+    }
+
+    // Every thread gets its own arena, which is reset before every chunk.
+    {
+        const auto outcome = kirho::parallel_for(
+            pool,
+            10000,
+            100,
+            [](std::size_t i, kirho::arena_t& arena) {
+                if (i % 100 == 0 && arena.used() != 0)
+                {
+                    return status_t::error("arena wasn't reset");
+                }
+
+                auto scratch = std::pmr::vector<std::size_t>{&arena};
+                scratch.assign(64, i);
+                return status_t::success();
+            }
+        );
+        assert(outcome.to_optional().has_value());
+    }
+
+    // Nothing to do is fine.
+    const auto nothing = kirho::parallel_for(pool, 0, 10, [](std::size_t) {
+        return status_t::error("called");
+    });
+    assert(nothing.to_optional().has_value());
+}
@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include <kirho/parse.hpp>
+
+using kirho::parse;
+using kirho::parse_error_t;
+using kind_t = kirho::parse_error_t::kind_t;
+
+template <typename T>
+auto error_of(std::string_view text) -> parse_error_t
+{
+    auto error = parse_error_t{};
+    [[maybe_unused]] const auto failed = parse<T>(text).is_error(error);
+    assert(failed);
+    return error;
+}
+
+auto main() -> int
+{
+    assert(parse<std::int64_t>("0").unwrap() == 0);
+    assert(parse<std::int64_t>("-42").unwrap() == -42);
+    assert(parse<std::int64_t>("1234567890123").unwrap() == 1234567890123);
+    assert(
+        parse<std::int64_t>("9223372036854775807").unwrap() ==
+        std::numeric_limits<std::int64_t>::max()
+    );
+    assert(
+        parse<std::int64_t>("-9223372036854775808").unwrap() ==
+        std::numeric_limits<std::int64_t>::min()
+    );
+    assert(parse<std::uint32_t>("4294967295").unwrap() == 4294967295u);
+    assert(parse<std::uint64_t>("18446744073709551615").unwrap() == ~0ull);
+    assert(parse<std::int8_t>("-128").unwrap() == -128);
+    assert(parse<double>("3.25").unwrap() == 3.25);
+    assert(parse<double>("-1e10").unwrap() == -1e10);
+
+    [[maybe_unused]] constexpr auto invalid = kind_t::invalid_character;
+    [[maybe_unused]] constexpr auto overflow = kind_t::overflow;
+
+    assert((error_of<int>("") == parse_error_t{0, kind_t::empty}));
+    assert((error_of<int>("-") == parse_error_t{0, invalid}));
+    assert((error_of<int>("-x") == parse_error_t{1, invalid}));
+    assert((error_of<unsigned>("-1") == parse_error_t{0, invalid}));
+    assert((error_of<std::int64_t>("12345678x9") == parse_error_t{8, invalid}));
+    assert((error_of<double>("1.5z") == parse_error_t{3, invalid}));
+    assert(
+        (error_of<std::uint32_t>("4294967296") == parse_error_t{0, overflow})
+    );
+    assert((error_of<std::int8_t>("-129") == parse_error_t{0, overflow}));
+    assert(
+        (error_of<std::int64_t>("9223372036854775808") ==
+         parse_error_t{0, overflow})
+    );
+    assert(
+        (error_of<std::uint64_t>("100000000000000000000") ==
+         parse_error_t{0, overflow})
+    );
+    assert((error_of<double>("1e999") == parse_error_t{0, overflow}));
+    assert((error_of<double>("-1e999") == parse_error_t{0, overflow}));
+
+    // Numbers that are too close to zero aren't too big.
+    [[maybe_unused]] constexpr auto underflow = kind_t::underflow;
+    assert((error_of<double>("1e-400") == parse_error_t{0, underflow}));
+    assert((error_of<double>("-0.0001e-400") == parse_error_t{0, underflow}));
+    assert((error_of<double>("10000e-404") == parse_error_t{0, underflow}));
+    assert((error_of<float>("1e-50") == parse_error_t{0, underflow}));
+    assert((error_of<float>("123.4e+40") == parse_error_t{0, overflow}));
+    assert((error_of<double>("0.001e312") == parse_error_t{0, overflow}));
+}
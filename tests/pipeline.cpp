@@ -0,0 +1,156 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kirho/pipeline.hpp>
+
+using parsed_t = kirho::result_t<std::int64_t, std::string>;
+
+auto main() -> int
+{
+    // The queue hands every item to exactly one of the threads popping.
+    {
+        auto queue = kirho::bounded_queue_t<int>{100};
+        assert(queue.capacity() == 128);
+
+        auto popped = std::atomic<std::int64_t>{0};
+        auto count = std::atomic<int>{0};
+        auto consumers = std::vector<std::thread>{};
+        for (auto t = 0; t < 3; t++)
+        {
+            consumers.emplace_back([&]() {
+                auto item = 0;
+                while (queue.pop(item))
+                {
+                    popped += item;
+                    count++;
+                }
+            });
+        }
+
+        auto producers = std::vector<std::thread>{};
+        for (auto t = 0; t < 3; t++)
+        {
+            producers.emplace_back([&queue]() {
+                for (auto i = 1; i <= 10000; i++)
+                {
+                    queue.push(i);
+                }
+            });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        queue.close();
+        for (auto& consumer : consumers)
+        {
+            consumer.join();
+        }
+
+        assert(count == 30000);
+        assert(popped == 3 * std::int64_t{10000} * 10001 / 2);
+    }
+
+    // A full queue doesn't take any more.
+    {
+        auto queue = kirho::bounded_queue_t<int>{2};
+        auto item = 1;
+        [[maybe_unused]] auto pushed =
+            queue.try_push(item) && queue.try_push(item);
+        assert(pushed);
+        pushed = queue.try_push(item);
+        assert(!pushed);
+        assert(queue.size() == 2);
+        [[maybe_unused]] auto taken =
+            queue.try_pop(item) && queue.try_pop(item);
+        assert(taken);
+        taken = queue.try_pop(item);
+        assert(!taken);
+    }
+
+    // Items go through every stage, and the ones that fail go to the error
+    // sink instead.
+    auto errors = std::vector<std::string>{};
+    auto errors_mutex = std::mutex{};
+    auto total = std::atomic<std::int64_t>{0};
+    auto sunk = std::atomic<int>{0};
+    const auto count = 100000;
+    auto metrics = std::vector<kirho::stage_metrics_t>{};
+    {
+        auto pipeline =
+            kirho::make_pipeline<std::string, std::string>(
+                [&](std::string error) {
+                    const auto lock = std::lock_guard{errors_mutex};
+                    errors.push_back(std::move(error));
+                },
+                256
+            )
+                .then(
+                    "parse",
+                    [](const std::string& text) {
+                        if (text.empty() || text[0] == '-')
+                        {
+                            return parsed_t::error("bad " + text);
+                        }
+                        return parsed_t::success(std::stoll(text));
+                    },
+                    {.threads = 2, .capacity = 256}
+                )
+                .then(
+                    "double",
+                    [](std::int64_t value) {
+                        return value % 1000 == 999
+                                   ? parsed_t::error(
+                                         "too big " + std::to_string(value)
+                                     )
+                                   : parsed_t::success(value * 2);
+                    },
+                    {.threads = 2, .capacity = 64}
+                )
+                .sink("sum", [&](std::int64_t value) {
+                    total += value;
+                    sunk++;
+                });
+
+        for (auto i = 0; i < count; i++)
+        {
+            pipeline->push(i % 5000 == 0 ? "-" : std::to_string(i));
+        }
+        pipeline->wait();
+        metrics = pipeline->metrics();
+    }
+
+    [[maybe_unused]] auto expected = std::int64_t{0};
+    [[maybe_unused]] auto expected_errors = std::size_t{0};
+    for (auto i = 0; i < count; i++)
+    {
+        if (i % 5000 == 0 || i % 1000 == 999)
+        {
+            expected_errors++;
+            continue;
+        }
+        expected += std::int64_t{i} * 2;
+    }
+    assert(total == expected);
+    assert(errors.size() == expected_errors);
+    assert(sunk == count - static_cast<int>(expected_errors));
+
+    // The metrics add up.
+    assert(metrics.size() == 3);
+    assert(metrics[0].name == "parse");
+    assert(metrics[0].processed + metrics[0].failed == count);
+    assert(metrics[0].failed == 20);
+    assert(metrics[1].processed == metrics[0].processed - 100);
+    assert(metrics[1].failed == 100);
+    assert(metrics[2].processed == metrics[1].processed);
+    for ([[maybe_unused]] const auto& stage : metrics)
+    {
+        assert(stage.queue_depth == 0);
+        assert(stage.throughput > 0.0);
+    }
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <kirho/rate_limiter.hpp>
+
+using namespace std::chrono_literals;
+
+auto main() -> int
+{
+    // The bucket starts out full, and then runs dry.
+    auto limiter = kirho::rate_limiter_t{100.0, 10};
+    assert(limiter.available() == 10);
+    for (auto i = 0; i < 10; i++)
+    {
+        limiter.try_acquire().unwrap();
+    }
+
+    // After which it says how long until there's another token, which is
+    // about a hundredth of a second.
+    [[maybe_unused]] auto error = kirho::rate_limited_t{};
+    [[maybe_unused]] auto limited = limiter.try_acquire().is_error(error);
+    assert(limited);
+    assert(error.retry_after > 0ms && error.retry_after <= 10ms);
+
+    // Tokens are taken all at once, or not at all.
+    std::this_thread::sleep_for(35ms);
+    assert(limiter.available() >= 3);
+    limited = limiter.try_acquire(20).is_error(error);
+    assert(limited);
+    limiter.try_acquire(3).unwrap();
+
+    // Asking for more than the bucket holds never works.
+    limited = limiter.try_acquire(11).is_error(error);
+    assert(limited);
+    assert(error.retry_after == kirho::rate_limited_t::duration_t::max());
+
+    // However many threads take tokens, they never get more than the bucket
+    // held to begin with plus what was added since.
+    const auto rate = 1000.0;
+    auto shared = kirho::rate_limiter_t{rate, 100};
+    auto admitted = std::atomic<std::uint64_t>{0};
+    auto local_admitted = std::atomic<std::uint64_t>{0};
+    auto peak = std::uint64_t{0};
+    auto threads = std::vector<std::thread>{};
+    const auto start = std::chrono::steady_clock::now();
+    threads.emplace_back([&]() {
+        while (std::chrono::steady_clock::now() < start + 50ms)
+        {
+            const auto available = shared.available();
+            peak = available > peak ? available : peak;
+        }
+    });
+    for (auto t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, t]() {
+            auto local = shared.local(8);
+            const auto end = start + 50ms;
+            while (std::chrono::steady_clock::now() < end)
+            {
+                if (t % 2 == 0)
+                {
+                    admitted += shared.try_acquire().to_optional() ? 1 : 0;
+                }
+                else
+                {
+                    local_admitted +=
+                        local.try_acquire().to_optional() ? 1 : 0;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    [[maybe_unused]] const auto seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+    [[maybe_unused]] const auto total = admitted + local_admitted;
+    assert(total >= 100);
+    assert(static_cast<double>(total) <= 100 + rate * seconds + 1);
+    assert(peak <= 100);
+
+    // Stashes hand out what they took from the bucket before going back.
+    auto batched = kirho::rate_limiter_t{1.0, 10};
+    auto local = batched.local(4);
+    local.try_acquire().unwrap();
+    assert(local.tokens() == 3);
+    assert(batched.available() == 6);
+    local.try_acquire(3).unwrap();
+    assert(local.tokens() == 0);
+
+    // When the bucket can't fill a whole batch, stashes settle for less.
+    local.try_acquire(5).unwrap();
+    assert(local.tokens() == 0);
+    local.try_acquire().unwrap();
+    assert(local.tokens() == 0);
+    limited = local.try_acquire().is_error(error);
+    assert(limited);
+}
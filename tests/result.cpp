@@ -18,7 +18,8 @@ auto get_number(int number) -> result_t<int, float>
 
 int main()
 {
-    const auto result = get_number(69).except("hello you suck bozo llll");
+    [[maybe_unused]] const auto result =
+        get_number(69).except("hello you suck bozo llll");
     assert(result == 420);
 
     return 0;
@@ -0,0 +1,200 @@
+#include <cassert>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <kirho/retry.hpp>
+
+using namespace std::chrono_literals;
+using result_t = kirho::result_t<int, std::string>;
+using policy_t = kirho::retry_policy_t<std::string>;
+using duration_t = policy_t::duration_t;
+
+// A coroutine that nobody waits on, to await the retries in.
+struct detached_t
+{
+    struct promise_type
+    {
+        auto get_return_object() noexcept -> detached_t
+        {
+            return {};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_never
+        {
+            return {};
+        }
+
+        auto return_void() noexcept -> void
+        {
+        }
+
+        auto unhandled_exception() noexcept -> void
+        {
+            std::terminate();
+        }
+    };
+};
+
+// Stands in for an event loop. The pauses don't take any real time, but the
+// coroutines stay suspended until the loop gets round to them, and it keeps
+// track of how long they asked to sleep for.
+struct fake_loop_t
+{
+    struct sleep_t
+    {
+        fake_loop_t& loop;
+
+        auto await_ready() const noexcept -> bool
+        {
+            return false;
+        }
+
+        auto await_suspend(std::coroutine_handle<> handle) -> void
+        {
+            loop.ready.push_back(handle);
+        }
+
+        auto await_resume() const noexcept -> void
+        {
+        }
+    };
+
+    auto sleep(duration_t delay) -> sleep_t
+    {
+        delays.push_back(delay);
+        return sleep_t{*this};
+    }
+
+    auto run() -> void
+    {
+        while (!ready.empty())
+        {
+            const auto handle = ready.front();
+            ready.erase(ready.begin());
+            handle.resume();
+        }
+    }
+
+    std::vector<std::coroutine_handle<>> ready;
+    std::vector<duration_t> delays;
+};
+
+auto flaky(int& attempts, int failures) -> result_t
+{
+    attempts++;
+    if (attempts <= failures)
+    {
+        return result_t::error("attempt " + std::to_string(attempts));
+    }
+
+    return result_t::success(attempts);
+}
+
+auto await_retry(
+    fake_loop_t& loop,
+    const policy_t& policy,
+    int& attempts,
+    int failures,
+    std::optional<result_t>& outcome
+) -> detached_t
+{
+    outcome.emplace(co_await kirho::async_retry(
+        policy,
+        [&attempts, failures]() { return flaky(attempts, failures); },
+        [&loop](duration_t delay) { return loop.sleep(delay); }
+    ));
+}
+
+auto main() -> int
+{
+    auto policy = policy_t{};
+    policy.base_delay = 1ms;
+    policy.max_delay = 4ms;
+
+    // Failures are retried until one of the attempts works.
+    auto attempts = 0;
+    auto outcome = kirho::retry(policy, [&]() { return flaky(attempts, 3); });
+    assert(outcome.unwrap() == 4);
+    assert(attempts == 4);
+
+    // But only so many times.
+    attempts = 0;
+    auto error = std::string{};
+    outcome = kirho::retry(policy, [&]() { return flaky(attempts, 10); });
+    assert(outcome.is_error(error) && error == "attempt 5");
+    assert(attempts == 5);
+
+    // Errors that aren't worth retrying are given up on right away.
+    attempts = 0;
+    auto picky = policy;
+    picky.retryable = [](const std::string& error) {
+        return error != "attempt 2";
+    };
+    outcome = kirho::retry(picky, [&]() { return flaky(attempts, 10); });
+    assert(outcome.is_error(error) && error == "attempt 2");
+    assert(attempts == 2);
+
+    // And so are attempts that would have to start after the deadline.
+    attempts = 0;
+    auto hurried = policy;
+    hurried.base_delay = 1h;
+    hurried.max_delay = 1h;
+    hurried.deadline = policy_t::clock_t::now() + 1min;
+    [[maybe_unused]] const auto start = policy_t::clock_t::now();
+    outcome = kirho::retry(hurried, [&]() { return flaky(attempts, 10); });
+    assert(outcome.is_error(error) && error == "attempt 1");
+    assert(policy_t::clock_t::now() - start < 1min);
+
+    // The coroutine version suspends instead of sleeping, and the pauses stay
+    // in between the base and the maximum delay, each at most three times the
+    // one before.
+    auto loop = fake_loop_t{};
+    auto patient = policy;
+    patient.max_attempts = 50;
+    patient.max_delay = 20ms;
+    auto pending = std::optional<result_t>{};
+    attempts = 0;
+    await_retry(loop, patient, attempts, 30, pending);
+    assert(!pending);
+    assert(attempts == 1);
+    loop.run();
+    assert(pending && pending->unwrap() == 31);
+    assert(loop.delays.size() == 30);
+
+    [[maybe_unused]] auto previous = patient.base_delay;
+    for (const auto delay : loop.delays)
+    {
+        assert(delay >= patient.base_delay && delay <= patient.max_delay);
+        assert(delay <= previous * 3);
+        previous = delay;
+    }
+
+    // Many coroutines can be retrying at once, without a thread each.
+    auto counts = std::vector<int>(1000, 0);
+    auto outcomes = std::vector<std::optional<result_t>>(1000);
+    loop.delays.clear();
+    for (auto i = 0; i < 1000; i++)
+    {
+        await_retry(loop, patient, counts[i], i % 4, outcomes[i]);
+    }
+    loop.run();
+    for (auto i = 0; i < 1000; i++)
+    {
+        assert(outcomes[i] && outcomes[i]->unwrap() == i % 4 + 1);
+    }
+
+    // Coroutines that succeed right away are never suspended at all.
+    auto immediate = std::optional<result_t>{};
+    attempts = 0;
+    await_retry(loop, patient, attempts, 0, immediate);
+    assert(immediate && immediate->unwrap() == 1);
+}
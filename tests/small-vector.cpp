@@ -0,0 +1,74 @@
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+
+#include <kirho/small_vector.hpp>
+
+auto main() -> int
+{
+    // The first few elements stay inside of the vector.
+    auto numbers = kirho::small_vector_t<int, 4>{};
+    assert(numbers.empty() && numbers.capacity() == 4);
+    for (auto i = 0; i < 4; i++)
+    {
+        numbers.push_back(i);
+    }
+    assert(numbers.is_inline() && numbers.size() == 4);
+
+    // And the rest go to the heap, along with the ones that were there.
+    numbers.push_back(4);
+    assert(!numbers.is_inline() && numbers.capacity() == 8);
+    for (auto i = 0; i < 5; i++)
+    {
+        assert(numbers[static_cast<std::size_t>(i)] == i);
+    }
+
+    // Adding an element that's already in the vector works even when it has
+    // to grow.
+    auto words = kirho::small_vector_t<std::string, 2>{"first", "second"};
+    words.push_back(words.front());
+    assert((words == kirho::small_vector_t<std::string, 2>{
+                         "first", "second", "first"
+                     }));
+
+    // Copies and moves, whether inline or not.
+    {
+        auto inline_words = kirho::small_vector_t<std::string, 2>{"a"};
+        auto copy = inline_words;
+        auto moved = std::move(inline_words);
+        assert(copy == moved && moved.size() == 1 && moved.is_inline());
+        assert(inline_words.empty());
+
+        [[maybe_unused]] const auto* data = words.data();
+        auto stolen = std::move(words);
+        assert(stolen.data() == data && stolen.size() == 3);
+        assert(words.empty() && words.is_inline());
+
+        words = stolen;
+        assert(words == stolen);
+        stolen = std::move(copy);
+        assert(stolen.size() == 1 && stolen.is_inline());
+    }
+
+    // Elements that can only be moved, and that own something, are cleaned
+    // up.
+    {
+        auto owned = kirho::small_vector_t<std::unique_ptr<int>, 1>{};
+        for (auto i = 0; i < 10; i++)
+        {
+            owned.emplace_back(std::make_unique<int>(i));
+        }
+        owned.pop_back();
+        assert(owned.size() == 9 && *owned.back() == 8);
+    }
+
+    // It's contiguous, so it can be viewed as a span.
+    const auto span = std::span<const int>{numbers.data(), numbers.size()};
+    assert(span.size() == 5 && span[4] == 4);
+
+    numbers.clear();
+    assert(numbers.empty() && numbers.capacity() == 8);
+}
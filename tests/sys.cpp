@@ -0,0 +1,48 @@
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <kirho/sys.hpp>
+
+namespace sys = kirho::sys;
+
+auto main() -> int
+{
+    static_assert(
+        sizeof(kirho::result_t<std::size_t, kirho::sys_error_t>) <=
+        2 * sizeof(std::size_t)
+    );
+
+    char path[] = "/tmp/kirho-sys-XXXXXX";
+    auto file = sys::fd_t{mkstemp(path)};
+    assert(file.is_open());
+    defer(path, unlink(path));
+
+    const auto message = std::array<char, 5>{'k', 'i', 'r', 'h', 'o'};
+    [[maybe_unused]] const auto written =
+        sys::pwrite(file, std::as_bytes(std::span{message}), 3).unwrap();
+    assert(written == message.size());
+    sys::fsync(file).except("fsync failed");
+
+    auto buffer = std::array<std::byte, 16>{};
+    [[maybe_unused]] const auto count = sys::pread(file, buffer, 3).unwrap();
+    assert(count == message.size());
+    assert(std::memcmp(buffer.data(), message.data(), count) == 0);
+
+    sys::close(file).except("close failed");
+    assert(!file.is_open());
+
+    [[maybe_unused]] auto error = kirho::sys_error_t{};
+    assert(sys::read(file, buffer).is_error(error));
+    assert(error.code == EBADF);
+
+    assert(sys::open("/this/does/not/exist", O_RDONLY).is_error(error));
+    assert(error.code == ENOENT);
+
+    auto reopened = sys::open(path, O_RDONLY).unwrap();
+    assert(sys::read(reopened, buffer).unwrap() == 3 + message.size());
+}
@@ -0,0 +1,205 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kirho/task.hpp>
+
+using number_t = kirho::task_t<int, std::string>;
+using result_t = kirho::result_t<int, std::string>;
+
+auto square(int value) -> number_t
+{
+    if (value < 0)
+    {
+        co_return result_t::error("negative");
+    }
+
+    co_return result_t::success(value * value);
+}
+
+auto sum_of_squares(int count) -> number_t
+{
+    auto sum = 0;
+    for (auto i = 0; i < count; i++)
+    {
+        auto error = std::string{};
+        const auto outcome = co_await square(i);
+        if (outcome.is_error(error))
+        {
+            co_return result_t::error(error);
+        }
+
+        sum += outcome.unwrap();
+    }
+
+    co_return result_t::success(sum);
+}
+
+auto one() -> number_t
+{
+    co_return result_t::success(1);
+}
+
+auto count_up(int count) -> number_t
+{
+    auto sum = 0;
+    for (auto i = 0; i < count; i++)
+    {
+        sum += (co_await one()).unwrap();
+    }
+
+    co_return result_t::success(sum);
+}
+
+auto on_pool(kirho::thread_pool_t& pool, std::thread::id& thread) -> number_t
+{
+    co_await kirho::schedule(pool);
+    thread = std::this_thread::get_id();
+    co_return result_t::success(1);
+}
+
+auto throwing() -> number_t
+{
+    throw std::runtime_error{"broken"};
+    co_return result_t::success(0);
+}
+
+auto napping(int value, std::chrono::milliseconds nap, std::atomic<int>& ran)
+    -> number_t
+{
+    ran++;
+    std::this_thread::sleep_for(nap);
+    if (value < 0)
+    {
+        co_return result_t::error("failed " + std::to_string(value));
+    }
+
+    co_return result_t::success(value);
+}
+
+auto main() -> int
+{
+    // Tasks are awaited like functions are called, and hand back results.
+    {
+        [[maybe_unused]] const auto squared =
+            kirho::sync_wait(square(7)).unwrap();
+        assert(squared == 49);
+
+        auto error = std::string{};
+        [[maybe_unused]] const auto failed =
+            kirho::sync_wait(square(-1)).is_error(error);
+        assert(failed && error == "negative");
+    }
+
+    // Awaiting a task that finishes right away doesn't grow the stack, no
+    // matter how many of them there are in a row, at least with optimizations
+    // on. Without them, GCC makes the jumps into plain calls, so this keeps
+    // to a count that fits on the stack either way.
+    [[maybe_unused]] const auto sum =
+        kirho::sync_wait(sum_of_squares(1000)).unwrap();
+    assert(sum == 332833500);
+    [[maybe_unused]] const auto count =
+        kirho::sync_wait(count_up(1000)).unwrap();
+    assert(count == 1000);
+
+    // Some of the tasks are left running on the pool after their block is
+    // done with them, so what they count into has to outlive it.
+    auto ran = std::atomic<int>{0};
+    auto pool = kirho::thread_pool_t{4};
+
+    // Scheduling moves the task over to the pool.
+    {
+        [[maybe_unused]] auto thread = std::this_thread::get_id();
+        [[maybe_unused]] const auto value =
+            kirho::sync_wait(on_pool(pool, thread)).unwrap();
+        assert(value == 1);
+        assert(thread != std::this_thread::get_id());
+    }
+
+    // Exceptions still come out of the co_await.
+    {
+        [[maybe_unused]] auto threw = false;
+        try
+        {
+            kirho::sync_wait(throwing());
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // when_all gives every value, in order.
+    {
+        ran = 0;
+        auto tasks = std::vector<number_t>{};
+        for (auto i = 0; i < 64; i++)
+        {
+            tasks.push_back(napping(i, std::chrono::milliseconds{0}, ran));
+        }
+
+        const auto values =
+            kirho::sync_wait(kirho::when_all(pool, std::move(tasks)))
+                .unwrap();
+        assert(values.size() == 64);
+        for (auto i = 0; i < 64; i++)
+        {
+            assert(values[static_cast<std::size_t>(i)] == i);
+        }
+        assert(ran == 64);
+    }
+
+    // Or the first error, without waiting for the rest, or even starting
+    // them.
+    {
+        ran = 0;
+        auto tasks = std::vector<number_t>{};
+        tasks.push_back(napping(-1, std::chrono::milliseconds{0}, ran));
+        for (auto i = 0; i < 15; i++)
+        {
+            tasks.push_back(napping(i, std::chrono::milliseconds{20}, ran));
+        }
+
+        auto error = std::string{};
+        [[maybe_unused]] const auto outcome =
+            kirho::sync_wait(kirho::when_all(pool, std::move(tasks)));
+        assert(outcome.is_error(error));
+        assert(error == "failed -1");
+
+        // The ones that were already running finish in the background.
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        assert(ran < 16);
+    }
+
+    // when_any gives the first one to finish.
+    {
+        auto tasks = std::vector<number_t>{};
+        tasks.push_back(napping(0, std::chrono::milliseconds{200}, ran));
+        tasks.push_back(napping(1, std::chrono::milliseconds{0}, ran));
+
+        [[maybe_unused]] const auto [index, value] =
+            kirho::sync_wait(kirho::when_any(pool, std::move(tasks)))
+                .unwrap();
+        assert(index == 1 && value == 1);
+    }
+
+    // Even if it fails.
+    {
+        auto tasks = std::vector<number_t>{};
+        tasks.push_back(napping(0, std::chrono::milliseconds{200}, ran));
+        tasks.push_back(napping(-1, std::chrono::milliseconds{0}, ran));
+
+        auto error = std::string{};
+        [[maybe_unused]] const auto failed =
+            kirho::sync_wait(kirho::when_any(pool, std::move(tasks)))
+                .is_error(error);
+        assert(failed && error == "failed -1");
+    }
+}
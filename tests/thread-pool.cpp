@@ -0,0 +1,31 @@
+#include <atomic>
+#include <cassert>
+#include <future>
+#include <vector>
+
+#include <kirho/thread_pool.hpp>
+
+auto main() -> int
+{
+    auto counter = std::atomic<int>{0};
+    auto futures = std::vector<std::future<int>>{};
+
+    {
+        auto pool = kirho::thread_pool_t{4};
+        assert(pool.thread_count() == 4);
+
+        for (auto i = 0; i < 1000; i++)
+        {
+            futures.push_back(pool.submit([i]() { return i * 2; }));
+            pool.post([&counter]() { counter++; });
+        }
+
+        for (auto i = 0; i < 1000; i++)
+        {
+            assert(futures[static_cast<std::size_t>(i)].get() == i * 2);
+        }
+    }
+
+    // The destructor has to finish everything that was posted.
+    assert(counter == 1000);
+}
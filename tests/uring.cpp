@@ -0,0 +1,88 @@
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include <unistd.h>
+
+#include <kirho/uring.hpp>
+
+using kirho::uring_t;
+namespace sys = kirho::sys;
+
+constexpr auto block_size = std::size_t{512};
+constexpr auto block_count = 600;
+
+auto exercise(uring_t ring, const sys::fd_t& file) -> void
+{
+    // Write a whole bunch of blocks, more than fit into the queue at once, so
+    // that it has to submit along the way.
+    auto blocks = std::vector<std::array<std::byte, block_size>>(block_count);
+    auto writes = std::vector<uring_t::future_t>{};
+    for (auto i = 0; i < block_count; i++)
+    {
+        auto& block = blocks[static_cast<std::size_t>(i)];
+        block.fill(static_cast<std::byte>(i));
+        writes.push_back(ring.pwrite(file, block, i * off_t{block_size}));
+    }
+    ring.submit().except("failed to submit the writes");
+
+    for (auto& write : writes)
+    {
+        [[maybe_unused]] const auto written = write.get().unwrap();
+        assert(written == block_size);
+    }
+
+    auto reads = std::vector<std::array<std::byte, block_size>>(block_count);
+    auto futures = std::vector<uring_t::future_t>{};
+    for (auto i = 0; i < block_count; i++)
+    {
+        futures.push_back(ring.pread(
+            file, reads[static_cast<std::size_t>(i)], i * off_t{block_size}
+        ));
+    }
+    ring.submit().except("failed to submit the reads");
+
+    for (auto i = 0; i < block_count; i++)
+    {
+        const auto index = static_cast<std::size_t>(i);
+        [[maybe_unused]] const auto read = futures[index].get().unwrap();
+        assert(read == block_size);
+        assert(reads[index] == blocks[index]);
+    }
+
+    // Errors come back through the result, and don't break anything else.
+    auto buffer = std::array<std::byte, 16>{};
+    auto closed = sys::fd_t{};
+    auto failed = ring.pread(closed, buffer, 0);
+    ring.submit().unwrap();
+
+    [[maybe_unused]] auto error = kirho::sys_error_t{};
+    [[maybe_unused]] const auto outcome = failed.get();
+    assert(outcome.is_error(error));
+    assert(error.code == EBADF);
+}
+
+auto main() -> int
+{
+    char path[] = "/tmp/kirho-uring-XXXXXX";
+    const auto file = sys::fd_t{mkstemp(path)};
+    assert(file.is_open());
+    defer(path, unlink(path));
+
+    [[maybe_unused]] auto error = kirho::sys_error_t{};
+    auto pool = uring_t::create(64, uring_t::backend_t::thread_pool, 4)
+                    .except("failed to create the thread pool backend");
+    assert(pool.backend() == uring_t::backend_t::thread_pool);
+    exercise(std::move(pool), file);
+
+    // The kernel might not let us have io_uring, in which case we should get
+    // the thread pool anyway.
+    auto automatic = uring_t::create(64).except("failed to create a backend");
+    [[maybe_unused]] const auto has_io_uring =
+        automatic.backend() == uring_t::backend_t::io_uring;
+    exercise(std::move(automatic), file);
+
+    auto ring = uring_t::create(64, uring_t::backend_t::io_uring);
+    assert(ring.is_error(error) != has_io_uring);
+}
@@ -0,0 +1,113 @@
+#include <cassert>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <kirho/utf8.hpp>
+
+using kirho::utf8_error_t;
+using kind_t = kirho::utf8_error_t::kind_t;
+
+auto error_of(std::string_view text) -> utf8_error_t
+{
+    auto error = utf8_error_t{};
+    [[maybe_unused]] const auto failed =
+        kirho::validate_utf8(text).is_error(error);
+    assert(failed);
+    return error;
+}
+
+auto scalar(const std::string& text) -> std::pair<bool, utf8_error_t>
+{
+    auto error = utf8_error_t{};
+    const auto data = reinterpret_cast<const unsigned char*>(text.data());
+    const auto failed =
+        kirho::detail::validate_utf8_scalar(data, text.size(), 0)
+            .is_error(error);
+    return {failed, error};
+}
+
+auto with(kirho::detail::utf8_kernel_t kernel, const std::string& text)
+    -> std::pair<bool, utf8_error_t>
+{
+    auto error = utf8_error_t{};
+    const auto data = reinterpret_cast<const unsigned char*>(text.data());
+    const auto failed =
+        kirho::detail::validate_utf8_with(kernel, data, text.size())
+            .is_error(error);
+    return {failed, error};
+}
+
+auto main() -> int
+{
+    kirho::validate_utf8(u8"").unwrap();
+    kirho::validate_utf8(u8"plain old ASCII").unwrap();
+    kirho::validate_utf8(u8"héllo wörld € \U0001F600").unwrap();
+    kirho::validate_utf8(std::string_view{"\xF4\x8F\xBF\xBF"}).unwrap();
+
+    assert(
+        (error_of("abc\x80") ==
+         utf8_error_t{3, kind_t::unexpected_continuation})
+    );
+    assert((error_of("a\xC0\x80") == utf8_error_t{1, kind_t::overlong}));
+    assert((error_of("ab\xE0\x80\x80") == utf8_error_t{2, kind_t::overlong}));
+    assert((error_of("\xF0\x80\x80\x80") == utf8_error_t{0, kind_t::overlong}));
+    assert((error_of("\xED\xA0\x80") == utf8_error_t{0, kind_t::surrogate}));
+    assert(
+        (error_of("\xF4\x90\x80\x80") == utf8_error_t{0, kind_t::too_large})
+    );
+    assert((error_of("\xF8") == utf8_error_t{0, kind_t::invalid_byte}));
+    assert((error_of("x\xE2\x82") == utf8_error_t{1, kind_t::truncated}));
+    assert((error_of("\xE2\x82x") == utf8_error_t{0, kind_t::truncated}));
+
+    // Every kernel has to agree with the scalar code, no matter where in the
+    // blocks the errors end up.
+    auto kernels = std::vector<kirho::detail::utf8_kernel_t>{
+        kirho::detail::select_utf8_kernel()
+    };
+#if KIRHO_X86_SIMD
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        kernels.push_back(kirho::detail::validate_utf8_ssse3);
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels.push_back(kirho::detail::validate_utf8_avx2);
+    }
+#endif
+
+    const auto pieces = std::vector<std::string>{
+        "a", "z", "é", "߿", "ࠀ", "€", "￿",
+        "\U00010000", "\U0010FFFF", "\U0001F600"
+    };
+
+    auto random = std::mt19937{42};
+    for (auto round = 0; round < 20000; round++)
+    {
+        auto text = std::string{};
+        const auto count = random() % 40;
+        for (auto i = 0u; i < count; i++)
+        {
+            text += pieces[random() % pieces.size()];
+        }
+
+        if (!text.empty() && random() % 2 == 0)
+        {
+            text[random() % text.size()] = static_cast<char>(random());
+        }
+        if (!text.empty() && random() % 4 == 0)
+        {
+            text.pop_back();
+        }
+
+        [[maybe_unused]] const auto expected = scalar(text);
+        for (const auto kernel : kernels)
+        {
+            [[maybe_unused]] const auto actual = with(kernel, text);
+            assert(actual.first == expected.first);
+            assert(!actual.first || actual.second == expected.second);
+        }
+    }
+}
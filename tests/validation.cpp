@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include <kirho/validation.hpp>
+
+struct field_error_t
+{
+    std::string field;
+    std::string reason;
+
+    auto operator==(const field_error_t&) const noexcept -> bool = default;
+};
+
+using name_t = kirho::result_t<std::string, field_error_t>;
+using age_t = kirho::result_t<int, field_error_t>;
+using email_t = kirho::validation_t<std::string, field_error_t>;
+
+auto check_name(std::string_view name) -> name_t
+{
+    if (name.empty())
+    {
+        return name_t::error({"name", "empty"});
+    }
+
+    return name_t::success(std::string{name});
+}
+
+auto check_age(int age) -> age_t
+{
+    if (age < 0 || age > 150)
+    {
+        return age_t::error({"age", "out of range"});
+    }
+
+    return age_t::success(age);
+}
+
+// A check that can find more than one thing wrong by itself.
+auto check_email(std::string_view email) -> email_t
+{
+    auto errors = email_t::errors_t{};
+    if (email.find('@') == std::string_view::npos)
+    {
+        errors.push_back({"email", "no @"});
+    }
+    if (email.size() > 32)
+    {
+        errors.push_back({"email", "too long"});
+    }
+
+    if (!errors.empty())
+    {
+        return email_t::failure(std::move(errors));
+    }
+
+    return email_t::success(std::string{email});
+}
+
+auto main() -> int
+{
+    // Everything is valid, so the values come out together.
+    {
+        auto checked = kirho::validate(
+            check_name("ada"), check_age(36), check_email("ada@example.com")
+        );
+        assert(checked.is_valid() && checked.errors().empty());
+
+        [[maybe_unused]] const auto [name, age, email] =
+            std::move(checked).unwrap();
+        assert(name == "ada" && age == 36 && email == "ada@example.com");
+    }
+
+    // Every error is kept, in order, not just the first one.
+    {
+        const auto checked = kirho::validate(
+            check_name(""),
+            check_age(200),
+            check_email("not an email address, and a long one at that")
+        );
+        assert(!checked.is_valid());
+
+        const auto errors = checked.errors();
+        assert(errors.size() == 4);
+        assert((errors[0] == field_error_t{"name", "empty"}));
+        assert((errors[1] == field_error_t{"age", "out of range"}));
+        assert((errors[2] == field_error_t{"email", "no @"}));
+        assert((errors[3] == field_error_t{"email", "too long"}));
+    }
+
+    // The errors stay inline up to the limit, and spill over after it.
+    {
+        auto few = kirho::validate<2>(check_name(""), check_age(-1))
+                       .to_result();
+        auto errors = kirho::small_vector_t<field_error_t, 2>{};
+        [[maybe_unused]] const auto failed = few.is_error(errors);
+        assert(failed && errors.size() == 2 && errors.is_inline());
+
+        const auto many = kirho::validate<1>(
+            check_name(""), check_age(-1), check_age(151)
+        );
+        assert(many.errors().size() == 3);
+    }
+
+    // Results can be turned into validations, and validations back into
+    // results.
+    {
+        [[maybe_unused]] auto age = 0;
+        [[maybe_unused]] const auto converted =
+            kirho::validation_t<int, field_error_t>::from(check_age(5))
+                .is_success(age);
+        assert(converted && age == 5);
+
+        const auto invalid =
+            kirho::validation_t<int, field_error_t>::from(check_age(-5));
+        assert(invalid.errors().size() == 1);
+    }
+}